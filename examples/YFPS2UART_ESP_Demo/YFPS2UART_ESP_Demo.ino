@@ -56,6 +56,9 @@ void setup() {
 
 void loop() {
 
+  // 更新读取手柄数据（连接状态也由 update() 解析得到，每次 loop 都要调用）
+  ps2uart.update();
+
   // 若手柄未连接状态，定期提示
   if (!ps2uart.isRemoteConnected()) {
     static unsigned long lastTime = 0;
@@ -74,9 +77,6 @@ void loop() {
     }
   }
 
-  // 更新读取手柄数据
-  ps2uart.update();
-
   // 获取按键原始值(去抖)
   // unsigned int buttons = ps2uart.getButtons();
 
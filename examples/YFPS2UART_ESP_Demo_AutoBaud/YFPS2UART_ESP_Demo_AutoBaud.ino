@@ -0,0 +1,49 @@
+/*
+ * YFPS2UART_ESP_Demo_AutoBaud.ino
+ * 演示 ESP32主板情况下自动识别模块波特率，并把模块与本地串口一起切换到支持的最高波特率：
+ * autoBaud() 依次尝试 9600, 115200, 57600, 38400, 19200，以能否解出连续好帧（或 AT+BAUD? 的响应）判断同步；
+ * upgrade = true 时再发送 AT+BAUD=（必要时 AT+RST）并在新波特率下验证，失败会恢复原设置。
+ * 无需再手动断电重启、修改程序里的波特率重新上传。
+ * 
+ * 9600 波特率下一帧（8 字节）在线上约需 8.3ms，提高波特率可以降低输入延迟。
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+
+// ESP32 引脚配置
+YFPS2UART ps2uart(16, 17);  // RX, TX (根据硬件调整) 默认使用 Serial2
+
+void setup() {
+  Serial.begin(115200);
+  delay(50);
+  Serial.println();
+  Serial.println(F("自动波特率演示"));
+
+  delay(2000);   // 等待接收器模块上电初始化完成
+
+  PS2BaudReport report;
+  uint32_t baud = ps2uart.autoBaud(true, &report);   // 升级上限默认 115200
+  if (baud == 0) {
+    Serial.println(F("未找到模块！检查接线与供电"));
+    return;
+  }
+  Serial.print(F("探测到模块波特率: "));
+  Serial.print(report.detectedBaud);
+  Serial.println(report.viaAT ? F("（通过 AT+BAUD? 确认）") : F("（通过帧同步确认）"));
+  Serial.print(F("当前波特率: "));
+  Serial.println(report.finalBaud);
+  Serial.print(F("帧率: "));
+  Serial.print(report.fpsBefore);
+  Serial.print(F(" -> "));
+  Serial.print(report.fpsAfter);
+  Serial.println(F(" 帧/秒"));
+}
+
+void loop() {
+  ps2uart.update();
+  if (ps2uart.ButtonPressed(PSB_CROSS)) {
+    Serial.println(F("X pressed"));
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * YFPS2UART_ESP_Demo_Capture.ino
+ * 演示 ESP32主板情况下录制手柄数据，用于复现现场问题（漏按、摇杆卡住等）：
+ * 解出的帧（带微秒时间戳、只记录变化的字节）写入 32KB 的 RAM 环，满了覆盖最旧的数据，
+ * 即始终保留最近约 8000 帧（9600 波特率下约 1 分钟）。
+ *
+ * 出现问题时按 SELECT 插入标记；同时按 SELECT + START 把录制内容以十六进制导出到串口监视器，之后重新开始录制。
+ * 在电脑上把导出的十六进制行保存为 dump.txt，转换并回放分析：
+ *   xxd -r -p dump.txt capture.bin
+ *   make -C extras/host replay CAPTURE=capture.bin ARGS="-t"
+ *
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+
+// ESP32 引脚配置
+YFPS2UART ps2uart(16, 17);  // RX, TX (根据硬件调整) 默认使用 Serial2
+
+static uint8_t captureBuf[512 * YFPS2UART_CAPTURE_BLOCK];   // 32KB
+PS2Capture capture(captureBuf, sizeof(captureBuf));
+
+void dumpCapture() {
+  ps2uart.setCapture(nullptr);
+  capture.finish();
+  Serial.println(F("---- capture begin ----"));
+  for (uint16_t i = 0; i < capture.blockCount(); ++i) {
+    const uint8_t* b = capture.block(i);
+    char hex[3];
+    for (uint16_t k = 0; k < PS2Capture::kBlockSize; ++k) {
+      snprintf(hex, sizeof(hex), "%02x", b[k]);
+      Serial.print(hex);
+    }
+    Serial.println();
+  }
+  Serial.println(F("---- capture end ----"));
+  Serial.print(F("覆盖的块: "));
+  Serial.println(capture.overwrittenBlocks());
+  capture.clear();
+  ps2uart.setCapture(&capture, PS2_CAPTURE_FRAMES);
+}
+
+void setup() {
+  Serial.begin(115200);
+  ps2uart.begin(9600);
+  delay(50);
+  Serial.println();
+  Serial.println(F("录制演示：SELECT 插入标记，SELECT + START 导出"));
+  ps2uart.setCapture(&capture, PS2_CAPTURE_FRAMES);
+}
+
+void loop() {
+  ps2uart.update();
+  if (ps2uart.ButtonPressed(PSB_START) && ps2uart.Button(PSB_SELECT)) {
+    dumpCapture();
+  } else if (ps2uart.ButtonPressed(PSB_SELECT)) {
+    capture.mark();
+    Serial.println(F("标记"));
+  }
+}
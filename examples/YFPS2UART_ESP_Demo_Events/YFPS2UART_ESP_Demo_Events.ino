@@ -0,0 +1,83 @@
+/*
+ * YFPS2UART_ESP_Demo_Events.ino
+ * 演示 ESP32主板情况下，用按键事件队列读取手柄输入：
+ * 每次 loop() 调用一次 update()，再用 pollEvent() 取完所有事件（按下、释放、长按、连发、双击），
+ * 无需对 16 个按键逐个调用 ButtonPressed()/ButtonReleased()。
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+
+// ESP32 引脚配置
+YFPS2UART ps2uart(16, 17);  // RX, TX (根据硬件调整) 默认使用 Serial2
+
+// 按键名称，按位序排列（bit0 = SELECT ... bit15 = SQUARE）
+static const char* const kButtonNames[16] = {
+  "SELECT", "L3", "R3", "START", "UP", "RIGHT", "DOWN", "LEFT",
+  "L2", "R2", "L1", "R1", "TRIANGLE", "CIRCLE", "CROSS", "SQUARE"
+};
+
+static const char* buttonName(uint16_t mask) {
+  return kButtonNames[__builtin_ctz(mask)];
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(50);
+  Serial.println();
+  Serial.println(F("YFPS2UART 按键事件演示"));
+  Serial.println(F("====================================="));
+  Serial.println(F("按住任意键 800ms 触发长按，方向键按住可连发，快速按两次触发双击"));
+  Serial.println(F("====================================="));
+
+  ps2uart.setDebounceMs(10);           // 去抖时间
+  ps2uart.setLongPressMs(800);         // 长按阈值
+  ps2uart.setAutoRepeat(400, 100);     // 按住 400ms 后每 100ms 连发一次
+  ps2uart.setDoubleTapMs(300);         // 双击间隔
+  ps2uart.begin(9600);                 // 必须与模块波特保持一致，否则无法通讯
+}
+
+void loop() {
+  // 更新读取手柄数据
+  ps2uart.update();
+
+  // 取完本轮所有事件
+  PS2Event ev;
+  while (ps2uart.pollEvent(ev)) {
+    switch (ev.type) {
+      case PS2_EVENT_PRESS:
+        Serial.print(F("按下 "));
+        break;
+      case PS2_EVENT_RELEASE:
+        Serial.print(F("释放 "));
+        break;
+      case PS2_EVENT_LONG_PRESS:
+        Serial.print(F("长按 "));
+        break;
+      case PS2_EVENT_REPEAT:
+        // 只让方向键连发
+        if ((ev.button & (PSB_PAD_UP | PSB_PAD_RIGHT | PSB_PAD_DOWN | PSB_PAD_LEFT)) == 0) continue;
+        Serial.print(F("连发 #"));
+        Serial.print(ev.count);
+        Serial.print(' ');
+        break;
+      case PS2_EVENT_DOUBLE_TAP:
+        Serial.print(F("双击 "));
+        if (ev.button == PSB_CROSS) ps2uart.sendVibrate(VIBRATE_BOTH);
+        break;
+    }
+    Serial.print(buttonName(ev.button));
+    Serial.print(F(" @"));
+    Serial.println(ev.timeMs);
+  }
+
+  // 队列容量不足时会丢弃事件，可增大 YFPS2UART_EVENT_QUEUE_SIZE 或更频繁地调用 loop()
+  static uint16_t lastOverflows = 0;
+  if (ps2uart.getEventOverflows() != lastOverflows) {
+    lastOverflows = ps2uart.getEventOverflows();
+    Serial.print(F("事件溢出: "));
+    Serial.println(lastOverflows);
+  }
+  delay(20);
+}
@@ -0,0 +1,62 @@
+/*
+ * YFPS2UART_ESP_Demo_Multi.ino
+ * 演示 ESP32主板情况下，用 YFPS2UARTMulti 同时读取两个接收器（例如驾驶员 + 操作员）：
+ * 每次 loop() 调用一次 poll()，在 64 字节 / 500us 的预算内轮流服务两个接收器，
+ * 再从连续的状态数组中读取两个手柄的按键与摇杆；每秒打印一次各接收器的帧率与调度统计。
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+#include <YFPS2UARTMulti.h>
+
+YFPS2UARTMulti<2> pads;
+
+static uint32_t lastReport = 0;
+
+void setup() {
+  Serial.begin(115200);
+  delay(50);
+  Serial.println();
+  Serial.println(F("YFPS2UART 多接收器演示"));
+
+  pads.add(16, 17, &Serial2);   // 接收器 0：RX 16, TX 17 (根据硬件调整)
+  pads.add(25, 26, &Serial1);   // 接收器 1：RX 25, TX 26 (根据硬件调整)
+  for (uint8_t i = 0; i < pads.size(); ++i) {
+    pads[i].setDebounceMs(10);
+  }
+  pads.begin(9600);             // 必须与模块波特保持一致，否则无法通讯
+}
+
+void loop() {
+  pads.poll(64, 500);
+
+  const PS2State* s = pads.states();
+  for (uint8_t i = 0; i < pads.size(); ++i) {
+    if (s[i].button(PSB_CROSS)) {
+      Serial.print(F("Pad "));
+      Serial.print(i);
+      Serial.println(F(": X pressed"));
+    }
+  }
+
+  if (millis() - lastReport >= 1000) {
+    lastReport = millis();
+    for (uint8_t i = 0; i < pads.size(); ++i) {
+      PS2ReceiverStats st;
+      pads.getStats(i, st);
+      Serial.print(F("Pad "));
+      Serial.print(i);
+      Serial.print(F(": LY="));
+      Serial.print(s[i].analog(PSS_LY));
+      Serial.print(F(" frames="));
+      Serial.print(st.frames);
+      Serial.print(F(" rate="));
+      Serial.print(st.frameRateHz);
+      Serial.print(F("Hz maxGap="));
+      Serial.print(st.maxGapMs);
+      Serial.print(F("ms starved="));
+      Serial.println(st.starvedPolls);
+    }
+  }
+}
@@ -0,0 +1,61 @@
+/*
+  YFPS2UART_UNO_HW_Demo_Vibrate
+  使用 UNO 硬件串口，演示非阻塞震动：
+  - queueVibrate() 只把请求放入队列，由 update() 限速发送（模块每条指令震动约 0.5 秒），
+    不会像 sendVibrate() 那样清空接收缓冲并等待发送完成，控制循环不会卡顿；
+  - 按住按键时每次循环都请求震动也没关系：重复请求会被合并；
+  - playVibratePattern() 播放震动序列，同样由 update() 推进，不使用 delay()。
+ * 
+ * 按键：
+ * - 按住 L1/R1：左/右马达持续震动
+ * - X：播放序列“左、停 200ms、右、双”
+ * - O：循环播放心跳序列，再按一次停止
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+#include <Servo.h>
+
+YFPS2UART ps2uart(SERIALTYPE_HW);
+Servo myServo;
+
+static const PS2VibeStep kLeftRightBoth[] = {
+  {VIBRATE_LEFT, 0}, {0, 200}, {VIBRATE_RIGHT, 0}, {VIBRATE_BOTH, 0}
+};
+static const PS2VibeStep kHeartbeat[] = {
+  {VIBRATE_BOTH, 0}, {VIBRATE_BOTH, 0}, {0, 800}
+};
+
+void setup() {
+  ps2uart.setDebounceMs(10);
+  ps2uart.begin(9600);
+  myServo.attach(3);
+  myServo.write(90);
+}
+
+void loop() {
+  ps2uart.update();
+
+  int stickX = ps2uart.Analog(PSS_LX);
+  myServo.write(map(stickX, 0, 255, 0, 180));
+
+  if (ps2uart.Button(PSB_L1)) {
+    ps2uart.queueVibrate(VIBRATE_LEFT);
+  }
+  if (ps2uart.Button(PSB_R1)) {
+    ps2uart.queueVibrate(VIBRATE_RIGHT);
+  }
+
+  if (ps2uart.ButtonPressed(PSB_CROSS)) {
+    ps2uart.playVibratePattern(kLeftRightBoth, sizeof(kLeftRightBoth) / sizeof(kLeftRightBoth[0]));
+  }
+
+  if (ps2uart.ButtonPressed(PSB_CIRCLE)) {
+    if (ps2uart.isVibratePatternPlaying()) {
+      ps2uart.stopVibratePattern();
+    } else {
+      ps2uart.playVibratePattern(kHeartbeat, sizeof(kHeartbeat) / sizeof(kHeartbeat[0]), true);
+    }
+  }
+}
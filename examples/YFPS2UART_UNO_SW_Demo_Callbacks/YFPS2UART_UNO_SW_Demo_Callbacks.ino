@@ -0,0 +1,84 @@
+/*
+ * YFPS2UART_UNO_SW_Demo_Callbacks.ino
+ * 演示用按键回调代替逐个调用 ButtonPressed()/ButtonReleased()：
+ * 在 setup() 中用 onPress()/onRelease() 为按键注册回调，loop() 中只需调用 update()，
+ * 只有状态发生变化的按键才会触发回调。
+ * 
+ * 串口方案：使用 SoftwareSerial（默认方案）
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+
+// Arduino UNO R3 软串口引脚配置
+YFPS2UART ps2uart(SERIALTYPE_SW, 11, 10); // RX TX (根据硬件调整)
+
+// 十字键按下：打印方向
+static void onPad(const PS2Event& ev, void* ctx) {
+  (void)ctx;
+  switch (ev.button) {
+    case PSB_PAD_UP:    Serial.println(F("Up pressed"));    break;
+    case PSB_PAD_RIGHT: Serial.println(F("Right pressed")); break;
+    case PSB_PAD_DOWN:  Serial.println(F("Down pressed"));  break;
+    case PSB_PAD_LEFT:  Serial.println(F("Left pressed"));  break;
+  }
+}
+
+// X / O / 方形键按下：触发不同震动模式，ctx 为震动命令
+static void onVibrateKey(const PS2Event& ev, void* ctx) {
+  (void)ev;
+  ps2uart.sendVibrate((uint8_t)(uintptr_t)ctx);
+  Serial.println(F("Vibrate"));
+}
+
+// 三角键释放
+static void onTriangleReleased(const PS2Event& ev, void* ctx) {
+  (void)ctx;
+  Serial.print(F("Triangle just released @"));
+  Serial.println(ev.timeMs);
+}
+
+// L1/R1 按下与释放：控制是否打印摇杆值，ctx 指向标志变量
+static void onShoulder(const PS2Event& ev, void* ctx) {
+  *(bool*)ctx = (ev.type == PS2_EVENT_PRESS);
+}
+
+static bool printSticks = false;
+
+void setup() {
+  Serial.begin(115200);
+  delay(50);
+  Serial.println();
+  Serial.println(F("YFPS2UART 按键回调演示"));
+  Serial.println(F("====================================="));
+
+  ps2uart.onPress(PSB_PAD_UP | PSB_PAD_RIGHT | PSB_PAD_DOWN | PSB_PAD_LEFT, onPad);
+  ps2uart.onPress(PSB_CROSS, onVibrateKey, (void*)(uintptr_t)VIBRATE_BOTH);
+  ps2uart.onPress(PSB_CIRCLE, onVibrateKey, (void*)(uintptr_t)VIBRATE_LEFT);
+  ps2uart.onPress(PSB_SQUARE, onVibrateKey, (void*)(uintptr_t)VIBRATE_RIGHT);
+  ps2uart.onRelease(PSB_TRIANGLE, onTriangleReleased);
+  ps2uart.onPress(PSB_L1 | PSB_R1, onShoulder, &printSticks);
+  ps2uart.onRelease(PSB_L1 | PSB_R1, onShoulder, &printSticks);
+
+  ps2uart.setDebounceMs(10);  // 可调整去抖时间
+  ps2uart.begin(9600);        // 必须与模块波特保持一致，否则无法通讯
+}
+
+void loop() {
+  // 更新读取手柄数据，按键变化时在这里触发回调
+  ps2uart.update();
+
+  // 按住 L1 或 R1 时持续打印摇杆值
+  if (printSticks) {
+    Serial.print(F("Stick Values:"));
+    Serial.print(ps2uart.Analog(PSS_LY), DEC);
+    Serial.print(",");
+    Serial.print(ps2uart.Analog(PSS_LX), DEC);
+    Serial.print(",");
+    Serial.print(ps2uart.Analog(PSS_RY), DEC);
+    Serial.print(",");
+    Serial.println(ps2uart.Analog(PSS_RX), DEC);
+  }
+  delay(40);
+}
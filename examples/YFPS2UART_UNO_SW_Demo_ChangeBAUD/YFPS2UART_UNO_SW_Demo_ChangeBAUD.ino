@@ -37,11 +37,11 @@ void setup() {
 
     // /**********************修改波特率 ***************/
     // // 发送 AT+BAUD=TARGET_BAUD ，将模块波特率修改为TARGET_BAUD
-    // bool ok = ps2uart.sendSetBaud(TARGET_BAUD);  // 仅允许 9600 或 115200
+    // bool ok = ps2uart.sendSetBaud(TARGET_BAUD);  // 支持 9600, 19200, 38400, 57600, 115200
     // Serial.println("修改模块波特率至：" + String(TARGET_BAUD));
     // Serial.println("请将模块断电重启！！！！！");
     // if (!ok) {
-    //   Serial.println("注意：sendSetBaud 仅支持 9600 与 115200，或命令未成功发送。");
+    //   Serial.println("注意：sendSetBaud 仅支持 9600, 19200, 38400, 57600, 115200，或命令未成功发送。");
     // }
     // /**********************修改波特率 ***************/
 
@@ -0,0 +1,65 @@
+/*
+ * YFPS2UART_UNO_SW_Demo_Failsafe.ino
+ * 演示链路监测与失效保护：左摇杆 Y 轴控制电机速度（D5 输出 PWM），按住 R1 时点亮 D13。
+ * 开启失效保护后，手柄断开（0xAB）或模块断电/断线超过 lostMs 时按键立即释放、摇杆回中，
+ * 电机随之停转，不会停留在失联前的最后一个状态。链路状态变化通过回调打印到串口监视器，
+ * 坏帧累计持续增加时仍可控制，但说明接线或干扰需要检查。
+ * （AVR 默认不保留滑动窗口（YFPS2UART_LINK_BUCKETS 为 0），不会进入 Degraded，也不统计窗口帧率。）
+ * 
+ * 接线：PS2UART 模块 TX -> D11，RX -> D10
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+
+YFPS2UART ps2uart(SERIALTYPE_SW, 11, 10); // RX TX (根据硬件调整)
+
+const uint8_t MOTOR_PIN = 5;
+const uint8_t LED_PIN = 13;
+
+static void onLink(uint8_t from, uint8_t to, void* ctx) {
+  (void)from;
+  (void)ctx;
+  switch (to) {
+    case PS2_LINK_CONNECTED:    Serial.println(F("link: connected"));    break;
+    case PS2_LINK_DEGRADED:     Serial.println(F("link: degraded"));     break;
+    case PS2_LINK_LOST:         Serial.println(F("link: lost"));         break;
+    case PS2_LINK_DISCONNECTED: Serial.println(F("link: disconnected")); break;
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  ps2uart.begin(9600);
+  pinMode(LED_PIN, OUTPUT);
+
+  PS2LinkConfig cfg;
+  cfg.lostMs = 150;   // 超过 150ms 没有好帧即视为失联
+  ps2uart.setLinkConfig(cfg);
+  ps2uart.onLinkChange(onLink);
+  ps2uart.setFailsafe(true);
+  ps2uart.setStickInvert(PS2_AXIS_BIT(PSS_LY));   // 向上推为正
+}
+
+void loop() {
+  ps2uart.update();
+
+  // 失效保护生效时 Stick() 为 0、Button() 为 false，直接驱动输出即可
+  int8_t speed = ps2uart.Stick(PSS_LY);
+  analogWrite(MOTOR_PIN, speed > 0 ? speed * 2 : 0);
+  digitalWrite(LED_PIN, ps2uart.Button(PSB_R1) ? HIGH : LOW);
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint >= 1000) {
+    lastPrint = millis();
+    PS2LinkStats st;
+    ps2uart.getLinkStats(st);
+    Serial.print(F("corrupt="));
+    Serial.print(st.corruptFrames);
+    Serial.print(F(" gap="));
+    Serial.print(st.gapMs);
+    Serial.print(F("ms failsafe="));
+    Serial.println(ps2uart.isFailsafeActive() ? 1 : 0);
+  }
+}
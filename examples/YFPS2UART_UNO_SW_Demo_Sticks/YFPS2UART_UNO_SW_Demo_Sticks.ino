@@ -0,0 +1,46 @@
+/*
+ * YFPS2UART_UNO_SW_Demo_Sticks.ino
+ * 演示摇杆调理：自适应滤波、中心自动校准、圆形死区与指数响应曲线，直接得到 -127..127 的有符号值。
+ * 调理在每帧解码时计算一次，全部为整数运算；响应曲线在编译期生成并放在 PROGMEM 中，不占用 RAM。
+ * 
+ * 接线：PS2UART 模块 TX -> D11，RX -> D10
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <YFPS2UART.h>
+
+YFPS2UART ps2uart(SERIALTYPE_SW, 11, 10); // RX TX (根据硬件调整)
+
+// k = 160：中段更平缓，便于精细控制；两端仍为满量程
+static const PS2Curve kExpo PROGMEM = ps2ExpoCurve(160);
+
+void setup() {
+  Serial.begin(115200);
+  ps2uart.begin(9600);
+
+  ps2uart.setStickDeadzone(8, PS2_DEADZONE_RADIAL, PS2_AXES_ALL);   // 圆形死区，约 8 个原始计数
+  ps2uart.setStickCurve(&kExpo, PS2_AXES_ALL, true);                // 曲线位于 PROGMEM
+  ps2uart.setStickInvert(PS2_AXIS_BIT(PSS_LY) | PS2_AXIS_BIT(PSS_RY));   // Y 轴向上为正
+  ps2uart.setStickAutoCenter(true);                                 // 静止时缓慢跟踪中心
+  ps2uart.setStickFilter(PS2_FILTER_ADAPTIVE, 3);                   // 静止时平滑抖动，快速推杆时几乎无延迟
+}
+
+void loop() {
+  ps2uart.update();
+
+  static uint32_t lastPrint = 0;
+  if (millis() - lastPrint >= 100) {
+    lastPrint = millis();
+    Serial.print(F("L: "));
+    Serial.print(ps2uart.Stick(PSS_LX));
+    Serial.print(F(", "));
+    Serial.print(ps2uart.Stick(PSS_LY));
+    Serial.print(F("   R: "));
+    Serial.print(ps2uart.Stick(PSS_RX));
+    Serial.print(F(", "));
+    Serial.print(ps2uart.Stick(PSS_RY));
+    Serial.print(F("   center LX="));
+    Serial.println(ps2uart.getStickCenter(PSS_LX));
+  }
+}
@@ -0,0 +1,51 @@
+/*
+ * YFPS2UART_UNO_SW_Demo_Template.ino
+ * 演示静态分派模板 YFPS2UARTT<SerialT> 的用法：
+ * 串口对象由草图静态定义并传入，库内不再 new 软串口和适配器对象，逐字节读写也不经过虚函数表，
+ * 适合 RAM/Flash 紧张的 Arduino UNO。其余用法与 YFPS2UART 完全相同。
+ * 
+ * 串口方案：使用 SoftwareSerial
+ * 
+ * @ YFROBOT
+ * @ 2026-10-16
+*/
+#include <SoftwareSerial.h>
+#include <YFPS2UART.h>
+
+// Arduino UNO R3 软串口引脚配置
+SoftwareSerial ps2Serial(11, 10);               // RX TX (根据硬件调整)
+YFPS2UARTT<SoftwareSerial> ps2uart(ps2Serial);
+
+void setup() {
+  Serial.begin(115200);
+  Serial.println(F("YFPS2UART 模板版本演示"));
+
+  ps2uart.setDebounceMs(10);  // 可调整去抖时间
+  ps2uart.begin(9600);        // 必须与模块波特保持一致，否则无法通讯
+}
+
+void loop() {
+  // 更新读取手柄数据
+  ps2uart.update();
+
+  if (ps2uart.ButtonPressed(PSB_CROSS)) {
+    ps2uart.sendVibrate(VIBRATE_BOTH);
+    Serial.println(F("X just pressed"));
+  }
+  if (ps2uart.ButtonReleased(PSB_CROSS)) {
+    Serial.println(F("X just released"));
+  }
+
+  // 按住 L1 时打印摇杆值
+  if (ps2uart.Button(PSB_L1)) {
+    Serial.print(F("Stick Values:"));
+    Serial.print(ps2uart.Analog(PSS_LY), DEC);
+    Serial.print(",");
+    Serial.print(ps2uart.Analog(PSS_LX), DEC);
+    Serial.print(",");
+    Serial.print(ps2uart.Analog(PSS_RY), DEC);
+    Serial.print(",");
+    Serial.println(ps2uart.Analog(PSS_RX), DEC);
+  }
+  delay(40);
+}
@@ -0,0 +1,78 @@
+// MemorySerial.h
+// 主机端内存串口：实现 SerialBase，接收数据来自预先注入的缓冲区，发送数据记录到 tx 日志。
+// 声明为 final，用作 YFPS2UARTT<MemorySerial> 的模板参数时不经过虚函数表；与 ESP32 的 HardwareSerial 一样
+// 提供批量 read(uint8_t*, size_t)，模板版本每块只调用一次。
+// setNeedsListen(true) 时模拟 SoftwareSerial：同一时刻只有最近 listen() 的实例能读到数据（未 listen 时数据保留）。
+#ifndef YFPS2UART_HOST_MEMORY_SERIAL_H
+#define YFPS2UART_HOST_MEMORY_SERIAL_H
+
+#include <YFPS2UART.h>
+#include <vector>
+#include <string>
+
+class MemorySerial final : public SerialBase {
+public:
+    MemorySerial() : _pos(0), _baud(0), _needsListen(false) {}
+    ~MemorySerial() {
+        if (listener() == this) listener() = nullptr;
+    }
+
+    void begin(unsigned long baud) override { _baud = baud; }
+    int available() override {
+        if (!canRead()) return 0;
+        return (int)(_rx.size() - _pos);
+    }
+    int read() override {
+        if (_pos >= _rx.size() || !canRead()) return -1;
+        return _rx[_pos++];
+    }
+    void write(uint8_t data) override { _tx.push_back((char)data); }
+    void print(const char* str) override { _tx.append(str); }
+    void flush() override {}
+    bool needsListen() const override { return _needsListen; }
+    void listen() override { listener() = this; }
+    size_t readBytes(uint8_t* buf, size_t len) override { return read(buf, len); }
+    size_t read(uint8_t* buf, size_t len) {
+        if (!canRead()) return 0;
+        size_t n = _rx.size() - _pos;
+        if (n > len) n = len;
+        memcpy(buf, _rx.data() + _pos, n);
+        _pos += n;
+        return n;
+    }
+
+    // 追加接收数据
+    void inject(const uint8_t* data, size_t len) {
+        _rx.insert(_rx.end(), data, data + len);
+    }
+    // 清空接收缓冲区
+    void clear() {
+        _rx.clear();
+        _pos = 0;
+    }
+    // 重新从头读取已注入的数据（基准测试中重复使用同一段数据）
+    void rewind() { _pos = 0; }
+
+    size_t consumed() const { return _pos; }
+    size_t size() const { return _rx.size(); }
+    unsigned long baud() const { return _baud; }
+    const std::string& txLog() const { return _tx; }
+    void clearTx() { _tx.clear(); }
+    void setNeedsListen(bool on) { _needsListen = on; }
+    bool isListening() const { return listener() == this; }
+
+private:
+    std::vector<uint8_t> _rx;
+    size_t _pos;
+    unsigned long _baud;
+    std::string _tx;
+    bool _needsListen;
+
+    static MemorySerial*& listener() {
+        static MemorySerial* p = nullptr;
+        return p;
+    }
+    bool canRead() const { return !_needsListen || listener() == this; }
+};
+
+#endif // YFPS2UART_HOST_MEMORY_SERIAL_H
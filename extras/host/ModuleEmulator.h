@@ -0,0 +1,318 @@
+// ModuleEmulator.h
+// 主机端 PS2UART 接收模块仿真：实现 SerialBase，由虚拟时钟（micros()）驱动，结果完全确定。
+//   - 按设定的帧周期发送 0x0D + 6 字节负载 + 0x0A，每个字节按模块波特率的线上时间（10 位/字节）依次到达；
+//     线上时间超过帧周期时帧首尾相接（帧率受波特率限制）；
+//   - 手柄断开时每个周期只发一个 0xAB，模块断电（或 TX 线断开）时什么也不发；可注入帧间噪声字节、截断帧（丢掉帧尾）与随机丢字节；
+//   - rxBufferSize 非 0 时模拟本地 UART 接收缓冲：读取不及时，新到达的字节被丢弃（如 AVR 的 64 字节缓冲）；
+//   - 本地 begin() 的波特率与模块不一致时收到乱码，发出的指令也被忽略；
+//   - 应答 AT+VER / AT+BAUD? / AT+BAUD=（不超过 maxBaud）/ AT+RST（复位期间静默，applyOnReset 时新波特率在复位后生效）；
+//   - 记录收到的震动字节（0x01..0x03）及其时间。
+//
+//   PS2ModuleEmulator mod;              // 默认 9600，5ms 一帧
+//   YFPS2UART ps2(&mod);
+//   ps2.begin(9600);
+//   mod.setButtons(PSB_CROSS);          // 之后发出的帧带上新状态，mod.stateChangeUs() 为改变时间
+//   hostAdvanceMicros(1000); ps2.update();
+#ifndef YFPS2UART_HOST_MODULE_EMULATOR_H
+#define YFPS2UART_HOST_MODULE_EMULATOR_H
+
+#include <YFPS2UART.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+struct PS2ModuleConfig {
+    uint32_t baud;              // 模块当前波特率
+    uint32_t maxBaud;           // AT+BAUD= 接受的最高波特率
+    uint32_t framePeriodUs;     // 帧周期（线上时间更长时以线上时间为准）
+    uint32_t resetUs;           // AT+RST 后的静默时间
+    bool applyOnReset;          // AT+BAUD= 是否要 AT+RST 后才生效
+    size_t rxBufferSize;        // 本地接收缓冲大小，0 表示不限
+    const char* version;        // AT+VER 的应答
+
+    // 损伤（千分比，按帧或按字节抽签；seed 固定时结果可重复）
+    uint16_t noisePerMille;     // 每帧之后插入 1~3 个随机噪声字节的概率
+    uint16_t truncatePerMille;  // 截断帧（只发出前 2~6 个字节）的概率
+    uint16_t dropPerMille;      // 每个字节在线上丢失的概率
+    uint32_t seed;
+
+    PS2ModuleConfig()
+        : baud(9600), maxBaud(115200), framePeriodUs(5000), resetUs(500000), applyOnReset(false),
+          rxBufferSize(0), version("V1.0"), noisePerMille(0), truncatePerMille(0), dropPerMille(0), seed(1) {}
+};
+
+// 仿真器统计
+struct PS2ModuleCounters {
+    uint32_t frames;         // 发出的帧（含损伤）
+    uint32_t intactFrames;   // 完整发出且未丢字节的帧
+    uint32_t truncated;
+    uint32_t noiseBytes;
+    uint32_t droppedBytes;   // 线上丢失的字节
+    uint32_t overflowBytes;  // 接收缓冲已满被丢弃的字节
+    uint32_t abBytes;        // 断开期间发出的 0xAB
+};
+
+class PS2ModuleEmulator final : public SerialBase {
+public:
+    explicit PS2ModuleEmulator(const PS2ModuleConfig& cfg = PS2ModuleConfig())
+        : _cfg(cfg), _localBaud(0), _pendingBaud(0), _seed(cfg.seed ? cfg.seed : 1), _connected(true), _powered(true),
+          _buttons(0), _stateChangeUs(0), _lastUs(micros()), _clockNs(0), _txFreeNs(0), _silentUntilNs(0) {
+        memset(&_counters, 0, sizeof(_counters));
+        _axes[0] = 127;   // LY
+        _axes[1] = 128;   // LX
+        _axes[2] = 127;   // RY
+        _axes[3] = 128;   // RX
+        _nextFrameNs = nowNs() + (uint64_t)_cfg.framePeriodUs * 1000;   // 第一帧在一个周期后开始
+    }
+
+    // SerialBase
+    void begin(unsigned long baud) override {
+        _localBaud = (uint32_t)baud;
+        _rx.clear();   // 重新初始化本地 UART：未读数据丢失
+    }
+    int available() override {
+        advance();
+        return (int)_rx.size();
+    }
+    int read() override {
+        advance();
+        if (_rx.empty()) return -1;
+        uint8_t b = _rx.front();
+        _rx.pop_front();
+        return b;
+    }
+    size_t readBytes(uint8_t* buf, size_t len) override {
+        advance();
+        size_t n = (_rx.size() < len) ? _rx.size() : len;
+        for (size_t i = 0; i < n; ++i) {
+            buf[i] = _rx.front();
+            _rx.pop_front();
+        }
+        return n;
+    }
+    void write(uint8_t data) override {
+        advance();
+        if (_localBaud != _cfg.baud || inReset()) return;
+        if (_line.empty() && data >= VIBRATE_BOTH && data <= VIBRATE_RIGHT) {
+            _vibrations.push_back(std::make_pair((uint32_t)micros(), data));
+            return;
+        }
+        _line.push_back((char)data);
+        if (_line.size() >= 2 && _line.compare(_line.size() - 2, 2, "\r\n") == 0) {
+            handle(_line.substr(0, _line.size() - 2));
+            _line.clear();
+        }
+    }
+    void print(const char* str) override {
+        while (*str) write((uint8_t)*str++);
+    }
+    void flush() override {}
+
+    // 手柄状态：之后开始发送的帧使用新状态
+    void setButtons(uint16_t buttons) {
+        advance();
+        _buttons = buttons;
+        _stateChangeUs = micros();
+    }
+    // axis 为 PSS_LX/PSS_LY/PSS_RX/PSS_RY
+    void setStick(uint8_t axis, uint8_t value) {
+        advance();
+        _axes[PSS_LY - axis] = value;
+        _stateChangeUs = micros();
+    }
+    void setConnected(bool on) {
+        advance();
+        _connected = on;
+    }
+    // 模块断电：之后不再发出任何字节（已在线路上的字节照常到达）
+    void setPowered(bool on) {
+        advance();
+        _powered = on;
+    }
+    void setImpairments(uint16_t noisePerMille, uint16_t truncatePerMille, uint16_t dropPerMille) {
+        advance();
+        _cfg.noisePerMille = noisePerMille;
+        _cfg.truncatePerMille = truncatePerMille;
+        _cfg.dropPerMille = dropPerMille;
+    }
+
+    uint32_t moduleBaud() const { return _cfg.baud; }
+    uint32_t stateChangeUs() const { return _stateChangeUs; }
+    const PS2ModuleCounters& counters() const { return _counters; }
+    const std::vector<std::pair<uint32_t, uint8_t> >& vibrations() const { return _vibrations; }
+    // 帧的线上时间（微秒）
+    uint32_t frameWireUs() const { return (uint32_t)(byteNs() * 8 / 1000); }
+
+private:
+    PS2ModuleConfig _cfg;
+    uint32_t _localBaud;
+    uint32_t _pendingBaud;
+    uint32_t _seed;
+    bool _connected;
+    bool _powered;
+    uint16_t _buttons;
+    uint8_t _axes[4];          // 帧内顺序：LY, LX, RY, RX
+    uint32_t _stateChangeUs;
+    PS2ModuleCounters _counters;
+
+    // 时间以纳秒计（64 位），由 micros() 扩展而来
+    uint32_t _lastUs;
+    uint64_t _clockNs;
+    uint64_t _nextFrameNs;     // 下一帧的计划开始时间
+    uint64_t _txFreeNs;        // 模块发送线路空闲的时间
+    uint64_t _silentUntilNs;   // 复位结束时间
+
+    std::deque<std::pair<uint64_t, uint8_t> > _wire;   // 已发出、尚未到达本地的字节（到达时间, 字节）
+    std::deque<uint8_t> _rx;                            // 已到达本地接收缓冲的字节
+    std::string _line;
+    std::vector<std::pair<uint32_t, uint8_t> > _vibrations;
+
+    uint64_t nowNs() {
+        uint32_t now = micros();
+        _clockNs += (uint64_t)(uint32_t)(now - _lastUs) * 1000;
+        _lastUs = now;
+        return _clockNs;
+    }
+    uint64_t byteNs() const { return 10000000000ULL / _cfg.baud; }
+    bool inReset() const { return _clockNs < _silentUntilNs; }
+
+    uint32_t rnd() {
+        _seed = _seed * 1103515245u + 12345u;
+        return _seed >> 16;
+    }
+    bool chance(uint16_t perMille) { return perMille && rnd() % 1000 < perMille; }
+
+    // 从 at 起把字节依次放上线路
+    void send(const uint8_t* data, size_t len, uint64_t at) {
+        uint64_t t = (at > _txFreeNs) ? at : _txFreeNs;
+        for (size_t i = 0; i < len; ++i) {
+            t += byteNs();
+            _wire.push_back(std::make_pair(t, data[i]));
+        }
+        _txFreeNs = t;
+    }
+    void sendText(const char* str) { send((const uint8_t*)str, strlen(str), _clockNs); }
+
+    void emitFrame(uint64_t at) {
+        if (!_powered) return;
+        if (!_connected) {
+            const uint8_t ab = 0xAB;
+            send(&ab, 1, at);
+            ++_counters.abBytes;
+            return;
+        }
+        uint8_t f[8] = {0x0D, (uint8_t)(_buttons >> 8), (uint8_t)(_buttons & 0xFF),
+                        _axes[0], _axes[1], _axes[2], _axes[3], 0x0A};
+        size_t len = 8;
+        bool intact = true;
+        ++_counters.frames;
+        if (chance(_cfg.truncatePerMille)) {
+            len = 2 + rnd() % 5;
+            intact = false;
+            ++_counters.truncated;
+        }
+        uint8_t out[8];
+        size_t n = 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (chance(_cfg.dropPerMille)) {
+                ++_counters.droppedBytes;
+                intact = false;
+                continue;
+            }
+            out[n++] = f[i];
+        }
+        send(out, n, at);
+        if (intact) ++_counters.intactFrames;
+        if (chance(_cfg.noisePerMille)) {
+            uint8_t noise[3];
+            size_t k = 1 + rnd() % 3;
+            for (size_t i = 0; i < k; ++i) noise[i] = (uint8_t)rnd();
+            send(noise, k, _txFreeNs);
+            _counters.noiseBytes += (uint32_t)k;
+        }
+    }
+
+    // 推进到当前时间：产生到期的帧，把已到达的字节移入本地接收缓冲
+    void advance() {
+        uint64_t now = nowNs();
+        for (;;) {
+            if (!_wire.empty() && _wire.front().first <= _nextFrameNs && _wire.front().first <= now) {
+                deliver(_wire.front().second);
+                _wire.pop_front();
+                continue;
+            }
+            if (_nextFrameNs > now) break;
+            uint64_t start = _nextFrameNs;
+            if (start < _silentUntilNs) {
+                _nextFrameNs = _silentUntilNs;
+                continue;
+            }
+            if (start < _txFreeNs) start = _txFreeNs;   // 线路忙：帧首尾相接
+            if (start > now) {
+                _nextFrameNs = start;
+                continue;
+            }
+            emitFrame(start);
+            _nextFrameNs = start + (uint64_t)_cfg.framePeriodUs * 1000;
+        }
+        while (!_wire.empty() && _wire.front().first <= now) {
+            deliver(_wire.front().second);
+            _wire.pop_front();
+        }
+    }
+
+    void deliver(uint8_t b) {
+        if (_localBaud != _cfg.baud) b = (uint8_t)rnd();
+        if (_cfg.rxBufferSize && _rx.size() >= _cfg.rxBufferSize) {
+            ++_counters.overflowBytes;
+            return;
+        }
+        _rx.push_back(b);
+    }
+
+    void handle(const std::string& cmd) {
+        char buf[40];
+        if (cmd == "AT+VER") {
+            snprintf(buf, sizeof(buf), "%s\r\n", _cfg.version);
+            sendText(buf);
+        } else if (cmd == "AT+BAUD?") {
+            snprintf(buf, sizeof(buf), "%lu\r\n", (unsigned long)_cfg.baud);
+            sendText(buf);
+        } else if (cmd.compare(0, 8, "AT+BAUD=") == 0) {
+            uint32_t to = (uint32_t)atol(cmd.c_str() + 8);
+            bool valid = false;
+            for (size_t i = 0; i < sizeof(kPS2BaudRates) / sizeof(kPS2BaudRates[0]); ++i) {
+                if (kPS2BaudRates[i] == to) valid = true;
+            }
+            if (!valid || to > _cfg.maxBaud) {
+                sendText("ERROR\r\n");
+                return;
+            }
+            sendText("OK\r\n");
+            if (_cfg.applyOnReset) {
+                _pendingBaud = to;
+            } else {
+                flushWire();
+                _cfg.baud = to;
+            }
+        } else if (cmd == "AT+RST") {
+            _wire.clear();   // 复位：未发完的数据丢失
+            _txFreeNs = _clockNs;
+            if (_pendingBaud) _cfg.baud = _pendingBaud;
+            _pendingBaud = 0;
+            _silentUntilNs = _clockNs + (uint64_t)_cfg.resetUs * 1000;
+        } else {
+            sendText("ERROR\r\n");
+        }
+    }
+
+    // 切换波特率前，让已在线路上的应答按原波特率到达
+    void flushWire() {
+        while (!_wire.empty()) {
+            deliver(_wire.front().second);
+            _wire.pop_front();
+        }
+    }
+};
+
+#endif // YFPS2UART_HOST_MODULE_EMULATOR_H
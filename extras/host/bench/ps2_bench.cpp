@@ -0,0 +1,2189 @@
+// ps2_bench.cpp
+// 主机端基准测试：测量 YFPS2UART::update()/readDataFromSerial() 每字节、每帧的开销，
+// 以及不同积压深度下单次 update() 的耗时、0xAB 断开和重同步路径的开销。
+//
+// 用法：make -C extras/host bench  [ARGS="<倍数>"]
+#include <YFPS2UART.h>
+#include "../MemorySerial.h"
+#include "../ModuleEmulator.h"
+
+#include <YFPS2UARTRing.h>
+#include <YFPS2UARTMulti.h>
+#include <YFPS2UARTReplay.h>
+#include <SoftwareSerial.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <thread>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+// 统计堆分配次数（替换全局 operator new），用于检查构造/begin/update/析构不使用堆
+static volatile unsigned long g_heapAllocs = 0;
+
+void* operator new(size_t size) {
+  __atomic_fetch_add(&g_heapAllocs, 1, __ATOMIC_RELAXED);
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+volatile unsigned int g_sink;
+
+double elapsedNs(Clock::time_point t0) {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+}
+
+// 生成一帧：0x0D + buttonsHigh + buttonsLow + LY + LX + RY + RX + 0x0A
+// 负载避开 0x0A/0x0D/0xAB，保证旧解析器也能完整解出每一帧
+void appendFrame(std::vector<uint8_t>& out, uint32_t i) {
+  uint16_t buttons = (uint16_t)((i / 8) & 0x0F) << 4;  // 十字键缓慢变化，覆盖去抖路径
+  uint8_t stick = (uint8_t)(100 + (i % 50));
+  out.push_back(0x0D);
+  out.push_back((uint8_t)(buttons >> 8));
+  out.push_back((uint8_t)(buttons & 0xFF));
+  out.push_back(stick);
+  out.push_back((uint8_t)(255 - stick));
+  out.push_back(127);
+  out.push_back(128);
+  out.push_back(0x0A);
+}
+
+// 任意负载的帧（负载可以包含 0x0A/0x0D/0xAB）
+void appendPayloadFrame(std::vector<uint8_t>& out, const uint8_t payload[6]) {
+  out.push_back(0x0D);
+  out.insert(out.end(), payload, payload + 6);
+  out.push_back(0x0A);
+}
+
+// 只含按键的帧（摇杆居中）
+void appendButtonsFrame(std::vector<uint8_t>& out, uint16_t buttons) {
+  uint8_t payload[6] = {(uint8_t)(buttons >> 8), (uint8_t)(buttons & 0xFF), 127, 128, 127, 128};
+  appendPayloadFrame(out, payload);
+}
+
+void report(const char* name, size_t bytes, size_t frames, double ns) {
+  printf("%-28s %10zu %8zu %10.2f %10.1f\n", name, bytes, frames,
+         bytes ? ns / (double)bytes : 0.0, frames ? ns / (double)frames : 0.0);
+}
+
+// 持续调用 update() 直到数据读完，每次调用推进 1ms 虚拟时间
+double drainStream(MemorySerial& mem, YFPS2UARTCore& ps2) {
+  Clock::time_point t0 = Clock::now();
+  while (mem.available() > 0) {
+    ps2.update();
+    hostAdvanceMicros(1000);
+  }
+  double ns = elapsedNs(t0);
+  g_sink = ps2.getRawButtons();
+  return ns;
+}
+
+void benchCleanStream(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.begin(115200);
+  report("clean stream", data.size(), frames, drainStream(mem, ps2));
+
+  // 同一数据流改用静态分派模板（MemorySerial 为 final 且有批量 read()，每块一次内联调用）
+  mem.rewind();
+  YFPS2UARTT<MemorySerial> ps2t(mem);
+  ps2t.begin(115200);
+  double ns = drainStream(mem, ps2t);
+  PS2FrameCounters a, b;
+  ps2.getFrameCounters(a);
+  ps2t.getFrameCounters(b);
+  bool same = a.good == b.good && ps2.getRawButtons() == ps2t.getRawButtons();
+  printf("%-28s %10zu %8u %10.2f %10.1f   %s (sizeof YFPS2UART=%zu, YFPS2UARTT=%zu)\n", "clean stream (template)",
+         data.size(), (unsigned)frames, ns / (double)data.size(), ns / (double)frames, same ? "same" : "DIFFERENT",
+         sizeof(YFPS2UART), sizeof(YFPS2UARTT<MemorySerial>));
+}
+
+void benchBacklog(uint32_t depth, uint32_t reps, bool drain) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < depth; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+
+  // 每轮用新对象从同一积压起点调用一次 update()，只计时 update() 本身
+  double ns = 0;
+  for (uint32_t r = 0; r < reps; ++r) {
+    mem.rewind();
+    YFPS2UART ps2(&mem);
+    ps2.setDrainMode(drain);
+    Clock::time_point t0 = Clock::now();
+    ps2.update();
+    ns += elapsedNs(t0);
+    g_sink = ps2.getRawButtons();
+    hostAdvanceMicros(1000);
+  }
+
+  char name[40];
+  snprintf(name, sizeof(name), "update()%s backlog=%u", drain ? " drain" : "", (unsigned)depth);
+  printf("%-28s %10zu %8u %10s %10s   ns/call %.1f\n", name, data.size(), (unsigned)reps,
+         "-", "-", ns / (double)reps);
+}
+
+// 访问器开销：演示程序式的 4 次 Analog() + 12 次 Button()，对比一次 getState() 后读结构体
+void benchAccessors(uint32_t reps) {
+  std::vector<uint8_t> data;
+  appendFrame(data, 8);
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.update();
+
+  static const uint16_t masks[12] = {PSB_START, PSB_SELECT, PSB_PAD_UP, PSB_PAD_RIGHT, PSB_PAD_LEFT,
+                                     PSB_PAD_DOWN, PSB_L1, PSB_R1, PSB_L2, PSB_R2, PSB_CROSS, PSB_CIRCLE};
+  YFPS2UART* volatile p = &ps2;   // 防止编译器把整段访问提到循环外
+  unsigned acc = 0;
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t r = 0; r < reps; ++r) {
+    acc += p->Analog(PSS_LY) + p->Analog(PSS_LX) + p->Analog(PSS_RY) + p->Analog(PSS_RX);
+    for (int k = 0; k < 12; ++k) acc += p->Button(masks[k]);
+  }
+  double perCall = elapsedNs(t0) / (double)reps;
+
+  t0 = Clock::now();
+  for (uint32_t r = 0; r < reps; ++r) {
+    PS2State st;
+    p->getState(st);
+    acc += st.analog(PSS_LY) + st.analog(PSS_LX) + st.analog(PSS_RY) + st.analog(PSS_RX);
+    for (int k = 0; k < 12; ++k) acc += st.button(masks[k]);
+  }
+  double perState = elapsedNs(t0) / (double)reps;
+  g_sink = acc;
+
+  printf("%-28s %10s %8u %10s %10s   accessors %.1f ns, getState %.1f ns\n", "4x Analog + 12x Button",
+         "-", (unsigned)reps, "-", "-", perCall, perState);
+}
+
+// 边沿分发：每帧 update() 后轮询 16 个按键 × 2 个边沿函数，对比注册 onPress/onRelease 回调
+// （appendFrame 每 8 帧改变一次十字键，两种方式统计到的边沿数必须一致）
+void countEdge(const PS2Event& ev, void* ctx) {
+  (void)ev;
+  ++*(uint32_t*)ctx;
+}
+
+bool benchButtonDispatch(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  uint32_t polled = 0;
+  double pollNs;
+  {
+    YFPS2UART ps2(&mem);
+    ps2.setDebounceMs(0);
+    Clock::time_point t0 = Clock::now();
+    while (mem.available() > 0) {
+      ps2.update();
+      for (int b = 0; b < 16; ++b) {
+        polled += ps2.ButtonPressed((uint16_t)(1u << b));
+        polled += ps2.ButtonReleased((uint16_t)(1u << b));
+      }
+      hostAdvanceMicros(1000);
+    }
+    pollNs = elapsedNs(t0);
+  }
+
+  mem.rewind();
+  uint32_t dispatched = 0;
+  double cbNs;
+  {
+    YFPS2UART ps2(&mem);
+    ps2.setDebounceMs(0);
+    ps2.onPress(0xFFFF, countEdge, &dispatched);
+    ps2.onRelease(0xFFFF, countEdge, &dispatched);
+    Clock::time_point t0 = Clock::now();
+    while (mem.available() > 0) {
+      ps2.update();
+      hostAdvanceMicros(1000);
+    }
+    cbNs = elapsedNs(t0);
+  }
+
+  bool ok = polled == dispatched && dispatched > 0;
+  printf("%-28s %10zu %8u %10s %10s   poll 32 edges %.1f ns/loop, callbacks %.1f ns/loop, edges=%u %s\n",
+         "edge dispatch", data.size(), (unsigned)frames, "-", "-", pollNs / frames, cbNs / frames,
+         (unsigned)dispatched, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// 回调表：每个不同的 (fn, ctx) 占一项，表满时注册失败；同一 fn/ctx 的按下与释放合并为一项，
+// 覆盖注册与取消注册会释放不再使用的项；回调收到的按键与类型与注册一致
+struct EdgeLog {
+  uint16_t pressed;
+  uint16_t released;
+};
+
+void logEdge(const PS2Event& ev, void* ctx) {
+  EdgeLog* log = static_cast<EdgeLog*>(ctx);
+  (ev.type == PS2_EVENT_PRESS ? log->pressed : log->released) |= ev.button;
+}
+
+bool checkHandlerTable() {
+  YFPS2UARTDecoder dec;
+  dec.setDebounceMs(0);
+  EdgeLog logs[YFPS2UART_BUTTON_HANDLERS + 1];
+  memset(logs, 0, sizeof(logs));
+  bool ok = true;
+  for (uint8_t i = 0; i < YFPS2UART_BUTTON_HANDLERS; ++i) {
+    ok = dec.onPress((uint16_t)(1u << i), logEdge, &logs[i]) && ok;
+    ok = dec.onRelease((uint16_t)(1u << i), logEdge, &logs[i]) && ok;   // 同一项
+  }
+  uint16_t extra = (uint16_t)(1u << YFPS2UART_BUTTON_HANDLERS);
+  ok = ok && !dec.onPress(extra, logEdge, &logs[YFPS2UART_BUTTON_HANDLERS]);
+  ok = dec.onPress(PSB_START | PSB_SELECT, logEdge, &logs[0]) && ok;   // 并入已有的项
+  ok = dec.onPress(1u << 1, nullptr) && ok;                            // 取消按下，释放仍在
+  ok = dec.onRelease(1u << 1, nullptr) && ok;                          // 第 1 项空出
+  ok = dec.onPress(extra, logEdge, &logs[YFPS2UART_BUTTON_HANDLERS]) && ok;
+
+  std::vector<uint8_t> data;
+  appendButtonsFrame(data, 0xFFFF);
+  appendButtonsFrame(data, 0);
+  for (size_t i = 0; i < data.size(); i += 8) {
+    dec.feed(&data[i], 8, micros());
+    hostAdvanceMicros(1000);
+  }
+  ok = ok && logs[0].pressed == (PSB_SELECT | PSB_START) && logs[0].released == PSB_SELECT && logs[1].pressed == 0 &&
+       logs[1].released == 0 && logs[2].pressed == (1u << 2) && logs[2].released == (1u << 2) &&
+       logs[YFPS2UART_BUTTON_HANDLERS].pressed == extra && logs[YFPS2UART_BUTTON_HANDLERS].released == 0;
+  printf("%-28s %10s %8s %10s %10s   %s (capacity %u)\n", "button handler table", "-", "-", "-", "-",
+         ok ? "ok" : "FAIL", (unsigned)YFPS2UART_BUTTON_HANDLERS);
+  return ok;
+}
+
+// 断开路径：模块在手柄未连接时持续发送 0xAB，偶尔夹杂一帧
+void benchDisconnect(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) {
+    for (int k = 0; k < 32; ++k) data.push_back(0xAB);
+    appendFrame(data, i);
+  }
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.begin(115200);
+  report("disconnect 0xAB x32/frame", data.size(), frames, drainStream(mem, ps2));
+}
+
+// 重同步路径：帧之间插入随机噪声字节（可能包含 0x0D/0x0A/0xAB）
+void benchResync(uint32_t frames) {
+  std::vector<uint8_t> data;
+  uint32_t seed = 12345;
+  for (uint32_t i = 0; i < frames; ++i) {
+    for (int k = 0; k < 16; ++k) {
+      seed = seed * 1103515245u + 12345u;
+      data.push_back((uint8_t)(seed >> 16));
+    }
+    appendFrame(data, i);
+  }
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.begin(115200);
+  report("resync noise x16/frame", data.size(), frames, drainStream(mem, ps2));
+  PS2FrameCounters c;
+  ps2.getFrameCounters(c);
+  printf("    good=%u short=%u long=%u resynced=%u noise=%u\n", (unsigned)c.good, (unsigned)c.shortFrames,
+         (unsigned)c.longFrames, (unsigned)c.resynced, (unsigned)c.noiseBytes);
+}
+
+// 默认（非 drain）路径：每次 update() 处理一帧，摇杆值取负载中的 LY, LX, RY, RX，而不是按键字节
+bool checkDefaultPathAxes(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.begin(115200);
+  bool ok = true;
+  for (uint32_t i = 0; i < frames && ok; ++i) {
+    ps2.update();
+    hostAdvanceMicros(1000);
+    const uint8_t* f = &data[i * 8];
+    ok = ps2.Analog(PSS_LY) == f[3] && ps2.Analog(PSS_LX) == f[4] && ps2.Analog(PSS_RY) == f[5] &&
+         ps2.Analog(PSS_RX) == f[6];
+  }
+  printf("%-28s %10zu %8u %10s %10s   %s\n", "update() axes (no drain)", data.size(), (unsigned)frames, "-", "-",
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// 负载透明：负载取遍 0..255（包含 0x0A/0x0D/0xAB），每一帧都必须原样解出
+bool checkPayloadTransparency(uint32_t frames) {
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> payloads;
+  uint32_t seed = 99;
+  for (uint32_t i = 0; i < frames; ++i) {
+    uint8_t p[6];
+    for (int k = 0; k < 6; ++k) {
+      seed = seed * 1103515245u + 12345u;
+      p[k] = (uint8_t)(seed >> 16);
+    }
+    if (i % 7 == 0) p[2] = 0x0A;   // 确保特殊值频繁出现
+    if (i % 7 == 1) p[3] = 0xAB;
+    if (i % 7 == 2) p[4] = 0x0D;
+    appendPayloadFrame(data, p);
+    payloads.insert(payloads.end(), p, p + 6);
+  }
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.setDebounceMs(0);
+  bool ok = true;
+  uint32_t got = 0;
+  Clock::time_point t0 = Clock::now();
+  while (mem.available() > 0 || got < frames) {
+    uint32_t before = got;
+    ps2.update();
+    PS2State st;
+    ps2.getState(st);
+    got = st.seq;
+    if (got == before) break;
+    const uint8_t* p = &payloads[(got - 1) * 6];
+    if (ps2.getRawButtons() != (unsigned)((p[0] << 8) | p[1]) || ps2.Analog(PSS_LY) != p[2] ||
+        ps2.Analog(PSS_LX) != p[3] || ps2.Analog(PSS_RY) != p[4] || ps2.Analog(PSS_RX) != p[5]) {
+      ok = false;
+    }
+    hostAdvanceMicros(1000);
+  }
+  double ns = elapsedNs(t0);
+  PS2FrameCounters c;
+  ps2.getFrameCounters(c);
+  ok = ok && got == frames && c.good == frames && c.shortFrames == 0 && c.longFrames == 0 &&
+       ps2.isRemoteConnected();
+  printf("%-28s %10zu %8u %10.2f %10.1f   %s\n", "payload-transparent frames", data.size(),
+         (unsigned)frames, ns / (double)data.size(), ns / (double)frames, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// feed()：同一段数据按随机长度（1..23 字节）切片直接交给解析引擎，帧跨越两次调用；
+// 解出的帧数与每帧负载必须与通过串口 update() 的结果一致，并比较两者每字节的开销
+bool checkFeed(uint32_t frames) {
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> payloads;
+  uint32_t seed = 7;
+  for (uint32_t i = 0; i < frames; ++i) {
+    uint8_t p[6];
+    for (int k = 0; k < 6; ++k) {
+      seed = seed * 1103515245u + 12345u;
+      p[k] = (uint8_t)(seed >> 16);
+    }
+    appendPayloadFrame(data, p);
+    payloads.insert(payloads.end(), p, p + 6);
+  }
+
+  YFPS2UARTDecoder dec;
+  dec.setDebounceMs(0);
+  bool ok = true;
+  uint32_t got = 0;
+  size_t pos = 0;
+  uint32_t spanning = 0;
+  Clock::time_point t0 = Clock::now();
+  while (pos < data.size()) {
+    seed = seed * 1103515245u + 12345u;
+    size_t n = 1 + (seed >> 16) % 23;
+    if (n > data.size() - pos) n = data.size() - pos;
+    if ((pos / 8) != ((pos + n - 1) / 8) && (pos + n) % 8 != 0) ++spanning;
+    uint16_t k = dec.feed(data.data() + pos, n, micros());
+    pos += n;
+    got += k;
+    if (k) {
+      const uint8_t* p = &payloads[(got - 1) * 6];   // 摇杆与原始按键取本次最新一帧
+      if (dec.getRawButtons() != (unsigned)((p[0] << 8) | p[1]) || dec.Analog(PSS_LY) != p[2] ||
+          dec.Analog(PSS_LX) != p[3] || dec.Analog(PSS_RY) != p[4] || dec.Analog(PSS_RX) != p[5]) {
+        ok = false;
+      }
+    }
+    hostAdvanceMicros(100);
+  }
+  double ns = elapsedNs(t0);
+  PS2FrameCounters c;
+  dec.getFrameCounters(c);
+  ok = ok && got == frames && c.good == frames && c.shortFrames == 0 && c.longFrames == 0;
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.setDebounceMs(0);
+  ps2.setDrainMode(true);
+  Clock::time_point t1 = Clock::now();
+  ps2.update();
+  double nsSerial = elapsedNs(t1);
+  PS2FrameCounters cs;
+  ps2.getFrameCounters(cs);
+  ok = ok && cs.good == c.good && ps2.getRawButtons() == dec.getRawButtons();
+
+  printf("%-28s %10zu %8u %10.2f %10.1f   %s (%u frames split across calls; serial update %.2f ns/byte)\n",
+         "feed() random slices", data.size(), (unsigned)frames, ns / (double)data.size(),
+         ns / (double)frames, ok ? "ok" : "FAIL", (unsigned)spanning, nsSerial / (double)data.size());
+  return ok;
+}
+
+// 截断帧：每 10 帧有一帧丢失 2 个负载字节，紧随其后的好帧必须通过重同步找回
+bool checkTruncatedFrames(uint32_t frames) {
+  std::vector<uint8_t> data;
+  uint32_t truncated = 0;
+  for (uint32_t i = 0; i < frames; ++i) {
+    size_t start = data.size();
+    appendFrame(data, i);
+    if (i % 10 == 5) {
+      data.erase(data.begin() + start + 3, data.begin() + start + 5);
+      ++truncated;
+    }
+  }
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.setDrainMode(true);
+  ps2.update();
+  PS2FrameCounters c;
+  ps2.getFrameCounters(c);
+  bool ok = c.good == frames - truncated && c.shortFrames == truncated && c.resynced == truncated;
+  printf("%-28s %10zu %8u %10s %10s   %s (good=%u short=%u long=%u resynced=%u)\n", "truncated frames 1/10",
+         data.size(), (unsigned)frames, "-", "-", ok ? "ok" : "FAIL", (unsigned)c.good,
+         (unsigned)c.shortFrames, (unsigned)c.longFrames, (unsigned)c.resynced);
+  return ok;
+}
+
+// 按键独立去抖：SELECT 每帧翻转（持续抖动），CROSS 在抖动期间按下、保持后释放。
+// CROSS 的按下/释放延迟必须在去抖时间 + 一帧以内，且抖动的 SELECT 始终不被接受
+bool checkIndependentDebounce(uint32_t cycles) {
+  const uint32_t kFrameUs = 4000;
+  const uint16_t kDebounceMs = 30;
+  const uint32_t kPressAt = 10, kReleaseAt = 40, kCycle = 80;   // 以帧为单位
+  MemorySerial mem;
+  YFPS2UART ps2(&mem);
+  ps2.setDebounceMs(kDebounceMs);
+  bool ok = true;
+  uint32_t maxPressMs = 0, maxReleaseMs = 0;
+  double ns = 0;
+  for (uint32_t c = 0; c < cycles; ++c) {
+    uint32_t pressedAt = 0, releasedAt = 0;
+    bool sawPress = false, sawRelease = false;
+    for (uint32_t i = 0; i < kCycle; ++i) {
+      uint16_t buttons = (i & 1) ? PSB_SELECT : 0;
+      if (i >= kPressAt && i < kReleaseAt) buttons |= PSB_CROSS;
+      std::vector<uint8_t> frame;
+      appendButtonsFrame(frame, buttons);
+      mem.clear();
+      mem.inject(frame.data(), frame.size());
+      uint32_t now = millis();
+      if (i == kPressAt) pressedAt = now;
+      if (i == kReleaseAt) releasedAt = now;
+      Clock::time_point t0 = Clock::now();
+      ps2.update();
+      ns += elapsedNs(t0);
+      if (ps2.getButtons() & PSB_SELECT) ok = false;
+      if (ps2.ButtonPressed(PSB_CROSS)) {
+        sawPress = true;
+        if (now - pressedAt > maxPressMs) maxPressMs = now - pressedAt;
+      }
+      if (ps2.ButtonReleased(PSB_CROSS)) {
+        sawRelease = true;
+        if (now - releasedAt > maxReleaseMs) maxReleaseMs = now - releasedAt;
+      }
+      hostAdvanceMicros(kFrameUs);
+    }
+    if (!sawPress || !sawRelease) ok = false;
+  }
+  uint32_t limitMs = kDebounceMs + kFrameUs / 1000;
+  ok = ok && maxPressMs <= limitMs && maxReleaseMs <= limitMs;
+  uint32_t frames = cycles * kCycle;
+  printf("%-28s %10u %8u %10s %10.1f   %s (press<=%ums release<=%ums)\n", "debounce with chatter",
+         (unsigned)(frames * 8), (unsigned)frames, "-", ns / (double)frames, ok ? "ok" : "FAIL",
+         (unsigned)maxPressMs, (unsigned)maxReleaseMs);
+  return ok;
+}
+
+// 按键事件队列：
+// 1) 积压的 12 次按下/释放在一次 update() 后全部以事件取出（ButtonPressed() 只能看到一次）；
+// 2) 10ms 一帧的脚本输入产生预期的双击、长按、连发序列；
+// 3) 不取事件时超出容量的事件计入溢出计数。
+#if YFPS2UART_ENABLE_EVENTS
+bool checkButtonEvents(uint32_t reps) {
+  bool ok = true;
+
+  {
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 12; ++i) {
+      appendButtonsFrame(data, PSB_CROSS);
+      appendButtonsFrame(data, 0);
+    }
+    MemorySerial mem;
+    mem.inject(data.data(), data.size());
+    YFPS2UART ps2(&mem);
+    ps2.setDebounceMs(0);
+    ps2.setDrainMode(true);
+    ps2.update();
+    PS2Event ev;
+    int n = 0;
+    while (ps2.pollEvent(ev)) {
+      uint8_t expect = (n & 1) ? PS2_EVENT_RELEASE : PS2_EVENT_PRESS;
+      if (ev.type != expect || ev.button != PSB_CROSS) ok = false;
+      ++n;
+    }
+    if (n != 24 || !ps2.ButtonPressed(PSB_CROSS) || ps2.ButtonPressed(PSB_CROSS)) ok = false;
+  }
+
+  // 期望序列：CIRCLE 按下(0ms)/释放(50ms)/按下+双击(100ms)/释放(150ms)，
+  // SQUARE 自 300ms 按住 700ms：连发 600/700/800/900ms，长按 800ms，释放 1000ms
+  struct Expect { uint32_t t; uint16_t button; uint8_t type; uint8_t count; };
+  static const Expect kExpect[] = {
+    {0, PSB_CIRCLE, PS2_EVENT_PRESS, 0},       {50, PSB_CIRCLE, PS2_EVENT_RELEASE, 0},
+    {100, PSB_CIRCLE, PS2_EVENT_PRESS, 0},     {100, PSB_CIRCLE, PS2_EVENT_DOUBLE_TAP, 0},
+    {150, PSB_CIRCLE, PS2_EVENT_RELEASE, 0},   {300, PSB_SQUARE, PS2_EVENT_PRESS, 0},
+    {600, PSB_SQUARE, PS2_EVENT_REPEAT, 1},    {700, PSB_SQUARE, PS2_EVENT_REPEAT, 2},
+    {800, PSB_SQUARE, PS2_EVENT_LONG_PRESS, 0}, {800, PSB_SQUARE, PS2_EVENT_REPEAT, 3},
+    {900, PSB_SQUARE, PS2_EVENT_REPEAT, 4},    {1000, PSB_SQUARE, PS2_EVENT_RELEASE, 0},
+  };
+  const size_t kCount = sizeof(kExpect) / sizeof(kExpect[0]);
+  double ns = 0;
+  uint32_t frames = 0;
+  for (uint32_t r = 0; r < reps; ++r) {
+    MemorySerial mem;
+    YFPS2UART ps2(&mem);
+    ps2.setDebounceMs(0);
+    ps2.setLongPressMs(500);
+    ps2.setAutoRepeat(300, 100);
+    ps2.setDoubleTapMs(250);
+    uint32_t base = millis();
+    size_t seen = 0;
+    for (uint32_t f = 0; f < 110; ++f) {
+      uint32_t t = f * 10;
+      uint16_t buttons = 0;
+      if (t < 50 || (t >= 100 && t < 150)) buttons |= PSB_CIRCLE;
+      if (t >= 300 && t < 1000) buttons |= PSB_SQUARE;
+      std::vector<uint8_t> frame;
+      appendButtonsFrame(frame, buttons);
+      mem.clear();
+      mem.inject(frame.data(), frame.size());
+      Clock::time_point t0 = Clock::now();
+      ps2.update();
+      ns += elapsedNs(t0);
+      ++frames;
+      PS2Event ev;
+      while (ps2.pollEvent(ev)) {
+        if (seen >= kCount) {
+          ok = false;
+          break;
+        }
+        const Expect& e = kExpect[seen++];
+        if (ev.timeMs - base != e.t || ev.button != e.button || ev.type != e.type || ev.count != e.count) {
+          ok = false;
+        }
+      }
+      hostAdvanceMicros(10000);
+    }
+    if (seen != kCount || ps2.getEventOverflows() != 0) ok = false;
+  }
+
+  uint16_t overflows = 0;
+  {
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 40; ++i) {
+      appendButtonsFrame(data, PSB_START);
+      appendButtonsFrame(data, 0);
+    }
+    MemorySerial mem;
+    mem.inject(data.data(), data.size());
+    YFPS2UART ps2(&mem);
+    ps2.setDebounceMs(0);
+    ps2.setDrainMode(true);
+    ps2.update();
+    overflows = ps2.getEventOverflows();
+    if (overflows != 80 - YFPS2UART_EVENT_QUEUE_SIZE) ok = false;
+  }
+
+  printf("%-28s %10s %8u %10s %10.1f   %s (overflows=%u)\n", "button event queue", "-", (unsigned)frames, "-",
+         frames ? ns / (double)frames : 0.0, ok ? "ok" : "FAIL", (unsigned)overflows);
+  return ok;
+}
+#endif
+
+// SPSC 帧队列：生产者线程与消费者线程并发读写，校验无撕裂、无乱序、无丢失
+// 每帧负载由序号推导，消费者逐字节校验；生产者仅在 push 成功后推进序号，因此消费者必须看到连续序号
+bool checkSpscThreads(uint32_t frames) {
+  PS2FrameRing<16> ring;
+  bool ok = true;
+
+  Clock::time_point t0 = Clock::now();
+  std::thread producer([&ring, frames]() {
+    uint32_t seq = 0;
+    while (seq < frames) {
+      PS2Frame f;
+      for (int k = 0; k < 6; ++k) f.payload[k] = (uint8_t)(seq * 7 + k * 31);
+      f.timeMs = seq;
+      if (ring.push(f)) {
+        ++seq;
+      } else {
+        std::this_thread::yield();   // 单核主机上让出时间片给消费者
+      }
+    }
+  });
+  std::thread consumer([&ring, frames, &ok]() {
+    uint32_t expect = 0;
+    PS2Frame f;
+    while (expect < frames) {
+      if (!ring.pop(f)) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (f.timeMs != expect) ok = false;
+      for (int k = 0; k < 6; ++k) {
+        if (f.payload[k] != (uint8_t)(expect * 7 + k * 31)) ok = false;
+      }
+      ++expect;
+    }
+  });
+  producer.join();
+  consumer.join();
+  double ns = elapsedNs(t0);
+
+  // 消费者停顿时：容量以内不丢，超出部分计入 drops
+  PS2FrameRing<16> stalled;
+  PS2Frame f = PS2Frame();
+  for (int i = 0; i < 16; ++i) ok = ok && stalled.push(f);
+  ok = ok && !stalled.push(f) && stalled.drops() == 1 && stalled.size() == 16;
+
+  printf("%-28s %10s %8u %10s %10.1f   %s\n", "spsc ring 2 threads", "-", (unsigned)frames, "-",
+         ns / (double)frames, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// 回调接收模式：生产者 receiveFromISR() 入队，update() 出队，按键与摇杆结果与轮询模式一致
+bool checkCallbackMode(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  YFPS2UART ps2(&mem);
+  ps2.begin(115200);
+  ps2.beginCallbackReceive();
+
+  bool ok = true;
+  uint32_t presses = 0;
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t i = 0; i < frames; ++i) {
+    mem.inject(data.data() + i * 8, 8);
+    ps2.receiveFromISR();
+    ps2.update();
+    if (ps2.ButtonPressed(PSB_PAD_UP)) ++presses;
+    if (ps2.Analog(PSS_LY) != (uint8_t)(100 + (i % 50))) ok = false;
+    hostAdvanceMicros(10000);
+  }
+  double ns = elapsedNs(t0);
+  ok = ok && ps2.getRingDrops() == 0 && presses == frames / 16;   // 十字键“上”每 16 帧按下一次
+
+  printf("%-28s %10zu %8u %10.2f %10.1f   %s\n", "callback receive + ring", data.size(),
+         (unsigned)frames, ns / (double)data.size(), ns / (double)frames, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// 顺序锁：写者线程连续发布由序号推导的快照，读者线程并发读取，任何撕裂都会破坏字段间的关系
+bool checkSeqlockThreads(uint32_t writes) {
+  PS2Seqlock<PS2State> lock;
+  volatile bool done = false;
+  bool ok = true;
+  uint32_t reads = 0;
+
+  Clock::time_point t0 = Clock::now();
+  std::thread writer([&lock, &done, writes]() {
+    for (uint32_t i = 1; i <= writes; ++i) {
+      PS2State s;
+      s.seq = i;
+      s.timeMs = i * 3u;
+      s.buttons = (uint16_t)i;
+      s.axes = ~i;
+      lock.write(s);
+      if ((i & 63) == 0) std::this_thread::yield();
+    }
+    done = true;
+  });
+  uint32_t lastSeq = 0;
+  while (!done) {
+    PS2State s;
+    lock.read(s);
+    ++reads;
+    uint32_t i = s.seq;
+    if (i == 0) continue;
+    if (i < lastSeq || s.timeMs != i * 3u || s.buttons != (uint16_t)i || s.axes != ~i) {
+      ok = false;
+    }
+    lastSeq = i;
+    if ((reads & 63) == 0) std::this_thread::yield();
+  }
+  writer.join();
+  double ns = elapsedNs(t0);
+
+  printf("%-28s %10s %8u %10s %10.1f   %s (%u reads)\n", "seqlock 2 threads", "-",
+         (unsigned)writes, "-", ns / (double)writes, ok ? "ok" : "FAIL", (unsigned)reads);
+  return ok;
+}
+
+// 后台任务 + 顺序锁快照：任务线程解码并发布，主线程并发读取快照，
+// 校验每个快照内部一致（LX == 255 - LY，按键与摇杆来自同一帧）且帧序号单调不减
+bool checkBackgroundTask(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+  YFPS2UART ps2(&mem);
+  ps2.begin(115200);
+
+  bool ok = true;
+  uint32_t reads = 0;
+  uint32_t lastSeq = 0;
+  Clock::time_point t0 = Clock::now();
+  ok = ps2.startBackgroundTask(0, 2, 0);
+  for (;;) {
+    PS2State snap;
+    if (ps2.readSnapshot(snap)) {
+      ++reads;
+      if (snap.analog(PSS_LX) != (uint8_t)(255 - snap.analog(PSS_LY))) ok = false;
+      if (snap.seq < lastSeq) ok = false;
+      lastSeq = snap.seq;
+      if (snap.seq == frames) break;
+    }
+    hostAdvanceMicros(100);
+    std::this_thread::yield();
+  }
+  ps2.stopBackgroundTask();
+  double ns = elapsedNs(t0);
+
+  PS2State last;
+  ps2.readSnapshot(last);
+  ok = ok && last.analog(PSS_LY) == (uint8_t)(100 + ((frames - 1) % 50));
+
+  printf("%-28s %10zu %8u %10s %10.1f   %s (%u snapshot reads)\n", "background task + seqlock",
+         data.size(), (unsigned)frames, "-", ns / (double)frames, ok ? "ok" : "FAIL", (unsigned)reads);
+  return ok;
+}
+
+// 对象存储：软串口/硬串口/外部串口三种模式反复构造、begin()、update()、移动、析构，
+// 整个过程堆分配次数必须为 0，且 SoftwareSerial 的构造与析构配对（无泄漏、无重复析构）
+bool checkNoHeapAllocations(uint32_t cycles) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < 16; ++i) appendFrame(data, i);
+  MemorySerial mem;
+  mem.inject(data.data(), data.size());
+
+  unsigned long allocs0 = g_heapAllocs;
+  bool ok = true;
+  for (uint32_t c = 0; c < cycles; ++c) {
+    {
+      YFPS2UART sw(SERIALTYPE_SW, 11, 10);
+      sw.begin(9600);
+      sw.update();
+      YFPS2UART moved(static_cast<YFPS2UART&&>(sw));   // 移动构造：在目标对象中重建 SoftwareSerial
+      moved.update();
+      YFPS2UART hw(SERIALTYPE_HW, 0, 1, &Serial);
+      hw.begin(115200);
+      hw.update();
+      hw = static_cast<YFPS2UART&&>(moved);            // 移动赋值：先销毁 hw 的硬串口适配器
+      hw.update();
+      if (SoftwareSerial::live() != 1) ok = false;
+    }
+    {
+      mem.rewind();
+      YFPS2UART ext(&mem);
+      ext.begin(9600);
+      ext.setDrainMode(true);
+      ext.update();
+      YFPS2UART moved(static_cast<YFPS2UART&&>(ext));
+      moved.update();
+      if (moved.getRawButtons() != ((15u / 8u) << 4)) ok = false;   // 最后一帧的十字键
+    }
+    if (SoftwareSerial::live() != 0) ok = false;
+  }
+  unsigned long allocs = g_heapAllocs - allocs0;
+  ok = ok && allocs == 0;
+  printf("%-28s %10s %8u %10s %10s   %s (heap allocs=%lu, sizeof YFPS2UART=%zu)\n", "no-heap construct/destroy", "-",
+         (unsigned)cycles, "-", "-", ok ? "ok" : "FAIL", allocs, sizeof(YFPS2UART));
+  return ok;
+}
+
+// 多接收器：
+// 1) 3 个接收器各积压 300 帧，每次 poll() 预算 16 字节，任何时刻各接收器已解出帧数之差不超过 1；
+// 2) 2 个需要 listen() 的接收器（模拟 SoftwareSerial）+ 1 个硬串口，listen() 在帧边界轮转，所有帧完整解出；
+// 3) 一个软串口接收器没有数据（手柄断开）时按超时切走，另一个仍能收完所有帧
+bool checkMultiReceiver(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+  bool ok = true;
+
+  uint32_t polls = 0;
+  uint32_t maxSkew = 0;
+  Clock::time_point t0 = Clock::now();
+  {
+    MemorySerial mem[3];
+    YFPS2UARTMulti<3> multi;
+    for (int k = 0; k < 3; ++k) {
+      mem[k].inject(data.data(), data.size());
+      multi.add(&mem[k]);
+    }
+    multi.begin(115200);
+    uint32_t total = 0;
+    while (total < 3 * frames && polls < 10 * frames) {
+      total += multi.poll(16);
+      ++polls;
+      uint32_t lo = multi.state(0).seq, hi = lo;
+      for (int k = 1; k < 3; ++k) {
+        uint32_t q = multi.state(k).seq;
+        if (q < lo) lo = q;
+        if (q > hi) hi = q;
+      }
+      if (hi - lo > maxSkew) maxSkew = hi - lo;
+      hostAdvanceMicros(1000);
+    }
+    PS2ReceiverStats st;
+    multi.getStats(2, st);
+    ok = ok && total == 3 * frames && maxSkew <= 1 && st.starvedPolls > 0 && st.bytes == data.size() &&
+         multi.states() == &multi.state(0) && multi.state(1).axes == multi.state(2).axes;
+  }
+  double ns = elapsedNs(t0);
+
+  uint32_t switches = 0;
+  {
+    MemorySerial mem[3];
+    YFPS2UARTMulti<3> multi;
+    for (int k = 0; k < 3; ++k) {
+      mem[k].inject(data.data(), data.size());
+      mem[k].setNeedsListen(k != 1);
+      multi.add(&mem[k]);
+    }
+    multi.begin(9600);
+    bool exclusive = true;
+    for (uint32_t n = 0; n < 20 * frames; ++n) {
+      multi.poll(64);
+      if (mem[0].isListening() == mem[2].isListening()) exclusive = false;
+      hostAdvanceMicros(1000);
+    }
+    PS2ReceiverStats s0, s2;
+    multi.getStats(0, s0);
+    multi.getStats(2, s2);
+    PS2FrameCounters c;
+    multi[0].getFrameCounters(c);
+    switches = s0.listenSwitches + s2.listenSwitches;
+    ok = ok && exclusive && s0.frames == frames && multi.state(1).seq == frames && s2.frames == frames &&
+         c.shortFrames == 0 && c.longFrames == 0 && s0.listenSwitches > 1 && s2.listenSwitches > 1;
+  }
+  {
+    MemorySerial mem[2];
+    YFPS2UARTMulti<2> multi;
+    mem[1].inject(data.data(), data.size());
+    for (int k = 0; k < 2; ++k) {
+      mem[k].setNeedsListen(true);
+      multi.add(&mem[k]);
+    }
+    multi.setListenTimeoutMs(20);
+    multi.begin(9600);
+    for (uint32_t n = 0; n < 20 * frames; ++n) {
+      multi.poll(64);
+      hostAdvanceMicros(5000);
+    }
+    PS2ReceiverStats s0;
+    multi.getStats(0, s0);
+    ok = ok && multi.state(0).seq == 0 && multi.state(1).seq == frames && s0.listenSwitches > 1;
+  }
+  printf("%-28s %10zu %8u %10s %10.1f   %s (max skew=%u frames, %u listen switches)\n", "multi-receiver round-robin",
+         3 * data.size(), (unsigned)(3 * frames), "-", ns / (3.0 * frames), ok ? "ok" : "FAIL",
+         (unsigned)maxSkew, (unsigned)switches);
+  return ok;
+}
+
+// sendATCommandWithResponse()：9600 时响应排在模块已发出的帧之后到达，等待期间这些帧照常解码；响应超出缓冲时截断，
+// 无应答（AT+RST 后模块静默）时超时返回 false。开启与关闭 AT 队列时行为一致
+bool checkATWithResponse() {
+  PS2ModuleEmulator mod;   // 默认 9600
+  YFPS2UART ps2(&mod);
+  ps2.begin(9600);
+  for (int i = 0; i < 20; ++i) {
+    ps2.update();
+    hostAdvanceMicros(1000);
+  }
+  PS2FrameCounters before;
+  ps2.getFrameCounters(before);
+  char ver[16];
+  char shortBuf[4];
+  char none[16];
+  bool ok = ps2.sendATCommandWithResponse("AT+VER", ver, sizeof(ver), 100) && strcmp(ver, "V1.0") == 0;
+  ok = ps2.sendATCommandWithResponse("AT+VER", shortBuf, sizeof(shortBuf), 100) && strcmp(shortBuf, "V1.") == 0 && ok;
+  PS2FrameCounters after;
+  ps2.getFrameCounters(after);
+  uint32_t t0 = millis();
+  ok = !ps2.sendATCommandWithResponse("AT+RST", none, sizeof(none), 50) && none[0] == '\0' && ok;
+  uint32_t waited = millis() - t0;
+  ok = ok && waited >= 50 && waited < 60 && after.good > before.good && after.shortFrames == 0 &&
+       after.longFrames == 0;
+  printf("%-28s %10s %8u %10s %10s   %s\n", "AT with response + frames", "-",
+         (unsigned)(after.good - before.good), "-", "-", ok ? "ok" : "FAIL");
+  return ok;
+}
+
+#if YFPS2UART_ENABLE_AT_QUEUE
+// 非阻塞 AT：AT+VER（回调）与 AT+BAUD?（轮询句柄）排队发送，响应行夹在帧之间、并被拆成两段到达；
+// 等待期间每 10ms 一帧照常解出，且不产生坏帧。最后一条指令无人应答，应在超时后以 TIMEOUT 结束
+struct AtResult {
+  uint8_t status;
+  char text[YFPS2UART_AT_LINE_LEN];
+};
+
+void onAtDone(uint8_t handle, uint8_t status, const char* response, void* ctx) {
+  (void)handle;
+  AtResult* r = static_cast<AtResult*>(ctx);
+  r->status = status;
+  strncpy(r->text, response, sizeof(r->text) - 1);
+  r->text[sizeof(r->text) - 1] = '\0';
+}
+
+bool checkAsyncAT(uint32_t rounds) {
+  bool ok = true;
+  uint32_t frames = 0;
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t r = 0; r < rounds; ++r) {
+    MemorySerial mem;
+    YFPS2UART ps2(&mem);
+    AtResult ver = {PS2_AT_NONE, ""};
+    uint8_t hVer = ps2.submitAT("AT+VER", onAtDone, &ver);
+    uint8_t hBaud = ps2.submitAT("AT+BAUD?");
+    uint8_t hLost = ps2.submitAT("AT+NOREPLY", nullptr, nullptr, 100);
+    ok = ok && hVer && hBaud && hLost && ps2.getATPending() == 3;
+
+    std::vector<uint8_t> frame;
+    uint32_t injected = 0;
+    size_t answered = 0;
+    for (uint32_t i = 0; i < 40; ++i) {
+      frame.clear();
+      appendFrame(frame, i);
+      mem.inject(frame.data(), frame.size());
+      ++injected;
+      const std::string& tx = mem.txLog();
+      const char* reply = nullptr;
+      if (answered == 0 && tx.find("AT+VER\r\n") != std::string::npos) reply = "V1.2\r\n";
+      if (answered == 1 && tx.find("AT+BAUD?\r\n") != std::string::npos) reply = "115200\r\n";
+      if (reply) {
+        size_t half = strlen(reply) / 2;   // 响应行分两次到达，中间夹一次 update()
+        mem.inject((const uint8_t*)reply, half);
+        ps2.update();
+        mem.inject((const uint8_t*)reply + half, strlen(reply) - half);
+        ++answered;
+      }
+      ps2.update();
+      hostAdvanceMicros(10000);
+    }
+    ps2.update();
+    char baud[16];
+    PS2FrameCounters c;
+    ps2.getFrameCounters(c);
+    PS2State st;
+    ps2.getState(st);
+    frames += st.seq;
+    ok = ok && ver.status == PS2_AT_DONE && strcmp(ver.text, "V1.2") == 0 &&
+         ps2.getATStatus(hVer) == PS2_AT_NONE && ps2.getATStatus(hBaud) == PS2_AT_DONE &&
+         ps2.takeATResponse(hBaud, baud, sizeof(baud)) && strcmp(baud, "115200") == 0 &&
+         ps2.getATStatus(hLost) == PS2_AT_TIMEOUT && !ps2.takeATResponse(hLost, baud, sizeof(baud)) &&
+         ps2.getATPending() == 0 && st.seq == injected && c.good == injected && c.shortFrames == 0 &&
+         c.longFrames == 0 && mem.txLog() == "AT+VER\r\nAT+BAUD?\r\nAT+NOREPLY\r\n";
+  }
+  double ns = elapsedNs(t0);
+  printf("%-28s %10s %8u %10s %10.1f   %s\n", "async AT + frame stream", "-", (unsigned)frames, "-",
+         ns / (double)frames, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// sendATCommand() 经 AT 队列发送：不清空接收缓冲（已缓存的帧与等待中的响应都保留），
+// 有指令等待响应时排在其后发送，队列空闲时立即写出；不关心结果的指令完成后释放槽位
+bool checkSendATCommand(uint32_t rounds) {
+  bool ok = true;
+  for (uint32_t r = 0; r < rounds && ok; ++r) {
+    MemorySerial mem;
+    YFPS2UART ps2(&mem);
+    std::vector<uint8_t> data;
+    for (uint32_t i = 0; i < 4; ++i) appendFrame(data, i);
+    uint8_t hVer = ps2.submitAT("AT+VER");
+    ps2.update();   // 发出 AT+VER，等待响应
+    mem.inject(data.data(), data.size());
+    mem.inject((const uint8_t*)"V1", 2);   // 响应行到达一半
+    ok = ps2.sendSetBaud(115200) && ps2.sendResetCommand();
+    ok = ok && mem.txLog() == "AT+VER\r\n" && ps2.getATPending() == 3;
+    mem.inject((const uint8_t*)".2\r\n", 4);
+    for (int i = 0; i < 8; ++i) {
+      ps2.update();
+      hostAdvanceMicros(1000);
+    }
+    char ver[16];
+    PS2FrameCounters c;
+    ps2.getFrameCounters(c);
+    ok = ok && ps2.takeATResponse(hVer, ver, sizeof(ver)) && strcmp(ver, "V1.2") == 0 && c.good == 4 &&
+         mem.txLog() == "AT+VER\r\nAT+BAUD=115200\r\nAT+RST\r\n" && ps2.getATPending() == 0;
+
+    // 空闲时立即发送；反复发送不会占满队列
+    mem.clearTx();
+    for (uint32_t i = 0; i < 2 * YFPS2UART_AT_QUEUE_SIZE; ++i) ok = ps2.sendATCommand("AT") && ok;
+    ok = ok && mem.txLog().size() == 2 * YFPS2UART_AT_QUEUE_SIZE * 4 && ps2.getATPending() == 0;
+  }
+  printf("%-28s %10s %8u %10s %10s   %s\n", "sendATCommand via queue", "-", (unsigned)rounds, "-", "-",
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+#endif
+
+// 摇杆调理：一帧的摇杆值（RX, RY, LX, LY）经 feed() 解码
+static constexpr PS2Curve kBenchExpo = ps2ExpoCurve(200);
+static_assert(kBenchExpo.lut[0] == 0 && kBenchExpo.lut[255] == 127 && kBenchExpo.lut[128] < 64,
+              "expo curve is generated at compile time");
+
+void feedSticks(YFPS2UARTDecoder& dec, uint8_t rx, uint8_t ry, uint8_t lx, uint8_t ly) {
+  uint8_t payload[6] = {0, 0, ly, lx, ry, rx};
+  std::vector<uint8_t> f;
+  appendPayloadFrame(f, payload);
+  dec.feed(f.data(), f.size(), micros());
+  hostAdvanceMicros(10000);
+}
+
+bool checkStickConditioning(uint32_t frames) {
+  bool ok = true;
+  YFPS2UARTDecoder dec;
+  PS2State st;
+
+  // 默认：标称中心为 0，两端为 ±127，单调
+  int prev = -128;
+  for (int v = 0; v < 256; ++v) {
+    feedSticks(dec, (uint8_t)v, 127, 128, 127);
+    int s = dec.Stick(PSS_RX);
+    ok = ok && s >= prev && s >= -127 && s <= 127;
+    prev = s;
+  }
+  feedSticks(dec, 0, 255, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) == -127 && dec.Stick(PSS_RY) == 127 && dec.Stick(PSS_LX) == 0 && dec.Stick(PSS_LY) == 0;
+  dec.getState(st);
+  ok = ok && st.stick(PSS_RX) == -127 && st.stick(PSS_RY) == 127 && st.analog(PSS_RX) == 0;
+
+  // 轴向死区（原始计数 8）：死区内为 0，死区外从 1 附近开始，满偏仍为 127
+  dec.setStickDeadzone(8, PS2_DEADZONE_AXIAL, PS2_AXES_RIGHT);
+  feedSticks(dec, 136, 119, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) == 0 && dec.Stick(PSS_RY) == 0;
+  feedSticks(dec, 140, 127, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) > 0 && dec.Stick(PSS_RX) < 12;
+  feedSticks(dec, 255, 0, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) == 127 && dec.Stick(PSS_RY) == -127;
+
+  // 径向死区（原始计数 12）：单轴偏 11 在死区内；对角各偏 10 时每轴都在死区半径内，但合成幅值已在死区外
+  dec.setStickDeadzone(12, PS2_DEADZONE_RADIAL, PS2_AXES_LEFT);
+  feedSticks(dec, 128, 127, 139, 127);
+  ok = ok && dec.Stick(PSS_LX) == 0 && dec.Stick(PSS_LY) == 0;
+  feedSticks(dec, 128, 127, 138, 137);
+  ok = ok && dec.Stick(PSS_LX) > 0 && dec.Stick(PSS_LY) > 0;
+  feedSticks(dec, 128, 127, 160, 159);
+  int lx = dec.Stick(PSS_LX), ly = dec.Stick(PSS_LY);
+  ok = ok && lx > 0 && ly > 0 && (lx - ly) * (lx - ly) <= 4;   // 方向不变
+  feedSticks(dec, 128, 127, 255, 127);
+  ok = ok && dec.Stick(PSS_LX) == 127 && dec.Stick(PSS_LY) == 0;
+
+  // 响应曲线：编译期与运行时生成结果一致；中段输出低于线性
+  PS2Curve runtime;
+  ps2FillExpoCurve(runtime, 200);
+  ok = ok && memcmp(&runtime, &kBenchExpo, sizeof(runtime)) == 0;
+  dec.setStickDeadzone(0, PS2_DEADZONE_AXIAL, PS2_AXES_ALL);
+  feedSticks(dec, 192, 127, 128, 127);
+  int linear = dec.Stick(PSS_RX);
+  dec.setStickCurve(&kBenchExpo, PS2_AXIS_BIT(PSS_RX));
+  feedSticks(dec, 192, 127, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) < linear && dec.Stick(PSS_RX) > 0;
+  feedSticks(dec, 0, 127, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) == -127;
+  dec.setStickCurve(nullptr);
+
+  // 取反
+  dec.setStickInvert(PS2_AXIS_BIT(PSS_LY));
+  feedSticks(dec, 128, 127, 128, 0);
+  ok = ok && dec.Stick(PSS_LY) == 127;
+  dec.setStickInvert(0);
+
+  // 自动中心：静止值偏离标称中心 6，约 200 帧后收敛；推杆时中心不被拖走
+  dec.setStickAutoCenter(true, 12);
+  for (int i = 0; i < 200; ++i) feedSticks(dec, 134, 121, 128, 127);
+  ok = ok && dec.getStickCenter(PSS_RX) == 134 && dec.getStickCenter(PSS_RY) == 121 &&
+       dec.Stick(PSS_RX) == 0 && dec.Stick(PSS_RY) == 0;
+  for (int i = 0; i < 200; ++i) feedSticks(dec, 255, 121, 128, 127);
+  ok = ok && dec.getStickCenter(PSS_RX) == 134 && dec.Stick(PSS_RX) == 127;
+  feedSticks(dec, 0, 121, 128, 127);
+  ok = ok && dec.Stick(PSS_RX) == -127;
+  feedSticks(dec, 100, 100, 100, 100);
+  dec.centerSticks();
+  ok = ok && dec.getStickCenter(PSS_LX) == 100;
+
+  // 每帧开销：全部功能打开时解码 + 调理
+  dec.setStickAutoCenter(true, 12);
+  dec.setStickDeadzone(10, PS2_DEADZONE_RADIAL, PS2_AXES_ALL);
+  dec.setStickCurve(&kBenchExpo);
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+  Clock::time_point t0 = Clock::now();
+  for (size_t pos = 0; pos < data.size(); pos += 8) dec.feed(data.data() + pos, 8, micros());
+  double ns = elapsedNs(t0);
+  g_sink = (unsigned)dec.Stick(PSS_LY);
+  printf("%-28s %10s %8u %10s %10.1f   %s\n", "stick conditioning", "-", (unsigned)frames, "-",
+         ns / (double)frames, ok ? "ok" : "FAIL");
+  return ok;
+}
+
+// 摇杆滤波：逐轴标量 EMA（SWAR 版本的参考实现），s 为 Q8 状态，v 原地写回取整后的输出
+void emaScalar(uint16_t s[4], uint8_t v[4], uint8_t k) {
+  for (int i = 0; i < 4; ++i) {
+    s[i] = (uint16_t)(s[i] - (s[i] >> k) + ((uint16_t)v[i] << (8 - k)));
+    v[i] = (uint8_t)((s[i] + 128) >> 8);
+  }
+}
+
+struct FilterResponse {
+  int rise90;       // 阶跃 128 -> 255 后到达 90% 所需帧数
+  double jitter;    // 静止 128 ± 2 随机抖动时输出的标准差（计数）
+};
+
+FilterResponse measureFilter(uint8_t mode, uint8_t k, uint8_t beta) {
+  FilterResponse r = {-1, 0.0};
+  PS2StickFilter f;
+  f.configure(mode, k, beta);
+  uint32_t seed = 99;
+  double sum = 0, sum2 = 0;
+  int n = 0;
+  for (int i = 0; i < 20000; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    uint8_t x = (uint8_t)(126 + (seed >> 16) % 5);
+    uint8_t v[4] = {x, x, x, x};
+    f.process(v);
+    if (i >= 200) {
+      sum += v[0];
+      sum2 += (double)v[0] * v[0];
+      ++n;
+    }
+  }
+  r.jitter = sqrt(sum2 / n - (sum / n) * (sum / n));
+  for (int i = 0; i < 100; ++i) {
+    uint8_t v[4] = {128, 128, 128, 128};
+    f.process(v);
+  }
+  for (int i = 1; i <= 500; ++i) {
+    uint8_t v[4] = {255, 255, 255, 255};
+    f.process(v);
+    if (v[0] >= 243) {
+      r.rise90 = i;
+      break;
+    }
+  }
+  return r;
+}
+
+bool checkStickFilters(uint32_t frames) {
+  bool ok = true;
+
+  // SWAR 与逐轴计算逐位一致
+  uint32_t seed = 5;
+  for (uint8_t k = 0; k < 8; ++k) {
+    uint16_t ref[4] = {0, 0, 0, 0};
+    uint32_t lanes[2] = {0, 0};
+    for (int i = 0; i < 5000; ++i) {
+      uint8_t v[4];
+      for (int j = 0; j < 4; ++j) {
+        seed = seed * 1103515245u + 12345u;
+        v[j] = (uint8_t)(seed >> 16);
+      }
+      uint8_t w[4];
+      memcpy(w, v, 4);
+      emaScalar(ref, w, k);
+      lanes[0] = ps2EmaLanes(lanes[0], (uint32_t)v[0] | ((uint32_t)v[1] << 16), k);
+      lanes[1] = ps2EmaLanes(lanes[1], (uint32_t)v[2] | ((uint32_t)v[3] << 16), k);
+      ok = ok && (lanes[0] & 0xFFFF) == ref[0] && (lanes[0] >> 16) == ref[1] &&
+           (lanes[1] & 0xFFFF) == ref[2] && (lanes[1] >> 16) == ref[3];
+    }
+  }
+
+  // 阶跃响应与抖动：EMA 的上升时间符合 ceil(ln 0.1 / ln(1 - 2^-k))，k 越大越平滑；
+  // 自适应滤波静止时与同 k 的 EMA 一样平滑，阶跃时快得多
+  const char* rowNames[] = {"off", "ema k=1", "ema k=2", "ema k=3", "ema k=4", "adaptive k=3"};
+  FilterResponse rows[6];
+  rows[0] = measureFilter(PS2_FILTER_OFF, 0, 0);
+  ok = ok && rows[0].rise90 == 1 && rows[0].jitter > 1.3;
+  for (uint8_t k = 1; k <= 4; ++k) {
+    rows[k] = measureFilter(PS2_FILTER_EMA, k, 0);
+    int expect = (int)ceil(log(0.1) / log(1.0 - 1.0 / (double)(1 << k)));
+    ok = ok && rows[k].rise90 >= expect - 1 && rows[k].rise90 <= expect + 1 &&
+         rows[k].jitter < rows[k - 1].jitter;
+  }
+  rows[5] = measureFilter(PS2_FILTER_ADAPTIVE, 3, 32);
+  ok = ok && rows[5].jitter <= rows[3].jitter * 1.5 && rows[5].rise90 * 4 <= rows[3].rise90;
+
+  // 接入解码：Analog() 与 Stick() 读取的是滤波后的值
+  YFPS2UARTDecoder dec;
+  dec.setStickFilter(PS2_FILTER_EMA, 2);
+  feedSticks(dec, 128, 127, 128, 127);
+  feedSticks(dec, 255, 127, 128, 127);
+  ok = ok && dec.Analog(PSS_RX) == 160 && dec.Stick(PSS_RX) > 0 && dec.Stick(PSS_RX) < 64;
+  for (int i = 0; i < 40; ++i) feedSticks(dec, 255, 127, 128, 127);
+  ok = ok && dec.Analog(PSS_RX) == 255 && dec.Stick(PSS_RX) == 127;
+
+  // 每帧开销
+  std::vector<uint8_t> input(frames * 4);
+  for (size_t i = 0; i < input.size(); ++i) {
+    seed = seed * 1103515245u + 12345u;
+    input[i] = (uint8_t)(seed >> 16);
+  }
+  uint16_t ref[4] = {0, 0, 0, 0};
+  uint8_t out[4];
+  Clock::time_point t0 = Clock::now();
+  for (uint32_t i = 0; i < frames; ++i) {
+    memcpy(out, &input[i * 4], 4);
+    emaScalar(ref, out, 3);
+    g_sink = out[0];
+  }
+  double nsScalar = elapsedNs(t0);
+  const char* names[] = {"ema (swar)", "adaptive"};
+  const uint8_t modes[] = {PS2_FILTER_EMA, PS2_FILTER_ADAPTIVE};
+  double ns[2];
+  for (int m = 0; m < 2; ++m) {
+    PS2StickFilter f;
+    f.configure(modes[m], 3, 32);
+    uint8_t v[4];
+    t0 = Clock::now();
+    for (uint32_t i = 0; i < frames; ++i) {
+      memcpy(v, &input[i * 4], 4);
+      f.process(v);
+      g_sink = v[0];
+    }
+    ns[m] = elapsedNs(t0);
+  }
+  printf("%-28s %10s %8u %10s %10s   %s (ns/frame: scalar ema %.1f, %s %.1f, %s %.1f)\n", "stick filters", "-",
+         (unsigned)frames, "-", "-", ok ? "ok" : "FAIL", nsScalar / frames, names[0], ns[0] / frames, names[1],
+         ns[1] / frames);
+  for (int i = 0; i < 6; ++i) {
+    printf("    %-14s rise to 90%% in %3d frames, jitter stddev %.2f counts\n", rowNames[i], rows[i].rise90,
+           rows[i].jitter);
+  }
+  return ok;
+}
+
+// 变化检测：相同帧、阈值内抖动、回差、按键变化与 changedSince() 的多使用者用法
+void feedFrame(YFPS2UARTDecoder& dec, uint16_t buttons, uint8_t rx, uint8_t ry, uint8_t lx, uint8_t ly) {
+  uint8_t payload[6] = {(uint8_t)(buttons >> 8), (uint8_t)(buttons & 0xFF), ly, lx, ry, rx};
+  std::vector<uint8_t> f;
+  appendPayloadFrame(f, payload);
+  dec.feed(f.data(), f.size(), micros());
+  hostAdvanceMicros(10000);
+}
+
+bool checkChangeDetection(uint32_t frames) {
+  bool ok = true;
+  YFPS2UARTDecoder dec;
+  dec.setDebounceMs(0);
+  PS2Change c;
+
+  // 与初始状态相同的帧、阈值（默认 2）内的抖动都不算变化
+  feedFrame(dec, 0, 128, 127, 128, 127);
+  feedFrame(dec, 0, 129, 126, 128, 127);
+  feedFrame(dec, 0, 127, 127, 129, 128);
+  ok = ok && !dec.hasChanged() && dec.getChangeSeq() == 0;
+
+  // 超过阈值：报告对应轴，并以新值为基准
+  feedFrame(dec, 0, 131, 127, 128, 127);
+  ok = ok && dec.hasChanged(&c) && c.axes == PS2_AXIS_BIT(PSS_RX) && c.buttons == 0 && c.seq == 4;
+  ok = ok && !dec.hasChanged();
+  // 回差：在新基准 131 附近 ±1 抖动不报告，回到 129 才再次报告
+  feedFrame(dec, 0, 130, 127, 128, 127);
+  feedFrame(dec, 0, 132, 127, 128, 127);
+  feedFrame(dec, 0, 130, 127, 128, 127);
+  ok = ok && !dec.hasChanged();
+  feedFrame(dec, 0, 129, 127, 128, 127);
+  ok = ok && dec.hasChanged(&c) && c.axes == PS2_AXIS_BIT(PSS_RX);
+
+  // 每轴阈值
+  dec.setAxisThreshold(10, PS2_AXES_LEFT);
+  feedFrame(dec, 0, 129, 127, 137, 127);
+  ok = ok && !dec.hasChanged();
+  feedFrame(dec, 0, 129, 127, 138, 120);
+  ok = ok && dec.hasChanged(&c) && c.axes == PS2_AXIS_BIT(PSS_LX);
+
+  // 按键变化总会报告；多次变化在读取前累计
+  uint32_t seenA = dec.getChangeSeq();
+  uint32_t seenB = seenA;
+  feedFrame(dec, PSB_CROSS, 129, 127, 138, 120);
+  feedFrame(dec, PSB_CROSS, 129, 140, 138, 120);
+  ok = ok && dec.changedSince(seenA) && dec.changedSince(seenB);
+  ok = ok && dec.hasChanged(&c) && c.buttons == PSB_CROSS && c.axes == PS2_AXIS_BIT(PSS_RY);
+  seenA = dec.getChangeSeq();
+  ok = ok && !dec.changedSince(seenA) && dec.changedSince(seenB);
+  PS2State st;
+  dec.getState(st);
+  ok = ok && st.changeSeq == seenA && st.seq == seenA;
+
+  // 开销：大部分帧与上一帧相同（手柄静止），只有少数帧有变化
+  dec.setAxisThreshold(2);
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) {
+    uint8_t payload[6] = {0, (uint8_t)(((i / 50) & 1) ? 0x10 : 0), 127, 128, 127, 128};   // 每 50 帧按键翻转一次
+    if (i % 20 < 2) payload[5] = (uint8_t)(128 + (i % 20));   // 阈值内的抖动
+    appendPayloadFrame(data, payload);
+  }
+  dec.hasChanged();
+  uint32_t changes = 0;
+  Clock::time_point t0 = Clock::now();
+  for (size_t pos = 0; pos < data.size(); pos += 8) {
+    dec.feed(data.data() + pos, 8, micros());
+    if (dec.hasChanged()) ++changes;
+  }
+  double ns = elapsedNs(t0);
+  ok = ok && changes == (frames + 49) / 50;
+  printf("%-28s %10s %8u %10s %10.1f   %s (%u of %u frames changed)\n", "change detection", "-", (unsigned)frames,
+         "-", ns / (double)frames, ok ? "ok" : "FAIL", (unsigned)changes, (unsigned)frames);
+  return ok;
+}
+
+// 非阻塞震动：每毫秒 update() 一次并持续注入帧，记录每个发出字节的（相对）时间
+struct VibeLog {
+  std::vector<std::pair<uint32_t, uint8_t> > sent;
+  size_t txSeen;
+};
+
+void runVibe(YFPS2UART& ps2, MemorySerial& mem, VibeLog& log, uint32_t base, uint32_t untilMs, uint32_t& injected) {
+  std::vector<uint8_t> frame;
+  while (millis() - base < untilMs) {
+    uint32_t t = millis() - base;
+    if (t % 10 == 0) {
+      frame.clear();
+      appendFrame(frame, injected++);
+      mem.inject(frame.data(), frame.size());
+    }
+    ps2.update();
+    const std::string& tx = mem.txLog();
+    for (; log.txSeen < tx.size(); ++log.txSeen) {
+      log.sent.push_back(std::make_pair(t, (uint8_t)tx[log.txSeen]));
+    }
+    hostAdvanceMicros(1000);
+  }
+}
+
+bool checkVibrateQueue() {
+  MemorySerial mem;
+  YFPS2UART ps2(&mem);
+  VibeLog log;
+  log.txSeen = 0;
+  uint32_t injected = 0;
+  uint32_t base = millis();
+  bool ok = true;
+
+  // 同一指令连续请求只占一个槽位；间隔内已被覆盖的请求不再发送
+  for (int i = 0; i < 100; ++i) ok = ps2.queueVibrate(VIBRATE_LEFT) && ok;
+  ok = ok && ps2.getVibratePending() == 1;
+  runVibe(ps2, mem, log, base, 100, injected);
+  ps2.queueVibrate(VIBRATE_LEFT);
+  runVibe(ps2, mem, log, base, 700, injected);
+  ok = ok && ps2.getVibratePending() == 0;
+  // 间隔已过立即发送；间隔内的左、右合并为双
+  ps2.queueVibrate(VIBRATE_RIGHT);
+  runVibe(ps2, mem, log, base, 800, injected);
+  ps2.queueVibrate(VIBRATE_LEFT);
+  runVibe(ps2, mem, log, base, 900, injected);
+  ps2.queueVibrate(VIBRATE_RIGHT);
+  runVibe(ps2, mem, log, base, 2000, injected);
+  ok = ok && !ps2.queueVibrate(0x7F);
+
+  // 序列：左、停 200ms、右、双；播放期间的请求在序列结束后发送
+  static const PS2VibeStep kPattern[] = {{VIBRATE_LEFT, 0}, {0, 200}, {VIBRATE_RIGHT, 0}, {VIBRATE_BOTH, 0}};
+  ps2.playVibratePattern(kPattern, 4);
+  ok = ok && ps2.isVibratePatternPlaying();
+  runVibe(ps2, mem, log, base, 2100, injected);
+  ps2.queueVibrate(VIBRATE_RIGHT);
+  runVibe(ps2, mem, log, base, 3600, injected);
+  ok = ok && ps2.isVibratePatternPlaying();
+  runVibe(ps2, mem, log, base, 4000, injected);
+  ok = ok && !ps2.isVibratePatternPlaying();
+
+  // 循环序列直到 stopVibratePattern()
+  static const PS2VibeStep kPulse[] = {{VIBRATE_BOTH, 0}};
+  ps2.playVibratePattern(kPulse, 1, true);
+  runVibe(ps2, mem, log, base, 5300, injected);
+  ps2.stopVibratePattern();
+  ok = ok && !ps2.isVibratePatternPlaying();
+  runVibe(ps2, mem, log, base, 6000, injected);
+
+  static const std::pair<uint32_t, uint8_t> kExpected[] = {
+    {0, VIBRATE_LEFT}, {700, VIBRATE_RIGHT}, {1200, VIBRATE_BOTH},
+    {2000, VIBRATE_LEFT}, {2700, VIBRATE_RIGHT}, {3200, VIBRATE_BOTH}, {3701, VIBRATE_RIGHT},
+    {4201, VIBRATE_BOTH}, {4701, VIBRATE_BOTH}, {5201, VIBRATE_BOTH}};
+  const size_t nExpected = sizeof(kExpected) / sizeof(kExpected[0]);
+  ok = ok && log.sent.size() == nExpected;
+  for (size_t i = 0; ok && i < nExpected; ++i) {
+    ok = log.sent[i] == kExpected[i];
+  }
+  if (!ok) {
+    for (size_t i = 0; i < log.sent.size(); ++i) {
+      printf("  vibrate @%u: 0x%02X\n", (unsigned)log.sent[i].first, log.sent[i].second);
+    }
+  }
+
+  // 发送期间帧照常解码，没有被清空
+  PS2FrameCounters c;
+  ps2.getFrameCounters(c);
+  ok = ok && c.good == injected && c.shortFrames == 0 && c.longFrames == 0;
+  printf("%-28s %10s %8u %10s %10s   %s\n", "vibrate queue + patterns", "-", (unsigned)injected, "-", "-",
+         ok ? "ok" : "FAIL");
+  return ok;
+}
+
+PS2ModuleConfig moduleConfig(uint32_t baud, uint32_t maxBaud, bool applyOnReset) {
+  PS2ModuleConfig cfg;
+  cfg.baud = baud;
+  cfg.maxBaud = maxBaud;
+  cfg.applyOnReset = applyOnReset;
+  return cfg;
+}
+
+// 自动波特率：
+// 1) 模块 38400、本地从 9600 开始，靠帧同步探测到 38400；
+// 2) 手柄未连接（只有 0xAB），靠 AT+BAUD? 确认 9600；
+// 3) 模块最高 57600 且需 AT+RST 生效：115200 被拒绝后恢复，最终升级到 57600，帧率从 9600 的 120 帧/秒升到 200 帧/秒；
+// 4) 模块立即生效：直接升级到 115200
+bool checkAutoBaud() {
+  bool ok = true;
+  PS2BaudReport r[4];
+  uint32_t finals[4];
+  {
+    PS2ModuleEmulator mod(moduleConfig(38400, 115200, true));
+    YFPS2UART ps2(&mod);
+    ps2.begin(9600);
+    finals[0] = ps2.autoBaud(false, &r[0]);
+    ok = ok && finals[0] == 38400 && !r[0].viaAT && r[0].fpsBefore == 200 && r[0].fpsAfter == 200;
+  }
+  {
+    PS2ModuleEmulator mod(moduleConfig(9600, 115200, true));
+    mod.setConnected(false);
+    YFPS2UART ps2(&mod);
+    finals[1] = ps2.autoBaud(false, &r[1]);
+    ok = ok && finals[1] == 9600 && r[1].viaAT && r[1].fpsBefore == 0;
+  }
+  {
+    PS2ModuleEmulator mod(moduleConfig(9600, 57600, true));
+    YFPS2UART ps2(&mod);
+    ps2.begin(9600);
+    finals[2] = ps2.autoBaud(true, &r[2], 115200);
+    ok = ok && finals[2] == 57600 && mod.moduleBaud() == 57600 && r[2].detectedBaud == 9600 &&
+         r[2].fpsBefore == 120 && r[2].fpsAfter == 200;
+  }
+  {
+    PS2ModuleEmulator mod(moduleConfig(9600, 115200, false));
+    YFPS2UART ps2(&mod);
+    ps2.begin(9600);
+    finals[3] = ps2.autoBaud(true, &r[3], 115200);
+    ok = ok && finals[3] == 115200 && mod.moduleBaud() == 115200;
+  }
+  printf("%-28s %10s %8s %10s %10s   %s\n", "auto baud detect/upgrade", "-", "-", "-", "-", ok ? "ok" : "FAIL");
+  for (int i = 0; i < 4; ++i) {
+    printf("    detected=%-6u final=%-6u fps %u -> %u probes=%u%s\n", (unsigned)r[i].detectedBaud,
+           (unsigned)finals[i], (unsigned)r[i].fpsBefore, (unsigned)r[i].fpsAfter, (unsigned)r[i].probes,
+           r[i].viaAT ? " (via AT)" : "");
+  }
+  return ok;
+}
+
+// 端到端：应用每 pollUs 调用一次 update()，模块端按键状态每 holdUs（错开相位）切换一次，
+// 统计从状态改变到 getButtons() 反映的延迟，以及模块发出的帧中没有被解析成好帧的比例
+struct EmulatorRun {
+  std::vector<uint32_t> latencyUs;
+  uint32_t changes;
+  PS2ModuleCounters mod;
+  PS2FrameCounters dec;
+};
+
+EmulatorRun runEmulator(const PS2ModuleConfig& cfg, uint32_t pollUs, uint16_t debounceMs, uint32_t changes) {
+  EmulatorRun run;
+  run.changes = changes;
+  PS2ModuleEmulator mod(cfg);
+  YFPS2UART ps2(&mod);
+  ps2.begin(cfg.baud);
+  ps2.setDebounceMs(debounceMs);
+  for (uint32_t i = 0; i < changes; ++i) {
+    uint16_t want = (i & 1) ? 0 : PSB_CROSS;
+    mod.setButtons(want);
+    uint32_t holdUs = 80000 + (i * 1237) % 10000;
+    bool seen = false;
+    for (uint32_t t = 0; t < holdUs; t += pollUs) {
+      hostAdvanceMicros(pollUs);
+      ps2.update();
+      if (!seen && ps2.getButtons() == want) {
+        run.latencyUs.push_back(micros() - mod.stateChangeUs());
+        seen = true;
+      }
+    }
+  }
+  run.mod = mod.counters();
+  ps2.getFrameCounters(run.dec);
+  std::sort(run.latencyUs.begin(), run.latencyUs.end());
+  return run;
+}
+
+void printEmulatorRun(const char* name, const EmulatorRun& r) {
+  const std::vector<uint32_t>& l = r.latencyUs;
+  uint32_t lost = (r.mod.frames > r.dec.good) ? r.mod.frames - r.dec.good : 0;
+  printf("    %-24s seen=%u/%u latency min/p50/max=%u/%u/%u us  frames=%u good=%u lost=%.2f%%\n", name,
+         (unsigned)l.size(), (unsigned)r.changes, (unsigned)(l.empty() ? 0 : l.front()),
+         (unsigned)(l.empty() ? 0 : l[l.size() / 2]), (unsigned)(l.empty() ? 0 : l.back()),
+         (unsigned)r.mod.frames, (unsigned)r.dec.good, r.mod.frames ? 100.0 * lost / r.mod.frames : 0.0);
+}
+
+// 模块仿真器上的 update() 端到端测量：
+// 1) 9600 / 115200 无损伤：每次状态改变都被看到，不丢帧；延迟落在 [帧线上时间, 帧线上时间 + 帧周期 + 轮询周期] 内
+//    （状态改变要等下一帧开始发送，帧最后一个字节到达后下一次 update() 才能看到）；
+// 2) 去抖 30ms：延迟再加上去抖时间（按 10ms 节拍计，实际 20~30ms）；
+// 3) 噪声/截断/丢字节：好帧不超过完整帧，丢失只来自损伤帧及其邻帧，状态改变仍全部被看到；
+//    同一种子两次运行结果完全相同；
+// 4) 64 字节接收缓冲、应用每 50ms 才轮询一次：缓冲溢出造成丢帧，留在缓冲里的是旧帧，部分状态改变看不到；
+// 5) 断开 / 恢复、AT+VER 应答、震动字节记录
+bool checkModuleEmulator(uint32_t changes) {
+  bool ok = true;
+  printf("%-28s %10s %8u %10s %10s   ", "module emulator e2e", "-", (unsigned)changes, "-", "-");
+
+  PS2ModuleConfig slow;
+  EmulatorRun a = runEmulator(slow, 1000, 0, changes);
+  uint32_t wire = PS2ModuleEmulator(slow).frameWireUs();
+  ok = ok && a.latencyUs.size() == changes && a.latencyUs.front() >= wire &&
+       a.latencyUs.back() <= wire + wire + 1000 && a.mod.frames - a.dec.good <= 1;
+
+  PS2ModuleConfig fast;
+  fast.baud = 115200;
+  EmulatorRun b = runEmulator(fast, 1000, 0, changes);
+  wire = PS2ModuleEmulator(fast).frameWireUs();
+  ok = ok && b.latencyUs.size() == changes && b.latencyUs.front() >= wire &&
+       b.latencyUs.back() <= wire + fast.framePeriodUs + 1000 && b.mod.frames - b.dec.good <= 1;
+
+  EmulatorRun c = runEmulator(fast, 1000, 30, changes);
+  ok = ok && c.latencyUs.size() == changes && c.latencyUs.front() >= b.latencyUs.front() + 20000 &&
+       c.mod.frames - c.dec.good <= 1;
+
+  PS2ModuleConfig noisy = fast;
+  noisy.noisePerMille = 20;
+  noisy.truncatePerMille = 20;
+  noisy.dropPerMille = 2;
+  noisy.seed = 7;
+  EmulatorRun d = runEmulator(noisy, 1000, 0, changes);
+  EmulatorRun d2 = runEmulator(noisy, 1000, 0, changes);
+  uint32_t damaged = d.mod.frames - d.mod.intactFrames;
+  ok = ok && d.latencyUs.size() == changes && d.dec.good <= d.mod.intactFrames &&
+       d.dec.good + 2 * (damaged + d.mod.noiseBytes) >= d.mod.intactFrames && d.latencyUs == d2.latencyUs &&
+       d.dec.good == d2.dec.good && damaged > 0;
+
+  PS2ModuleConfig small = fast;
+  small.rxBufferSize = 64;
+  EmulatorRun e = runEmulator(small, 50000, 0, changes);
+  ok = ok && e.mod.overflowBytes > 0 && e.dec.good < e.mod.frames;
+
+  // 断开 / 恢复、AT+VER、震动
+  PS2ModuleEmulator mod(fast);
+  YFPS2UART ps2(&mod);
+  ps2.begin(115200);
+  char ver[16] = {0};
+  bool gotVer = ps2.sendATCommandWithResponse("AT+VER", ver, sizeof(ver), 100);
+  ok = ok && gotVer && strcmp(ver, "V1.0") == 0;
+  mod.setConnected(false);
+  for (int i = 0; i < 20; ++i) {
+    hostAdvanceMicros(1000);
+    ps2.update();
+  }
+  bool offline = !ps2.isRemoteConnected();
+  mod.setConnected(true);
+  for (int i = 0; i < 20; ++i) {
+    hostAdvanceMicros(1000);
+    ps2.update();
+  }
+  ok = ok && offline && ps2.isRemoteConnected() && mod.counters().abBytes > 0;
+  ps2.queueVibrate(VIBRATE_LEFT);
+  ps2.update();
+  ok = ok && mod.vibrations().size() == 1 && mod.vibrations()[0].second == VIBRATE_LEFT;
+
+  printf("%s\n", ok ? "ok" : "FAIL");
+  printEmulatorRun("9600, debounce 0", a);
+  printEmulatorRun("115200, debounce 0", b);
+  printEmulatorRun("115200, debounce 30ms", c);
+  printEmulatorRun("115200, impaired", d);
+  printf("      (truncated=%u noise bytes=%u dropped bytes=%u)\n", (unsigned)d.mod.truncated,
+         (unsigned)d.mod.noiseBytes, (unsigned)d.mod.droppedBytes);
+  printEmulatorRun("115200, rx 64B, poll 50ms", e);
+  printf("      (overflow bytes=%u)\n", (unsigned)e.mod.overflowBytes);
+  return ok;
+}
+
+// 旧版 isRemoteConnected() 的模型：夹在模块与库之间，检查时从串口读走并丢弃下一个 0x0D 之前的所有字节
+// （遇到 0xAB 记为断开），找到 0x0D 后把它留给 update() 作为新帧的起点；0xAB 同样转交给解析器。
+// 用于重现修改前的帧率
+class LegacyConnectTap final : public SerialBase {
+public:
+    explicit LegacyConnectTap(SerialBase* inner) : _inner(inner), _ignore(false) {}
+
+    void begin(unsigned long baud) override { _inner->begin(baud); }
+    int available() override { return (int)_pending.size() + _inner->available(); }
+    int read() override {
+        if (!_pending.empty()) {
+            uint8_t c = _pending.front();
+            _pending.erase(_pending.begin());
+            return c;
+        }
+        return _inner->read();
+    }
+    void write(uint8_t data) override { _inner->write(data); }
+    void print(const char* str) override { _inner->print(str); }
+    void flush() override { _inner->flush(); }
+
+    bool isRemoteConnected() {
+        bool sawAb = false;
+        _pending.clear();
+        int c;
+        while ((c = _inner->read()) >= 0) {
+            if (c == 0xAB) {
+                _ignore = true;
+                sawAb = true;
+            } else if (c == 0x0D) {
+                _ignore = false;
+                if (sawAb) _pending.push_back(0xAB);
+                _pending.push_back(0x0D);
+                return true;
+            }
+        }
+        if (sawAb) _pending.push_back(0xAB);
+        return !_ignore;
+    }
+
+private:
+    SerialBase* _inner;
+    std::vector<uint8_t> _pending;
+    bool _ignore;
+};
+
+enum DemoLoopLayout {
+    DEMO_UPDATE_ONLY,    // 只调用 update()（对照）
+    DEMO_UPDATE_FIRST,   // 现在的示例：update(); if (!isRemoteConnected()) return;
+    DEMO_CHECK_FIRST,    // 以前的示例：if (!isRemoteConnected()) return; update();
+    DEMO_LEGACY,         // 以前的示例 + 旧版会读串口的 isRemoteConnected()
+};
+
+struct DemoLoopResult {
+    double fps;            // 每秒解出的帧数
+    uint32_t sent;         // 模块发出的帧数
+    uint32_t afterGood;    // 重新连接后解出的帧数
+    uint32_t afterSent;    // 重新连接后模块发出的帧数
+};
+
+// 在模块模拟器上运行示例程序的 loop() 写法 2 秒（loopUs 为一次 loop() 的耗时）。
+// abMs 不为 0 时，手柄从 abFromMs 起断开 abMs 毫秒（模块改发 0xAB）
+DemoLoopResult runDemoLoop(uint32_t baud, uint32_t loopUs, DemoLoopLayout layout, uint32_t seconds,
+                           uint32_t abFromMs, uint32_t abMs) {
+  PS2ModuleConfig cfg;
+  cfg.baud = baud;
+  PS2ModuleEmulator mod(cfg);
+  LegacyConnectTap tap(&mod);
+  YFPS2UART ps2(layout == DEMO_LEGACY ? (SerialBase*)&tap : (SerialBase*)&mod);
+  ps2.begin(baud);
+  PS2FrameCounters c;
+  DemoLoopResult r = {0, 0, 0, 0};
+  uint8_t phase = abMs ? 0 : 2;   // 0 连接中，1 断开中，2 已重新连接
+  uint32_t t0 = micros();
+  while (micros() - t0 < seconds * 1000000UL) {
+    hostAdvanceMicros(loopUs);
+    uint32_t ms = (micros() - t0) / 1000;
+    if (phase == 0 && ms >= abFromMs) {
+      mod.setConnected(false);
+      phase = 1;
+    } else if (phase == 1 && ms >= abFromMs + abMs) {
+      mod.setConnected(true);
+      ps2.getFrameCounters(c);
+      r.afterGood = c.good;
+      r.afterSent = mod.counters().frames;
+      phase = 2;
+    }
+    switch (layout) {
+      case DEMO_UPDATE_ONLY:
+        ps2.update();
+        break;
+      case DEMO_UPDATE_FIRST:
+        ps2.update();
+        if (!ps2.isRemoteConnected()) continue;
+        break;
+      case DEMO_CHECK_FIRST:
+        if (!ps2.isRemoteConnected()) continue;
+        ps2.update();
+        break;
+      case DEMO_LEGACY:
+        if (!tap.isRemoteConnected()) continue;
+        ps2.update();
+        break;
+    }
+  }
+  ps2.getFrameCounters(c);
+  r.fps = c.good / (double)seconds;
+  r.sent = mod.counters().frames;
+  r.afterGood = c.good - r.afterGood;
+  r.afterSent = r.sent - r.afterSent;
+  return r;
+}
+
+// isRemoteConnected() 只读取解析状态：示例程序两种写法解出的帧数都与只调用 update() 相同，不丢帧
+// （最多差正在发送的最后一帧）；旧版会读走帧头前的字节，打断 update() 正在接收的帧（9600 时丢帧）。
+// 断开 300ms 再重新连接：先 update() 的写法重新连接后照常解帧；先 isRemoteConnected() 的写法在断开期间
+// 每隔 lostMs 仍会调用一次 update()（状态过时后返回 true），重新连接后同样解出全部帧（最多晚 lostMs）
+bool checkDemoLoop(uint32_t seconds) {
+  bool ok = true;
+  printf("%-28s %10s %8s %10s %10s   ", "demo loop frames/s", "-", "-", "-", "-");
+  static const uint32_t kBauds[] = {9600, 115200};
+  static const uint32_t kLoopUs[] = {200, 1000, 3000};
+  char lines[8][128];
+  size_t n = 0;
+  for (size_t b = 0; b < 2; ++b) {
+    for (size_t l = 0; l < 3; ++l) {
+      double plain = runDemoLoop(kBauds[b], kLoopUs[l], DEMO_UPDATE_ONLY, seconds, 0, 0).fps;
+      DemoLoopResult first = runDemoLoop(kBauds[b], kLoopUs[l], DEMO_UPDATE_FIRST, seconds, 0, 0);
+      double check = runDemoLoop(kBauds[b], kLoopUs[l], DEMO_CHECK_FIRST, seconds, 0, 0).fps;
+      double legacy = runDemoLoop(kBauds[b], kLoopUs[l], DEMO_LEGACY, seconds, 0, 0).fps;
+      ok = ok && first.fps == plain && check == plain && first.fps * seconds + 1 >= first.sent;
+      if (kBauds[b] == 9600) ok = ok && legacy < plain;
+      snprintf(lines[n++], sizeof(lines[0]),
+               "    %6u baud, loop %4u us: update-first %.1f  check-first %.1f  legacy %.1f  update-only %.1f  sent %.1f",
+               (unsigned)kBauds[b], (unsigned)kLoopUs[l], first.fps, check, legacy, plain,
+               first.sent / (double)seconds);
+    }
+  }
+  for (size_t b = 0; b < 2; ++b) {
+    DemoLoopResult first = runDemoLoop(kBauds[b], 1000, DEMO_UPDATE_FIRST, seconds, 500, 300);
+    DemoLoopResult check = runDemoLoop(kBauds[b], 1000, DEMO_CHECK_FIRST, seconds, 500, 300);
+    ok = ok && first.afterSent > 0 && first.afterGood + 1 >= first.afterSent && check.afterSent > 0 &&
+         check.afterGood + 1 >= check.afterSent;
+    snprintf(lines[n++], sizeof(lines[0]),
+             "    %6u baud, 0xAB 300 ms, frames after reconnect: update-first %u  check-first %u  sent %u",
+             (unsigned)kBauds[b], (unsigned)first.afterGood, (unsigned)check.afterGood, (unsigned)first.afterSent);
+  }
+  printf("%s\n", ok ? "ok" : "FAIL");
+  for (size_t i = 0; i < n; ++i) printf("%s\n", lines[i]);
+  return ok;
+}
+
+struct LinkLog {
+  std::vector<uint32_t> atMs;
+  std::vector<std::pair<uint8_t, uint8_t> > changes;
+};
+
+void onLinkChange(uint8_t from, uint8_t to, void* ctx) {
+  LinkLog* log = static_cast<LinkLog*>(ctx);
+  log->atMs.push_back(millis());
+  log->changes.push_back(std::make_pair(from, to));
+}
+
+// 链路中断期间的释放回调（事件队列可能被编译开关移除，这里用回调记录）
+struct LossReleases {
+  bool armed;
+  uint16_t buttons;
+};
+
+void onLossRelease(const PS2Event& ev, void* ctx) {
+  LossReleases* r = static_cast<LossReleases*>(ctx);
+  if (r->armed) r->buttons |= ev.button;
+}
+
+// 链路监测与失效保护（9600 波特率、1ms 轮询，按住 × 并把右摇杆推到底）：
+// 1) 上电为 Lost，连续 3 个好帧后 Connected；
+// 2) 截断 30% 的帧 -> Degraded（坏帧比例超过 10%）；恢复后 -> Connected；
+// 3) 截断 4% 的帧：处于两个阈值之间，回差使状态保持 Connected；
+// 4) 模块断电 -> Lost：失效保护在最后一个好帧后 lostMs + 一个轮询周期内释放按键（有释放事件）、摇杆回中；
+//    恢复供电 -> Connected，按键经去抖后重新按下；
+// 5) 手柄断开（0xAB）-> Disconnected（同样触发失效保护），重新连接 -> Connected，断开时长计入统计
+bool checkLinkMonitor() {
+  bool ok = true;
+  printf("%-28s %10s %8s %10s %10s   ", "link monitor + failsafe", "-", "-", "-", "-");
+
+  PS2ModuleEmulator mod;
+  YFPS2UART ps2(&mod);
+  ps2.begin(9600);
+  ps2.setDebounceMs(0);
+  ps2.setFailsafe(true);
+  LinkLog log;
+  ps2.onLinkChange(onLinkChange, &log);
+  LossReleases releases = {false, 0};
+  ps2.onRelease(0xFFFF, onLossRelease, &releases);
+  PS2LinkConfig cfg;
+  ps2.setLinkConfig(cfg);
+  ok = ok && ps2.getLinkState() == PS2_LINK_LOST && ps2.isFailsafeActive();
+
+  mod.setButtons(PSB_CROSS);
+  mod.setStick(PSS_RX, 255);
+  uint32_t startMs = millis();
+  uint32_t lastGoodMs = 0, good = 0;
+  uint32_t lostGap = 0, disconnectGap = 0;
+  uint16_t clean = 0;
+  for (uint32_t ms = 0; ms < 6500; ++ms) {
+    if (ms == 500) mod.setImpairments(0, 300, 0);
+    if (ms == 2000) mod.setImpairments(0, 0, 0);
+    if (ms == 3500) mod.setPowered(false);
+    if (ms == 4000) mod.setPowered(true);
+    if (ms == 4500) mod.setConnected(false);
+    if (ms == 5000) mod.setConnected(true);
+    if (ms == 5500) mod.setImpairments(0, 40, 0);
+    hostAdvanceMicros(1000);
+    releases.armed = (ms >= 3500 && ms < 4000) || (ms >= 4500 && ms < 5000);
+    ps2.update();
+    PS2FrameCounters c;
+    ps2.getFrameCounters(c);
+    if (c.good != good) {
+      good = c.good;
+      lastGoodMs = millis();
+    }
+    bool safe = ps2.getButtons() == 0 && ps2.Stick(PSS_RX) == 0;
+    if (ms >= 3500 && ms < 4000 && !lostGap && safe) lostGap = millis() - lastGoodMs;
+    if (ms >= 4500 && ms < 5000 && !disconnectGap && safe) disconnectGap = millis() - lastGoodMs;
+    if (ms == 3499 || ms == 4499) {
+      ok = ok && ps2.getButtons() == PSB_CROSS && ps2.Stick(PSS_RX) == 127 && !ps2.isFailsafeActive();
+      if (ms == 3499) clean = ps2.getLinkState();
+    }
+  }
+
+#if YFPS2UART_LINK_BUCKETS > 0
+  static const uint8_t kExpected[][2] = {
+      {PS2_LINK_LOST, PS2_LINK_CONNECTED},      {PS2_LINK_CONNECTED, PS2_LINK_DEGRADED},
+      {PS2_LINK_DEGRADED, PS2_LINK_CONNECTED},  {PS2_LINK_CONNECTED, PS2_LINK_LOST},
+      {PS2_LINK_LOST, PS2_LINK_CONNECTED},      {PS2_LINK_CONNECTED, PS2_LINK_DISCONNECTED},
+      {PS2_LINK_DISCONNECTED, PS2_LINK_CONNECTED},
+  };
+#else
+  // 不保留滑动窗口：坏帧多时不进入 Degraded，只有间隙与 0xAB 驱动状态
+  static const uint8_t kExpected[][2] = {
+      {PS2_LINK_LOST, PS2_LINK_CONNECTED},      {PS2_LINK_CONNECTED, PS2_LINK_LOST},
+      {PS2_LINK_LOST, PS2_LINK_CONNECTED},      {PS2_LINK_CONNECTED, PS2_LINK_DISCONNECTED},
+      {PS2_LINK_DISCONNECTED, PS2_LINK_CONNECTED},
+  };
+#endif
+  const size_t n = sizeof(kExpected) / sizeof(kExpected[0]);
+  ok = ok && log.changes.size() == n;
+  for (size_t i = 0; ok && i < n; ++i) {
+    ok = log.changes[i].first == kExpected[i][0] && log.changes[i].second == kExpected[i][1];
+  }
+  PS2LinkStats st;
+  ps2.getLinkStats(st);
+  ok = ok && n == log.atMs.size() && log.atMs[0] - startMs <= 40 && clean == PS2_LINK_CONNECTED &&
+       lostGap >= cfg.lostMs && lostGap <= cfg.lostMs + 1u && disconnectGap > 0 && disconnectGap <= 20 &&
+       releases.buttons == PSB_CROSS && st.state == PS2_LINK_CONNECTED && st.disconnects == 1 &&
+       st.disconnectedMs >= 480 && st.disconnectedMs <= 540 && st.transitions == n && st.corruptFrames > 0 &&
+       st.maxGapMs >= 500 && ps2.getButtons() == PSB_CROSS;
+#if YFPS2UART_LINK_BUCKETS > 0
+  ok = ok && log.atMs[1] - startMs < 2000 && log.atMs[2] - startMs > 2000 && log.atMs[2] - startMs < 3500 &&
+       st.frameRateHz >= 100 && st.frameRateHz <= 125;
+#else
+  ok = ok && st.frameRateHz == 0 && st.badPermille == 0;
+#endif
+
+  printf("%s\n", ok ? "ok" : "FAIL");
+  static const char* const kNames[] = {"Disconnected", "Lost", "Degraded", "Connected"};
+  for (size_t i = 0; i < log.changes.size(); ++i) {
+    printf("    %6u ms  %-12s -> %s\n", (unsigned)(log.atMs[i] - startMs), kNames[log.changes[i].first & 3],
+           kNames[log.changes[i].second & 3]);
+  }
+  printf("    failsafe after last good frame: power loss %u ms, 0xAB %u ms (lostMs %u); "
+         "window %u frames/s, %u/1000 bad, corrupt=%u\n",
+         (unsigned)lostGap, (unsigned)disconnectGap, (unsigned)cfg.lostMs, (unsigned)st.frameRateHz,
+         (unsigned)st.badPermille, (unsigned)st.corruptFrames);
+  return ok;
+}
+
+// 按键时间线：(相对第一条记录的时间, 按键值)
+typedef std::vector<std::pair<uint32_t, uint16_t> > ButtonTimeline;
+
+struct CaptureRun {
+  PS2FrameCounters counters;
+  ButtonTimeline buttons;
+};
+
+// 应用每 1ms 调用一次 update()，记录 getButtons() 的变化
+void pollTimeline(YFPS2UART& ps2, uint32_t ms, uint32_t originUs, CaptureRun& run) {
+  uint16_t last = run.buttons.empty() ? 0 : run.buttons.back().second;
+  for (uint32_t i = 0; i < ms; ++i) {
+    hostAdvanceMicros(1000);
+    ps2.update();
+    uint16_t b = (uint16_t)ps2.getButtons();
+    if (b != last) {
+      run.buttons.push_back(std::make_pair(micros() - originUs, b));
+      last = b;
+    }
+  }
+  ps2.getFrameCounters(run.counters);
+}
+
+void appendBlock(void* ctx, const uint8_t* block, uint16_t len) {
+  std::vector<uint8_t>* file = static_cast<std::vector<uint8_t>*>(ctx);
+  file->insert(file->end(), block, block + len);
+}
+
+bool sameCounters(const PS2FrameCounters& a, const PS2FrameCounters& b) {
+  return a.good == b.good && a.shortFrames == b.shortFrames && a.longFrames == b.longFrames &&
+         a.resynced == b.resynced && a.noiseBytes == b.noiseBytes;
+}
+
+// 录制与回放：
+// 1) 有损伤的模块数据按原始字节录制（RAM 环 + 文件 sink），按原始时间回放：解析计数与按键时间线完全一致；
+//    10 倍速回放：解析计数一致；文件内容与 RAM 环解出的记录一致；
+// 2) 按帧录制：回放后好帧数、短帧数、长帧数分别一致，每帧平均占用字节数远小于原始 8 字节；
+// 3) 小环：最旧的块被覆盖，剩下的块序号连续、时间单调
+bool checkCaptureReplay(uint32_t ms) {
+  bool ok = true;
+  PS2ModuleConfig cfg;
+  cfg.noisePerMille = 10;
+  cfg.truncatePerMille = 10;
+  cfg.dropPerMille = 1;
+  cfg.seed = 3;
+
+  std::vector<uint8_t> store(2048 * PS2Capture::kBlockSize);
+  std::vector<uint8_t> file;
+  CaptureRun orig, replay1, replay10;
+  uint32_t rawRecords = 0;
+  uint32_t origin = 0;
+  {
+    PS2ModuleEmulator mod(cfg);
+    YFPS2UART ps2(&mod);
+    ps2.begin(cfg.baud);
+    PS2Capture cap(store.data(), store.size());
+    cap.setSink(appendBlock, &file);
+    ps2.setCapture(&cap, PS2_CAPTURE_RAW);
+    origin = micros();
+    for (uint32_t t = 0; t < ms; t += 100) {
+      mod.setButtons((t / 100) & 1 ? 0 : PSB_CROSS);
+      pollTimeline(ps2, 100, origin, orig);
+    }
+    ps2.setCapture(nullptr);
+    cap.finish();
+    rawRecords = cap.recordCount();
+
+    PS2CaptureReader fromRing(cap);
+    PS2CaptureReader fromFile(file.data(), file.size());
+    PS2CaptureRecord a, b;
+    uint32_t n = 0;
+    bool same = true;
+    while (fromRing.next(a)) {
+      same = same && fromFile.next(b) && a.timeUs == b.timeUs && a.len == b.len && memcmp(a.data, b.data, a.len) == 0;
+      ++n;
+    }
+    ok = ok && same && !fromFile.next(b) && n == rawRecords && cap.overwrittenBlocks() == 0;
+  }
+  PS2CaptureRecord first;
+  PS2CaptureReader reader(file.data(), file.size());
+  reader.next(first);
+  {
+    PS2ReplaySerial serial(reader, 1);
+    YFPS2UART ps2(&serial);
+    // 去抖按 millis() 的 10ms 节拍计时：让回放开始时刻与第一条记录相差 10ms 的整数倍，节拍相位相同
+    hostSetMicros(first.timeUs + ((micros() - first.timeUs) / 10000 + 1) * 10000);
+    ps2.begin(9600);
+    // 第一条记录在 begin() 时可读：此刻先轮询一次，之后与录制时一样每 1ms 轮询，读到的数据块完全相同；
+    // 时间线换算到录制时的时基
+    ps2.update();
+    pollTimeline(ps2, ms, micros() - (first.timeUs - origin), replay1);
+    ok = ok && serial.finished();
+  }
+  {
+    PS2ReplaySerial serial(reader, 10);
+    YFPS2UART ps2(&serial);
+    ps2.setDrainMode(true);   // 10 倍速时每 1ms 到达约 1 帧以上，读空积压
+    ps2.begin(9600);
+    pollTimeline(ps2, ms / 10 + 10, micros(), replay10);
+    ok = ok && serial.finished();
+  }
+  ok = ok && orig.counters.good > 0 && orig.counters.longFrames + orig.counters.shortFrames > 0 &&
+       sameCounters(orig.counters, replay1.counters) && sameCounters(orig.counters, replay10.counters) &&
+       orig.buttons.size() == replay1.buttons.size();
+  for (size_t i = 0; ok && i < orig.buttons.size(); ++i) {
+    ok = orig.buttons[i] == replay1.buttons[i];
+  }
+
+  // 按帧录制
+  PS2FrameCounters frameOrig, frameReplay;
+  uint32_t frameBlocks = 0;
+  {
+    PS2ModuleEmulator mod(cfg);
+    YFPS2UART ps2(&mod);
+    ps2.begin(cfg.baud);
+    PS2Capture cap(store.data(), store.size());
+    ps2.setCapture(&cap, PS2_CAPTURE_FRAMES);
+    CaptureRun run;
+    for (uint32_t t = 0; t < ms; t += 100) {
+      mod.setButtons((t / 100) & 1 ? 0 : PSB_CROSS);
+      mod.setStick(PSS_RX, (uint8_t)(t / 100 * 7));
+      pollTimeline(ps2, 100, 0, run);
+    }
+    frameOrig = run.counters;
+    ps2.setCapture(nullptr);
+    cap.finish();
+    frameBlocks = cap.blockCount();
+
+    PS2CaptureReader r(cap);
+    PS2ReplaySerial serial(r, 0);
+    YFPS2UART replay(&serial);
+    replay.setDrainMode(true);
+    replay.begin(9600);
+    replay.update();
+    replay.getFrameCounters(frameReplay);
+    ok = ok && serial.finished();
+  }
+  double bytesPerFrame = frameOrig.good ? (double)frameBlocks * PS2Capture::kBlockSize / frameOrig.good : 0;
+  ok = ok && frameReplay.good == frameOrig.good && frameOrig.shortFrames > 0 && frameOrig.longFrames > 0 &&
+       frameReplay.shortFrames == frameOrig.shortFrames && frameReplay.longFrames == frameOrig.longFrames &&
+       bytesPerFrame < 6.0;
+
+  // 小环：只保留最近 4 块
+  uint8_t small[4 * PS2Capture::kBlockSize];
+  PS2Capture ring(small, sizeof(small));
+  uint8_t payload[6] = {0, 0, 127, 128, 127, 128};
+  for (uint32_t i = 0; i < 1000; ++i) {
+    payload[5] = (uint8_t)i;
+    ring.recordFrame(payload, i * 5000);
+  }
+  ring.finish();
+  PS2CaptureReader rr(ring);
+  PS2CaptureRecord rec;
+  uint32_t prevUs = 0, n = 0;
+  bool monotonic = true;
+  while (rr.next(rec)) {
+    monotonic = monotonic && (n == 0 || rec.timeUs == prevUs + 5000) && rec.data[5] == (uint8_t)(rec.timeUs / 5000);
+    prevUs = rec.timeUs;
+    ++n;
+  }
+  ok = ok && ring.blockCount() == 4 && ring.overwrittenBlocks() > 0 && rr.lostBlocks() == 0 && monotonic &&
+       prevUs == 999 * 5000;
+
+  printf("%-28s %10u %8u %10s %10s   %s (raw %u records in %u bytes, frames %.2f bytes/frame, %u blocks overwritten)\n",
+         "capture + replay", (unsigned)file.size(), (unsigned)orig.counters.good, "-", "-", ok ? "ok" : "FAIL",
+         (unsigned)rawRecords, (unsigned)file.size(), bytesPerFrame, (unsigned)ring.overwrittenBlocks());
+  return ok;
+}
+
+#if YFPS2UART_STATS
+void printHistogram(const char* name, const PS2Histogram& h) {
+  printf("    %-22s n=%-8u min=%-8u p50=%-8u p99=%-8u max=%u us\n", name, (unsigned)h.count,
+         (unsigned)(h.count ? h.minUs : 0), (unsigned)h.p50(), (unsigned)h.p99(), (unsigned)h.maxUs);
+}
+
+// 时序统计：回调模式下每 10ms 解出一帧，应用每 3 帧（延后 2ms）消费一次，
+// 帧间隔应集中在 10ms；延迟只统计交给应用的最新帧，应为 2ms
+bool checkTimingStats(uint32_t frames) {
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < frames; ++i) appendFrame(data, i);
+
+  MemorySerial mem;
+  YFPS2UART ps2(&mem);
+  ps2.beginCallbackReceive();
+  uint32_t gap = 10000;
+  for (uint32_t i = 0; i < frames; ++i) {
+    mem.inject(data.data() + i * 8, 8);
+    hostAdvanceMicros(gap);
+    gap = 10000;
+    ps2.receiveFromISR();
+    if (i % 3 == 2) {
+      hostAdvanceMicros(2000);
+      ps2.update();
+      gap = 8000;
+    }
+  }
+  PS2Stats st;
+  ps2.getStats(st);
+  bool ok = st.frames == frames - frames % 3 && st.frameInterval.p50() == 10000 &&
+            st.frameInterval.p99() == 10000 && st.latency.minUs == 2000 && st.latency.maxUs == 2000;
+  printf("%-28s %10s %8u %10s %10s   %s\n", "timing stats histograms", "-", (unsigned)frames, "-", "-",
+         ok ? "ok" : "FAIL");
+  printHistogram("frame interval", st.frameInterval);
+  printHistogram("decode->update latency", st.latency);
+  printHistogram("update() time", st.updateTime);
+
+  ps2.resetStats();
+  ps2.getStats(st);
+  ok = ok && st.frames == 0 && st.latency.count == 0;
+  return ok;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv) {
+  uint32_t scale = (argc > 1) ? (uint32_t)atoi(argv[1]) : 1;
+  if (scale == 0) scale = 1;
+
+  printf("%-28s %10s %8s %10s %10s\n", "scenario", "bytes", "frames", "ns/byte", "ns/frame");
+  benchCleanStream(200000 * scale);
+  const uint32_t depths[] = {1, 4, 16, 64};
+  for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+    benchBacklog(depths[i], 100000 * scale, false);
+  }
+  for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i) {
+    benchBacklog(depths[i], 100000 * scale, true);
+  }
+  benchAccessors(1000000 * scale);
+  bool dispatchOk = benchButtonDispatch(200000 * scale);
+  benchDisconnect(50000 * scale);
+  benchResync(50000 * scale);
+
+  bool ok = dispatchOk;
+  ok = checkHandlerTable() && ok;
+  ok = checkDefaultPathAxes(1000 * scale) && ok;
+  ok = checkPayloadTransparency(100000 * scale) && ok;
+  ok = checkTruncatedFrames(10000 * scale) && ok;
+  ok = checkFeed(100000 * scale) && ok;
+  ok = checkIndependentDebounce(1000 * scale) && ok;
+#if YFPS2UART_ENABLE_EVENTS
+  ok = checkButtonEvents(1000 * scale) && ok;
+#endif
+  ok = checkSpscThreads(1000000 * scale) && ok;
+  ok = checkCallbackMode(10000 * scale) && ok;
+  ok = checkSeqlockThreads(2000000 * scale) && ok;
+  ok = checkBackgroundTask(200000 * scale) && ok;
+  ok = checkNoHeapAllocations(1000 * scale) && ok;
+  ok = checkMultiReceiver(300 * scale) && ok;
+  ok = checkATWithResponse() && ok;
+#if YFPS2UART_ENABLE_AT_QUEUE
+  ok = checkAsyncAT(100 * scale) && ok;
+  ok = checkSendATCommand(10 * scale) && ok;
+#endif
+  ok = checkAutoBaud() && ok;
+  ok = checkModuleEmulator(200 * scale) && ok;
+  ok = checkLinkMonitor() && ok;
+  ok = checkDemoLoop(2 * scale) && ok;
+  ok = checkCaptureReplay(5000 * scale) && ok;
+  ok = checkVibrateQueue() && ok;
+  ok = checkStickConditioning(200000 * scale) && ok;
+  ok = checkStickFilters(1000000 * scale) && ok;
+  ok = checkChangeDetection(200000 * scale) && ok;
+#if YFPS2UART_STATS
+  ok = checkTimingStats(3000 * scale) && ok;
+#endif
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+// Arduino.h（主机端最小兼容层）
+// 仅用于在 Linux 上编译 src/ 下的库代码做基准测试，不是完整的 Arduino 核心。
+// 时间由虚拟时钟驱动：millis()/micros() 只在 hostSetMicros()/hostAdvanceMicros()/delay() 时前进。
+#ifndef YFPS2UART_HOST_ARDUINO_H
+#define YFPS2UART_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define DEC 10
+#define HEX 16
+#define F(s) (s)
+
+// 虚拟时钟
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void hostSetMicros(uint32_t us);
+void hostAdvanceMicros(uint32_t us);
+
+// 最小 HardwareSerial：本地打印到 stdout，接收端始终为空
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t data) { return fwrite(&data, 1, 1, stdout); }
+    size_t print(const char* str) { return fputs(str, stdout) < 0 ? 0 : strlen(str); }
+    size_t print(long v, int base = DEC) { return printf(base == HEX ? "%lx" : "%ld", v); }
+    size_t println(const char* str = "") { return print(str) + print("\n"); }
+    size_t println(long v, int base = DEC) { return print(v, base) + print("\n"); }
+    void flush() { fflush(stdout); }
+};
+
+extern HardwareSerial Serial;
+
+#endif // YFPS2UART_HOST_ARDUINO_H
@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+
+// 虚拟时钟可能被后台任务线程读取，统一用原子操作访问
+static uint32_t s_hostMicros = 0;
+
+static uint32_t loadMicros() {
+  return __atomic_load_n(&s_hostMicros, __ATOMIC_RELAXED);
+}
+
+static void addMicros(uint32_t us) {
+  __atomic_fetch_add(&s_hostMicros, us, __ATOMIC_RELAXED);
+}
+
+HardwareSerial Serial;
+int SoftwareSerial::s_live = 0;
+SoftwareSerial* SoftwareSerial::s_listener = nullptr;
+
+unsigned long millis() {
+  return loadMicros() / 1000UL;
+}
+
+unsigned long micros() {
+  return loadMicros();
+}
+
+void delay(unsigned long ms) {
+  addMicros((uint32_t)(ms * 1000UL));
+}
+
+void delayMicroseconds(unsigned int us) {
+  addMicros(us);
+}
+
+void hostSetMicros(uint32_t us) {
+  __atomic_store_n(&s_hostMicros, us, __ATOMIC_RELAXED);
+}
+
+void hostAdvanceMicros(uint32_t us) {
+  addMicros(us);
+}
@@ -0,0 +1,2 @@
+// HardwareSerial.h（主机端兼容层）：HardwareSerial 已在 Arduino.h 中声明
+#include <Arduino.h>
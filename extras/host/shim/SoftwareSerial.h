@@ -0,0 +1,36 @@
+// SoftwareSerial.h（主机端兼容层）：不收发数据的桩，只统计存活实例数与当前 listen() 的实例，
+// 用于测试 YFPS2UART 软串口模式的构造、移动与析构是否配对
+#ifndef YFPS2UART_HOST_SOFTWARE_SERIAL_H
+#define YFPS2UART_HOST_SOFTWARE_SERIAL_H
+
+#include <Arduino.h>
+
+class SoftwareSerial {
+public:
+    SoftwareSerial(uint8_t rxPin, uint8_t txPin) : _rxPin(rxPin), _txPin(txPin), _baud(0) { ++s_live; }
+    ~SoftwareSerial() { --s_live; if (s_listener == this) s_listener = nullptr; }
+
+    void begin(long baud) { _baud = baud; listen(); }
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t write(uint8_t data) { (void)data; return 1; }
+    size_t print(const char* str) { return strlen(str); }
+    void flush() {}
+    bool listen() { bool was = (s_listener == this); s_listener = this; return !was; }
+    bool isListening() const { return s_listener == this; }
+
+    long baud() const { return _baud; }
+    uint8_t rxPin() const { return _rxPin; }
+    uint8_t txPin() const { return _txPin; }
+
+    static int live() { return s_live; }
+
+private:
+    uint8_t _rxPin;
+    uint8_t _txPin;
+    long _baud;
+    static int s_live;
+    static SoftwareSerial* s_listener;
+};
+
+#endif // YFPS2UART_HOST_SOFTWARE_SERIAL_H
@@ -0,0 +1,244 @@
+// ps2_replay：录制文件（格式见 src/YFPS2UARTCapture.h）的主机端回放与分析工具。
+//
+//   ps2_replay [-s 倍速] [-p 轮询微秒] [-t] capture.bin
+//       用 PS2ReplaySerial 把录制内容送给 YFPS2UART（虚拟时钟，应用每 -p 微秒调用一次 update()），
+//       报告帧率、解析计数、缺失的块、帧间隔中的长间隙，-t 时打印按键/断开事件时间线。
+//       报告中的时间都是录制时的时间（帧时间取送出该帧的记录的时间戳），与回放倍速无关。
+//   ps2_replay -r out.bin [-raw] [-d 秒] [-i]
+//       在模块仿真器（ModuleEmulator.h）上运行一段固定的操作脚本并录制到文件，-raw 录制原始字节，
+//       -i 注入噪声/截断/丢字节；用于生成示例录制或验证录制格式。
+#include <YFPS2UART.h>
+#include <YFPS2UARTReplay.h>
+#include "../ModuleEmulator.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+void usage() {
+  fprintf(stderr,
+          "usage: ps2_replay [-s speed] [-p pollUs] [-t] capture.bin\n"
+          "       ps2_replay -r out.bin [-raw] [-d seconds] [-i]\n");
+}
+
+void writeBlock(void* ctx, const uint8_t* block, uint16_t len) {
+  fwrite(block, 1, len, static_cast<FILE*>(ctx));
+}
+
+// 录制：9600 波特率、5ms 一帧；每秒按一次 ×（200ms），右摇杆来回推动，第 4~5 秒手柄断开，2.5 秒处插入标记
+int record(const char* path, bool raw, uint32_t seconds, bool impaired) {
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+  PS2ModuleConfig cfg;
+  if (impaired) {
+    cfg.noisePerMille = 10;
+    cfg.truncatePerMille = 10;
+    cfg.dropPerMille = 1;
+  }
+  PS2ModuleEmulator mod(cfg);
+  YFPS2UART ps2(&mod);
+  ps2.begin(cfg.baud);
+
+  static uint8_t ring[4 * PS2Capture::kBlockSize];   // 写满的块立即写入文件，环只作暂存
+  PS2Capture cap(ring, sizeof(ring));
+  cap.setSink(writeBlock, f);
+  ps2.setCapture(&cap, raw ? PS2_CAPTURE_RAW : PS2_CAPTURE_FRAMES);
+
+  uint32_t t0 = micros();
+  for (uint32_t ms = 0; ms < seconds * 1000; ++ms) {
+    uint32_t inSec = ms % 1000;
+    if (inSec == 100) mod.setButtons(PSB_CROSS);
+    if (inSec == 300) mod.setButtons(0);
+    if (ms % 20 == 0) {
+      uint32_t phase = (ms / 20) % 50;
+      mod.setStick(PSS_RX, (uint8_t)(phase < 25 ? 128 + phase * 5 : 128 + (50 - phase) * 5));
+    }
+    if (ms == 4000) mod.setConnected(false);
+    if (ms == 5000) mod.setConnected(true);
+    if (ms == 2500) cap.mark();
+    hostSetMicros(t0 + (ms + 1) * 1000);
+    ps2.update();
+  }
+  ps2.setCapture(nullptr);
+  cap.finish();
+  fclose(f);
+
+  PS2FrameCounters c;
+  ps2.getFrameCounters(c);
+  const PS2ModuleCounters& m = mod.counters();
+  printf("recorded %s: %u records, %u frames sent, %u decoded (%s)\n", path, (unsigned)cap.recordCount(),
+         (unsigned)m.frames, (unsigned)c.good, raw ? "raw bytes" : "frames");
+  return 0;
+}
+
+struct Gap {
+  uint32_t atMs;
+  uint32_t lenUs;
+};
+
+int replay(const char* path, uint16_t speed, uint32_t pollUs, bool timeline) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+  std::vector<uint8_t> data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+  fclose(f);
+
+  PS2CaptureReader reader(data.data(), data.size());
+  uint32_t records = 0;
+  uint32_t firstUs = 0, lastUs = 0;
+  PS2CaptureRecord r;
+  std::vector<uint32_t> marks;   // 用户标记（PS2Capture::mark()），回放时不产生数据
+  while (reader.next(r)) {
+    if (records++ == 0) firstUs = r.timeUs;
+    lastUs = r.timeUs;
+    if (r.type == PS2_CAPTURE_REC_EVENT && r.event == PS2_CAPTURE_EVT_MARK) marks.push_back(r.timeUs - firstUs);
+  }
+
+  PS2ReplaySerial serial(reader, speed);
+  YFPS2UART ps2(&serial);
+  ps2.setDebounceMs(0);   // 时间线反映录制中的原始按键
+  ps2.setDrainMode(true); // 每次 update() 读空已到达的数据，回放结束时不留未解析的字节
+  ps2.begin(9600);
+  uint32_t startUs = micros();
+
+  std::vector<uint32_t> frameUs;
+  std::vector<std::pair<uint32_t, std::string> > events;
+  uint32_t good = 0;
+  uint16_t buttons = 0;
+  bool connected = true;
+  char line[96];
+  for (;;) {
+    ps2.update();
+    PS2FrameCounters c;
+    ps2.getFrameCounters(c);
+    uint32_t now = micros();
+    uint32_t rel = (serial.lastRecordUs() - firstUs) / 1000;
+    // 帧时间取送出该帧的记录的录制时间（与回放倍速、轮询周期无关）
+    for (; good < c.good; ++good) frameUs.push_back(serial.lastRecordUs() - firstUs);
+    uint16_t b = (uint16_t)ps2.getButtons();
+    if (b != buttons) {
+      snprintf(line, sizeof(line), "%8u ms  buttons 0x%04X (pressed 0x%04X released 0x%04X)", (unsigned)rel,
+               (unsigned)b, (unsigned)(b & ~buttons), (unsigned)(buttons & ~b));
+      events.push_back(std::make_pair(rel, std::string(line)));
+      buttons = b;
+    }
+    if (ps2.atFrameBoundary()) {
+      bool on = ps2.isRemoteConnected();
+      if (on != connected) {
+        snprintf(line, sizeof(line), "%8u ms  %s", (unsigned)rel, on ? "reconnected" : "disconnected (0xAB)");
+        events.push_back(std::make_pair(rel, std::string(line)));
+        connected = on;
+      }
+    }
+    if (serial.finished()) break;
+    // 最多 pollUs 调用一次 update()，下一条记录更早到时则在它到时调用（倍速回放时帧时间不会挤在一起）；
+    // 长时间没有数据时直接跳到下一条记录，长时间的录制也能很快回放完
+    uint32_t wait = serial.nextRecordUs() - now;
+    if ((int32_t)wait > (int32_t)(pollUs * 100)) {
+      hostAdvanceMicros(wait);
+    } else {
+      hostAdvanceMicros((wait != 0 && wait < pollUs) ? wait : pollUs);
+    }
+  }
+  uint32_t replayUs = micros() - startUs;
+  uint32_t spanUs = lastUs - firstUs;
+
+  PS2FrameCounters c;
+  ps2.getFrameCounters(c);
+  std::vector<uint32_t> gaps;
+  for (size_t i = 1; i < frameUs.size(); ++i) gaps.push_back(frameUs[i] - frameUs[i - 1]);
+  std::vector<uint32_t> sorted(gaps);
+  std::sort(sorted.begin(), sorted.end());
+  uint32_t period = sorted.empty() ? 0 : sorted[sorted.size() / 2];
+  std::vector<Gap> longGaps;
+  uint32_t missing = 0;
+  for (size_t i = 0; i < gaps.size(); ++i) {
+    if (period && gaps[i] * 2 > period * 5) {
+      Gap g = {frameUs[i] / 1000, gaps[i]};
+      longGaps.push_back(g);
+      missing += (gaps[i] + period / 2) / period - 1;
+    }
+  }
+
+  printf("capture      %s: %u blocks, %u records, %.3f s recorded (lost blocks %u, bad blocks %u)\n", path,
+         (unsigned)(data.size() / PS2Capture::kBlockSize), (unsigned)records, (lastUs - firstUs) / 1e6,
+         (unsigned)reader.lostBlocks(), (unsigned)reader.badBlocks());
+  printf("replay       speed %s, poll %u us, %.3f s replayed\n", speed ? (std::to_string(speed) + "x").c_str() : "max",
+         (unsigned)pollUs, replayUs / 1e6);
+  printf("frames       good=%u short=%u long=%u resynced=%u noise bytes=%u\n", (unsigned)c.good,
+         (unsigned)c.shortFrames, (unsigned)c.longFrames, (unsigned)c.resynced, (unsigned)c.noiseBytes);
+  printf("rate         %.1f frames/s (median interval %u us)\n", spanUs ? c.good * 1e6 / spanUs : 0.0,
+         (unsigned)period);
+  printf("gaps         %u gaps > 2.5x median, ~%u frames missing%s\n", (unsigned)longGaps.size(), (unsigned)missing,
+         speed ? "" : " (-s 0 delivers everything at once: no frame timing)");
+  for (size_t i = 0; i < longGaps.size() && i < 10; ++i) {
+    printf("    at %8u ms  gap %u us\n", (unsigned)longGaps[i].atMs, (unsigned)longGaps[i].lenUs);
+  }
+  if (timeline) {
+    for (size_t i = 0; i < marks.size(); ++i) {
+      snprintf(line, sizeof(line), "%8u ms  mark", (unsigned)(marks[i] / 1000));
+      events.push_back(std::make_pair(marks[i] / 1000, std::string(line)));
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const std::pair<uint32_t, std::string>& a, const std::pair<uint32_t, std::string>& b) {
+                       return a.first < b.first;
+                     });
+    printf("timeline\n");
+    for (size_t i = 0; i < events.size(); ++i) printf("  %s\n", events[i].second.c_str());
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* out = nullptr;
+  const char* in = nullptr;
+  bool raw = false, impaired = false, timeline = false;
+  uint32_t seconds = 10, pollUs = 1000;
+  uint16_t speed = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    bool more = i + 1 < argc;
+    if (a == "-r" && more) {
+      out = argv[++i];
+    } else if (a == "-raw") {
+      raw = true;
+    } else if (a == "-d" && more) {
+      seconds = (uint32_t)atoi(argv[++i]);
+    } else if (a == "-i") {
+      impaired = true;
+    } else if (a == "-s" && more) {
+      speed = (uint16_t)atoi(argv[++i]);
+    } else if (a == "-p" && more) {
+      pollUs = (uint32_t)atoi(argv[++i]);
+    } else if (a == "-t") {
+      timeline = true;
+    } else if (a[0] != '-' && !in) {
+      in = argv[i];
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (pollUs == 0) pollUs = 1;
+  if (out) return record(out, raw, seconds, impaired);
+  if (!in) {
+    usage();
+    return 2;
+  }
+  return replay(in, speed, pollUs, timeline);
+}
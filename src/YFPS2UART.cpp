@@ -1,299 +1,1374 @@
 #include "YFPS2UART.h"
 
-// 构造与析构
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5)
-YFPS2UART::YFPS2UART(SerialType serialType, uint8_t rxPin, uint8_t txPin, HardwareSerial* hwSerial)
-  : _serialType(serialType), _rxPin(rxPin), _txPin(txPin),
+// 4 个摇杆值（RX, RY, LX, LY）打包为一个 32 位字，与 PS2State::axes 的布局相同
+static inline uint32_t packAxes(const uint8_t axes[4]) {
+  return (uint32_t)axes[0] | ((uint32_t)axes[1] << 8) | ((uint32_t)axes[2] << 16) | ((uint32_t)axes[3] << 24);
+}
+
+// 解析引擎：构造与析构
+YFPS2UARTCore::YFPS2UARTCore(void* io, const PS2TransportOps* ops)
+  : _io(io), _ops(ops), _syncVibrate(false),
     _lastReceiveTime(0), _newData(false),
     _ignoreIncoming(false),
-    _receiving(false), _ndx(0), _pendingStart(false),
-    _rawButtons(0), _stableButtons(0),
-    _prevStableButtons(0), _pressedEvents(0), _releasedEvents(0),
-    _changedEvents(0), _lastButtons(0),
-    _debounceStartMs(0), _debounceMs(30),
-    _leftX(128), _leftY(127), _rightX(128), _rightY(127),
-    _sw(nullptr), _hw(hwSerial)
+    _receiving(false), _ndx(0), _rxPos(0), _rxLen(0), _rxBytes(0),
+    _capture(nullptr), _captureMode(0), _captureUs(0),
+    _linkFn(nullptr), _linkCtx(nullptr), _failsafe(false), _failsafeActive(true), _lastServiceMs(0),
+    _drainLatest(false), _staleFrames(0), _maxStaleFrames(0), _lastFrameMs(0), _frameIntervalMs(0),
+    _callbackMode(false), _frameSeq(0), _frameTimeMs(0),
+#if defined(YFPS2UART_HAS_TASK)
+    _taskRunning(false), _taskPeriodMs(1),
+#if defined(ESP32)
+    _taskHandle(nullptr), _taskExited(true),
+#endif
+#endif
+    _rawButtons(0), _stableButtons(0), _debounceMs(30), _vc0(0), _vc1(0), _pendingDelta(0), _tickMs(10), _lastTickMs(0),
+    _lastButtons(0), _prevStableButtons(0), _pressedEvents(0), _releasedEvents(0),
+    _changedEvents(0),
+#if YFPS2UART_ENABLE_EVENTS
+    _longPressMs(0), _repeatDelayMs(0), _repeatIntervalMs(0), _doubleTapMs(0), _longSent(0), _tapArmed(0),
+#endif
+    _pressHandlerMask(0), _releaseHandlerMask(0), _pendingPress(0), _pendingRelease(0),
+    _axes{128, 127, 128, 127}, _sticks(0),
+    _reportedButtons(0), _reportedAxes{128, 127, 128, 127}, _axisThreshold{2, 2, 2, 2},
+    _unreadChanges(0), _changeSeq(0)
 {
-  if (_serialType == SERIALTYPE_SW) {
-    _sw = new SoftwareSerial(_rxPin, _txPin);
-    _serial = new SoftwareSerialAdapter(_sw);
-  } else {
-    if (_hw == nullptr) {
-      _hw = &Serial;
-    }
-    _serial = new HardwareSerialAdapter(_hw);
+  _lastPacked = ((uint64_t)_stableButtons << 32) | packAxes(_axes);
+  _atLine = nullptr;
+  _atLineCap = 0;
+  _atWaiting = false;
+  _atCr = false;
+  _atLineLen = 0;
+#if YFPS2UART_ENABLE_AT_QUEUE
+  memset(_at, 0, sizeof(_at));
+  _atActive = kNoAT;
+  _atNextHandle = 1;
+  _atNextOrder = _atSendOrder = 0;
+#endif
+  _vibeLastQueued = 0;
+  _vibeActive = 0;
+  _vibeSentMs = 0;
+  _vibeIntervalMs = YFPS2UART_VIBE_INTERVAL_MS;
+  _vibePat = nullptr;
+  _vibePatLen = _vibePatPos = 0;
+  _vibePatLoop = false;
+  _vibeStepMs = 0;
+  _vibeStepDur = 0;
+  _vibeReqSteps = nullptr;
+  _vibeReqLen = 0;
+  _vibeReqLoop = false;
+  _vibeReq = 0;
+#if YFPS2UART_ENABLE_EVENTS
+  memset(_holdStartMs, 0, sizeof(_holdStartMs));
+  memset(_repeatCount, 0, sizeof(_repeatCount));
+#endif
+  memset(_handlers, 0, sizeof(_handlers));
+  resetFrameCounters();
+#if YFPS2UART_STATS
+  _stats.reset();
+  _rxChunkUs = _decodedUs = _frameArrivalUs = _prevArrivalUs = 0;
+#endif
+}
+
+YFPS2UARTCore::~YFPS2UARTCore() {
+#if defined(YFPS2UART_HAS_TASK)
+  stopBackgroundTask();
+#endif
+}
+
+const YFPS2UARTCore& YFPS2UARTCore::prepareMove() {
+#if defined(YFPS2UART_HAS_TASK)
+  stopBackgroundTask();
+#endif
+  if (_callbackMode) endCallbackReceive();
+  return *this;
+}
+
+void YFPS2UARTCore::restartParser() {
+  discardInput();
+  _receiving = false;
+  _ndx = 0;
+  _newData = false;
+  _ignoreIncoming = false;
+  _atCr = false;
+  _atLineLen = 0;
+}
+
+void YFPS2UARTCore::attachTransport(void* io, const PS2TransportOps* ops) {
+  _io = io;
+  _ops = ops;
+}
+
+// SerialBase 传输层：转发到虚函数
+const PS2TransportOps YFPS2UART::kSerialOps = {
+  &YFPS2UART::opReadBytes, &YFPS2UART::opWrite, &YFPS2UART::opFlush, &YFPS2UART::opOnReceive
+};
+
+size_t YFPS2UART::opReadBytes(void* io, uint8_t* buf, size_t len) {
+  return static_cast<SerialBase*>(io)->readBytes(buf, len);
+}
+
+void YFPS2UART::opWrite(void* io, const uint8_t* data, size_t len) {
+  SerialBase* serial = static_cast<SerialBase*>(io);
+  for (size_t i = 0; i < len; ++i) {
+    serial->write(data[i]);
+  }
+}
+
+void YFPS2UART::opFlush(void* io) {
+  static_cast<SerialBase*>(io)->flush();
+}
+
+bool YFPS2UART::opOnReceive(void* io, void (*cb)(void*), void* ctx) {
+  return static_cast<SerialBase*>(io)->onReceive(cb, ctx);
+}
+
+// 构造与析构
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+YFPS2UART::YFPS2UART(SerialType serialType, uint8_t rxPin, uint8_t txPin, HardwareSerial* hwSerial)
+  : _serial(nullptr), _ownsSerial(true), _baud(0), _sw(nullptr), _hw(hwSerial),
+    _serialType(serialType), _rxPin(rxPin), _txPin(txPin)
+{
+  if (_serialType != SERIALTYPE_SW && _hw == nullptr) {
+    _hw = &Serial;
   }
+  constructTransport();
+  _syncVibrate = (_serialType == SERIALTYPE_HW);
 }
 #elif defined(ESP32)
 YFPS2UART::YFPS2UART(uint8_t rxPin, uint8_t txPin, HardwareSerial* hwSerial)
-  : _serialType(SERIALTYPE_HW), _rxPin(rxPin), _txPin(txPin),
-    _lastReceiveTime(0), _newData(false),
-    _ignoreIncoming(false),
-    _receiving(false), _ndx(0), _pendingStart(false),
-    _rawButtons(0), _stableButtons(0),
-    _prevStableButtons(0), _pressedEvents(0), _releasedEvents(0),
-    _changedEvents(0), _lastButtons(0),
-    _debounceStartMs(0), _debounceMs(30),
-    _leftX(128), _leftY(127), _rightX(128), _rightY(127),
-    _hw(hwSerial)
+  : _serial(nullptr), _ownsSerial(true), _baud(0), _hw(hwSerial), _rxPin(rxPin), _txPin(txPin),
+    _serialType(SERIALTYPE_HW)
 {
-  _serial = new HardwareSerialAdapter(_hw, _rxPin, _txPin);
+  constructTransport();
 }
 #endif
 
+// 使用外部串口对象：不分配、不释放
+YFPS2UART::YFPS2UART(SerialBase* serial)
+  : YFPS2UARTCore(serial, &kSerialOps), _serial(serial), _ownsSerial(false), _baud(0)
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    , _sw(nullptr), _hw(nullptr), _serialType(SERIALTYPE_HW), _rxPin(0), _txPin(0)
+#elif defined(ESP32)
+    , _hw(nullptr), _rxPin(0), _txPin(0), _serialType(SERIALTYPE_HW)
+#endif
+{
+#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5)
+  _syncVibrate = true;   // 与硬串口一致
+#endif
+}
+
 YFPS2UART::~YFPS2UART() {
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5) 
-  if (_serial) {
-    delete _serial;
-    _serial = nullptr;
-  }
+#if defined(YFPS2UART_HAS_TASK)
+  stopBackgroundTask();   // 先停止任务，再释放它正在使用的串口
+#endif
+  releaseTransport();
+}
+
+// 移动构造：先停止源对象的后台任务/回调接收，拷贝引擎状态，再接管传输层
+YFPS2UART::YFPS2UART(YFPS2UART&& other)
+  : YFPS2UARTCore(other.prepareMove()), _serial(nullptr), _ownsSerial(false), _baud(0)
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    , _sw(nullptr), _hw(nullptr), _serialType(SERIALTYPE_HW), _rxPin(0), _txPin(0)
 #elif defined(ESP32)
-  if (_serial) {
-    delete _serial;
-    _serial = nullptr;
+    , _hw(nullptr), _rxPin(0), _txPin(0), _serialType(SERIALTYPE_HW)
+#endif
+{
+  takeTransport(other);
+}
+
+YFPS2UART& YFPS2UART::operator=(YFPS2UART&& other) {
+  if (this != &other) {
+    prepareMove();
+    releaseTransport();
+    YFPS2UARTCore::operator=(other.prepareMove());
+    takeTransport(other);
+  }
+  return *this;
+}
+
+void YFPS2UART::constructTransport() {
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+  if (_serialType == SERIALTYPE_SW) {
+    _sw = new (&_swStore.ss) SoftwareSerial(_rxPin, _txPin);
+    _serial = new (&_adapter.sw) SoftwareSerialAdapter(_sw);
+  } else {
+    _serial = new (&_adapter.hw) HardwareSerialAdapter(_hw);
   }
+#elif defined(ESP32)
+  _serial = new (&_adapter.hw) HardwareSerialAdapter(_hw, _rxPin, _txPin);
+#endif
+  _ownsSerial = true;
+  attachTransport(_serial, &kSerialOps);
+}
+
+void YFPS2UART::releaseTransport() {
+  attachTransport(nullptr, nullptr);
+  if (_serial && _ownsSerial) {
+    _serial->~SerialBase();
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    if (_sw) {
+      _sw->~SoftwareSerial();
+      _sw = nullptr;
+    }
 #endif
+  }
+  _serial = nullptr;
+  _ownsSerial = false;
 }
 
+void YFPS2UART::takeTransport(YFPS2UART& other) {
+  _baud = other._baud;
+#if defined(YFPS2UART_HAS_SOFTSERIAL) || defined(ESP32)
+  _hw = other._hw;
+  _serialType = other._serialType;
+  _rxPin = other._rxPin;
+  _txPin = other._txPin;
+#endif
+  if (other._serial && other._ownsSerial) {
+    // 自有的串口对象位于源对象内部，不能直接转移指针：源对象先销毁，再在本对象中重建
+    other.releaseTransport();
+    constructTransport();
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    if (_sw && _baud) {
+      _serial->begin(_baud);   // 软串口需要重新 begin()（硬串口保持原有配置）
+    }
+#endif
+  } else {
+    _serial = other._serial;
+    _ownsSerial = false;
+    attachTransport(_serial, _serial ? &kSerialOps : nullptr);
+    other._serial = nullptr;
+    other.attachTransport(nullptr, nullptr);
+  }
+  other._baud = 0;
+}
 
 void YFPS2UART::begin(unsigned long espBaud) {
   if (_serial) {
     _serial->begin(espBaud);
+    _baud = espBaud;
   }
 }
 
-unsigned int YFPS2UART::getButtons() {
+// 自动波特率的时间参数（毫秒）
+static const uint16_t kBaudProbeMs = 120;      // 每个候选波特率的收帧窗口
+static const uint16_t kBaudQueryMs = 100;      // AT+BAUD? 的响应超时
+static const uint16_t kBaudMeasureMs = 500;    // 帧率测量窗口
+static const uint16_t kBaudResetMs = 1500;     // AT+RST 后模块重新初始化的时间
+
+/*
+ * 函数: probeBaud
+ * 功能: 以 baud 重新初始化本地串口，在窗口内收帧：至少 2 个好帧且坏帧不超过好帧的 1/4 即认为同步；
+ *       一个好帧也没有时（手柄未连接）发送 AT+BAUD? 确认。
+ */
+bool YFPS2UART::probeBaud(uint32_t baud, bool* viaAT) {
+  begin(baud);
+  restartParser();
+  PS2FrameCounters c0, c1;
+  getFrameCounters(c0);
+  uint32_t t0 = millis();
+  while (millis() - t0 < kBaudProbeMs) {
+    update();
+    delay(1);
+  }
+  getFrameCounters(c1);
+  uint32_t good = c1.good - c0.good;
+  uint32_t bad = (c1.shortFrames - c0.shortFrames) + (c1.longFrames - c0.longFrames);
+  if (good >= 2 && bad * 4 <= good) {
+    if (viaAT) *viaAT = false;
+    return true;
+  }
+  if (good != 0) return false;
+  uint32_t reported = 0;
+  if (queryBaudRate(reported, kBaudQueryMs) && reported == baud) {
+    if (viaAT) *viaAT = true;
+    return true;
+  }
+  return false;
+}
+
+uint16_t YFPS2UART::measureFrameRate(uint16_t windowMs) {
+  PS2FrameCounters c0, c1;
+  getFrameCounters(c0);
+  uint32_t t0 = millis();
+  uint32_t elapsed;
+  while ((elapsed = millis() - t0) < windowMs) {
+    update();
+    delay(1);
+  }
+  getFrameCounters(c1);
+  return (uint16_t)((c1.good - c0.good) * 1000UL / elapsed);
+}
+
+/*
+ * 函数: switchModuleBaud
+ * 功能: 在 from 波特率下发送 AT+BAUD=to，先直接在 to 下验证；模块需要复位才生效时，
+ *       回到 from 发送 AT+RST，等待重新初始化后再验证。
+ */
+bool YFPS2UART::switchModuleBaud(uint32_t from, uint32_t to) {
+  char cmd[24];
+  char resp[16];
+  snprintf(cmd, sizeof(cmd), "AT+BAUD=%lu", (unsigned long)to);
+  sendATCommandWithResponse(cmd, resp, sizeof(resp), kBaudQueryMs);
+  if (probeBaud(to, nullptr)) return true;
+
+  begin(from);
+  restartParser();
+  sendResetCommand();   // 经队列发送（不等待响应）
+  delay(kBaudResetMs);
+  return probeBaud(to, nullptr);
+}
+
+/*
+ * 函数: autoBaud
+ * 功能: 探测模块当前波特率，并可选地把双方切换到支持的最高波特率；报告切换前后的实测帧率。
+ * 参数:
+ *   - upgrade (bool): 是否尝试切换到更高的波特率
+ *   - report (PS2BaudReport*): 可为 nullptr
+ *   - maxBaud (uint32_t): 升级上限，0 表示按串口类型取默认值
+ * 返回值:
+ *   - uint32_t: 最终波特率；0 表示所有候选波特率都无法同步（本地串口保持在最后尝试的波特率）
+ */
+uint32_t YFPS2UART::autoBaud(bool upgrade, PS2BaudReport* report, uint32_t maxBaud) {
+  PS2BaudReport r;
+  memset(&r, 0, sizeof(r));
+  const size_t kRates = sizeof(kPS2BaudRates) / sizeof(kPS2BaudRates[0]);
+  if (maxBaud == 0) {
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    maxBaud = (_sw != nullptr) ? 38400 : 115200;   // SoftwareSerial 在更高波特率下接收不可靠
+#else
+    maxBaud = 115200;
+#endif
+  }
+
+  // 探测顺序：上次使用的波特率、模块默认的 9600，然后从高到低
+  uint32_t order[kRates + 1];
+  size_t n = 0;
+  if (_baud) order[n++] = _baud;
+  if (_baud != 9600) order[n++] = 9600;
+  for (size_t i = kRates; i-- > 1;) {
+    if (kPS2BaudRates[i] != _baud) order[n++] = kPS2BaudRates[i];
+  }
+  for (size_t i = 0; i < n && r.detectedBaud == 0; ++i) {
+    ++r.probes;
+    if (probeBaud(order[i], &r.viaAT)) r.detectedBaud = order[i];
+  }
+  if (r.detectedBaud == 0) {
+    if (report) *report = r;
+    return 0;
+  }
+
+  uint32_t current = r.detectedBaud;
+  r.fpsBefore = measureFrameRate(kBaudMeasureMs);
+  r.fpsAfter = r.fpsBefore;
+  if (upgrade) {
+    for (size_t i = kRates; i-- > 0;) {
+      uint32_t to = kPS2BaudRates[i];
+      if (to <= current || to > maxBaud) continue;
+      ++r.probes;
+      if (switchModuleBaud(current, to)) {
+        current = to;
+        r.fpsAfter = measureFrameRate(kBaudMeasureMs);
+        break;
+      }
+      // 模块没有在新波特率下响应：回到原波特率，并把模块保存的设置恢复为原波特率
+      if (probeBaud(current, nullptr)) {
+        sendSetBaud(current);
+      } else if (probeBaud(to, nullptr)) {
+        current = to;   // 模块在验证窗口之后才完成切换
+        r.fpsAfter = measureFrameRate(kBaudMeasureMs);
+        break;
+      } else {
+        begin(current);
+        restartParser();
+      }
+    }
+  }
+  r.finalBaud = current;
+  if (report) *report = r;
+  return current;
+}
+
+unsigned int YFPS2UARTCore::getButtons() {
   // 返回去抖后的稳定值
   return (unsigned int)_stableButtons;
 }
 
-unsigned int YFPS2UART::getRawButtons() { // 返回未去抖最近一帧的原始值
+unsigned int YFPS2UARTCore::getRawButtons() { // 返回未去抖最近一帧的原始值
   return (unsigned int)_rawButtons;
 }
 
-void YFPS2UART::setDebounceMs(uint16_t ms) {
-  _debounceMs = ms;
+void YFPS2UARTCore::setDebounceMs(uint16_t ms) {
+  _debounceMs = ms;
+  // 计满 3 拍即接受，节拍取 ms/3 向上取整
+  _tickMs = (uint16_t)(ms / 3 + (ms % 3 ? 1 : 0));
+  if (_tickMs == 0) _tickMs = 1;
+  _vc0 = _vc1 = 0;
+  _pendingDelta = 0;
+}
+
+uint16_t YFPS2UARTCore::getDebounceMs() const {
+  return _debounceMs;
+}
+
+bool YFPS2UARTCore::hasRecentData(uint32_t timeoutMs) const {
+  if (_lastReceiveTime == 0) return false;
+  return (millis() - _lastReceiveTime) <= timeoutMs;
+}
+
+void YFPS2UARTCore::setLinkConfig(const PS2LinkConfig& cfg) {
+  _link.configure(cfg);
+}
+
+uint8_t YFPS2UARTCore::getLinkState() const {
+  return _link.state();
+}
+
+void YFPS2UARTCore::getLinkStats(PS2LinkStats& out) const {
+  _link.stats(out, millis());
+}
+
+void YFPS2UARTCore::onLinkChange(PS2LinkHandler fn, void* ctx) {
+  _linkFn = fn;
+  _linkCtx = ctx;
+}
+
+void YFPS2UARTCore::setFailsafe(bool on) {
+  _failsafe = on;
+}
+
+bool YFPS2UARTCore::isFailsafeActive() const {
+  return _failsafe && _failsafeActive;
+}
+
+/*
+ * 函数: serviceLink
+ * 功能: 每次 update()/feed() 结束时调用：用解析计数更新链路状态；链路处于 Lost/Disconnected 且失效保护尚未生效时
+ *       立即生效（开启失效保护时链路已经断开也会在下一次 update() 生效），状态变化时调用回调。
+ */
+void YFPS2UARTCore::serviceLink() {
+  uint32_t now = millis();
+  _lastServiceMs = now;
+  uint8_t from = 0;
+  bool changed = _link.update(now, _counters.good, _counters.shortFrames + _counters.longFrames, _counters.resynced,
+                              _rxBytes, _ignoreIncoming, from);
+  if (_link.state() > PS2_LINK_LOST) {
+    _failsafeActive = false;
+  } else if (_failsafe && !_failsafeActive) {
+    applyFailsafe(now);
+  }
+  if (changed && _linkFn) _linkFn(from, _link.state(), _linkCtx);
+}
+
+// 失效保护：按键立即释放（不经过去抖），摇杆回到中心，滤波器从下一帧重新开始
+void YFPS2UARTCore::applyFailsafe(uint32_t now) {
+  _failsafeActive = true;
+  ++_frameSeq;
+  _rawButtons = 0;
+  _vc0 = _vc1 = 0;
+  _pendingDelta = 0;
+  if (_stableButtons) commitButtons(_stableButtons, now);
+  for (uint8_t i = 0; i < 4; ++i) _axes[i] = _stickCond.center(i);
+  _stickFilter.reset();
+  _sticks = 0;
+  detectChanges();
+}
+
+
+/*
+ * 在 update() 中处理去抖：当收到完整帧（_newData）时解析 rawButtons，
+ * 每个按键用各自的垂直计数器去抖：某个按键与 stableButtons 不同并保持约 _debounceMs 后单独翻转，
+ * 其他按键的抖动不会推迟它的按下/释放。
+ * 开启“最新帧优先”模式后，一次 update() 会读空串口积压：每一帧都参与按键去抖/边沿检测，
+ * 摇杆只取最新一帧，被跳过的旧帧计入 _staleFrames。
+ */
+void YFPS2UARTCore::update() {
+#if defined(YFPS2UART_HAS_TASK)
+  if (_taskRunning) return;   // 后台任务模式下由任务负责解码
+#endif
+  step();
+}
+
+void YFPS2UARTCore::step() {
+#if YFPS2UART_STATS
+  uint32_t t0 = micros();
+  uint32_t seq0 = _frameSeq;
+#endif
+  poll();
+#if YFPS2UART_STATS
+  uint32_t t1 = micros();
+  _stats.updateTime.add(t1 - t0);
+  if (_frameSeq != seq0) {
+    _stats.latency.add(t1 - _frameArrivalUs);
+  }
+#endif
+  serviceLink();
+  // 回调在解析结束后统一分发：回调中可以安全地调用 sendVibrate() 等会清空接收缓冲的函数
+  if (_pendingPress | _pendingRelease) dispatchHandlers();
+#if YFPS2UART_ENABLE_AT_QUEUE
+  if (_atActive != kNoAT || _atSendOrder != _atNextOrder) serviceAT();
+#endif
+  if (_vibePat || _vibeReq || _vibeQueue.size()) serviceVibrate();
+}
+
+void YFPS2UARTCore::poll() {
+  if (_callbackMode) {
+    updateFromRing();
+    return;
+  }
+
+  if (!_drainLatest) {
+    readDataFromSerial();
+    if (_newData) {
+#if YFPS2UART_STATS
+      _frameArrivalUs = _decodedUs;
+#endif
+      uint32_t now = millis();
+      noteFrameInterval(now);
+      applyAxes(_buf + 2);
+      processButtons(((uint16_t)_buf[0] << 8) | (uint16_t)_buf[1], now);
+      // 处理完成，清标志（注意：去抖可能仍在进行，但 _rawButtons 已更新）
+      _newData = false;
+      _lastReceiveTime = now;
+    }
+    return;
+  }
+
+  uint32_t now = millis();
+  uint32_t prev = _lastFrameMs;
+  uint16_t frames = 0;
+  byte latest[4];
+  for (;;) {
+    readDataFromSerial();
+    if (!_newData) break;
+    _newData = false;
+    ++frames;
+#if YFPS2UART_STATS
+    _frameArrivalUs = _decodedUs;
+#endif
+
+    // 积压中的旧帧没有单独的到达时间：按估计的帧间隔从上一帧时间向后推算，最晚不超过当前时间，
+    // 这样积压期间完整按下又松开的按键仍能通过去抖而不会丢失
+    uint32_t t = now;
+    if (_frameIntervalMs != 0 && (int32_t)(now - (prev + _frameIntervalMs)) > 0) {
+      t = prev + _frameIntervalMs;
+    }
+    prev = t;
+    processButtons(((uint16_t)_buf[0] << 8) | (uint16_t)_buf[1], t);
+    memcpy(latest, _buf + 2, sizeof(latest));
+  }
+
+  if (frames == 0) return;
+  if (frames == 1) {
+    noteFrameInterval(now);
+  } else {
+    _staleFrames += frames - 1;
+    if (frames - 1 > _maxStaleFrames) _maxStaleFrames = frames - 1;
+    _lastFrameMs = now;
+  }
+  applyAxes(latest);
+  _lastReceiveTime = now;
+}
+
+// 设置“最新帧优先”模式：true 时 update() 读空积压，只用最新一帧的摇杆值
+void YFPS2UARTCore::setDrainMode(bool latestWins) {
+  _drainLatest = latestWins;
+}
+
+uint32_t YFPS2UARTCore::getStaleFrameCount() const {
+  return _staleFrames;
+}
+
+uint16_t YFPS2UARTCore::getMaxStaleFrames() const {
+  return _maxStaleFrames;
+}
+
+void YFPS2UARTCore::resetStaleFrameCount() {
+  _staleFrames = 0;
+  _maxStaleFrames = 0;
+}
+
+/*
+ * 函数: beginCallbackReceive
+ * 功能: 进入回调接收模式，并尝试向串口注册接收回调。
+ * 返回值:
+ *   - true = 已注册自动回调；false = 平台不支持，需在自己的中断/回调里调用 receiveFromISR()。
+ */
+bool YFPS2UARTCore::beginCallbackReceive() {
+  if (!_ops) return false;
+  _callbackMode = true;
+  return _ops->onReceive && _ops->onReceive(_io, &YFPS2UARTCore::rxCallback, this);
+}
+
+void YFPS2UARTCore::endCallbackReceive() {
+  if (_ops && _ops->onReceive) {
+    _ops->onReceive(_io, nullptr, nullptr);
+  }
+  _callbackMode = false;
+}
+
+void YFPS2UARTCore::rxCallback(void* ctx) {
+  static_cast<YFPS2UARTCore*>(ctx)->receiveFromISR();
+}
+
+// 生产者：解析串口中所有已到达的字节，完整帧写入队列（解析状态只由生产者修改）
+void YFPS2UARTCore::receiveFromISR() {
+  if (!_ops) return;
+  for (;;) {
+    readDataFromSerial();
+    if (!_newData) break;
+    _newData = false;
+    PS2Frame f;
+    memcpy(f.payload, _buf, sizeof(f.payload));
+    f.timeMs = _lastReceiveTime;
+#if YFPS2UART_STATS
+    f.timeUs = _decodedUs;
+#else
+    f.timeUs = 0;
+#endif
+    _ring.push(f);
+  }
+}
+
+// 消费者：取出队列中所有帧，每帧按自身到达时间参与按键检测，摇杆取最新一帧
+void YFPS2UARTCore::updateFromRing() {
+  PS2Frame f;
+  uint16_t frames = 0;
+  byte latest[4];
+  while (_ring.pop(f)) {
+    ++frames;
+#if YFPS2UART_STATS
+    _frameArrivalUs = f.timeUs;
+#endif
+    processButtons(((uint16_t)f.payload[0] << 8) | (uint16_t)f.payload[1], f.timeMs);
+    memcpy(latest, f.payload + 2, sizeof(latest));
+  }
+  if (frames == 0) return;
+  if (frames > 1) {
+    _staleFrames += frames - 1;
+    if (frames - 1 > _maxStaleFrames) _maxStaleFrames = frames - 1;
+  }
+  applyAxes(latest);
+}
+
+/*
+ * 函数: feed
+ * 功能: 直接解析调用者缓冲区中的字节（不经过串口读取），完整帧立即参与按键去抖/事件，摇杆取最新一帧。
+ *       未完成的帧保留在解析状态中，下一次调用继续拼接。
+ * 参数:
+ *   - data/len: 新到达的字节
+ *   - nowUs (uint32_t): 这批数据的到达时间（micros() 时基）
+ * 返回值:
+ *   - uint16_t: 本次完成的帧数
+ */
+uint16_t YFPS2UARTCore::feed(const uint8_t* data, size_t len, uint32_t nowUs) {
+  if (len == 0) return 0;
+#if YFPS2UART_STATS
+  uint32_t t0 = micros();
+  _rxChunkUs = nowUs;
+#endif
+  // 换算到 millis() 时基：按数据已经过去的时间往前推（micros() 约 71 分钟回绕，不能直接除以 1000）
+  uint32_t ageUs = micros() - nowUs;
+  if ((int32_t)ageUs < 0) ageUs = 0;
+  uint32_t now = millis() - ageUs / 1000;
+  _lastReceiveTime = now;
+  _rxBytes += (uint32_t)len;
+  if (_capture) {
+    _captureUs = nowUs;
+    if (_captureMode == PS2_CAPTURE_RAW) _capture->recordBytes(data, len, nowUs);
+  }
+
+  uint16_t frames = 0;
+  byte latest[4];
+  size_t i = 0;
+  while (i < len) {
+    i += decodeChunk(data + i, len - i);
+    if (!_newData) break;
+    _newData = false;
+    ++frames;
+#if YFPS2UART_STATS
+    _frameArrivalUs = _decodedUs;
+#endif
+    processButtons(((uint16_t)_buf[0] << 8) | (uint16_t)_buf[1], now);
+    memcpy(latest, _buf + 2, sizeof(latest));
+  }
+
+  if (frames != 0) {
+    if (frames == 1) {
+      noteFrameInterval(now);
+    } else {
+      _staleFrames += frames - 1;
+      if (frames - 1 > _maxStaleFrames) _maxStaleFrames = frames - 1;
+      _lastFrameMs = now;
+    }
+    applyAxes(latest);
+  }
+#if YFPS2UART_STATS
+  uint32_t t1 = micros();
+  _stats.updateTime.add(t1 - t0);
+  if (frames != 0) {
+    _stats.latency.add(t1 - _frameArrivalUs);
+  }
+#endif
+  serviceLink();
+  if (_pendingPress | _pendingRelease) dispatchHandlers();
+  return frames;
+}
+
+#if defined(YFPS2UART_HAS_TASK)
+/*
+ * 函数: startBackgroundTask
+ * 功能: 启动后台任务，由任务独占串口与解码，并在每解出一帧后发布快照。
+ * 参数:
+ *   - core (uint8_t): ESP32 上任务绑定的核心
+ *   - priority (uint8_t): ESP32 上任务优先级
+ *   - periodMs (uint16_t): 两次轮询之间的间隔（毫秒），0 表示只做最短的让出
+ * 返回值:
+ *   - bool: true 表示任务已启动（或已在运行）
+ */
+bool YFPS2UARTCore::startBackgroundTask(uint8_t core, uint8_t priority, uint16_t periodMs) {
+  if (!_ops) return false;
+  if (_taskRunning) return true;
+  _taskPeriodMs = periodMs;
+  _taskRunning = true;
+#if defined(ESP32)
+  _taskExited = false;
+  if (xTaskCreatePinnedToCore(&YFPS2UARTCore::taskEntry, "ps2uart", 3072, this, priority,
+                              &_taskHandle, core) != pdPASS) {
+    _taskRunning = false;
+    _taskExited = true;
+    _taskHandle = nullptr;
+    return false;
+  }
+#else
+  (void)core;
+  (void)priority;
+  _thread.t = std::thread(&YFPS2UARTCore::taskLoop, this);
+#endif
+  return true;
+}
+
+void YFPS2UARTCore::stopBackgroundTask() {
+  if (!_taskRunning) return;
+  _taskRunning = false;
+#if defined(ESP32)
+  // 等待任务在下一轮循环中自行退出
+  while (!_taskExited) {
+    vTaskDelay(1);
+  }
+  _taskHandle = nullptr;
+#else
+  if (_thread.t.joinable()) _thread.t.join();
+#endif
+}
+
+bool YFPS2UARTCore::readSnapshot(PS2State& out) const {
+  _snapshot.read(out);
+  return out.seq != 0;
+}
+
+#if defined(ESP32)
+void YFPS2UARTCore::taskEntry(void* arg) {
+  YFPS2UARTCore* self = static_cast<YFPS2UARTCore*>(arg);
+  self->taskLoop();
+  self->_taskExited = true;
+  vTaskDelete(NULL);
+}
+#endif
+
+void YFPS2UARTCore::taskLoop() {
+  uint32_t published = _frameSeq;
+  while (_taskRunning) {
+    step();
+    if (_frameSeq != published) {
+      published = _frameSeq;
+      publishSnapshot();
+    }
+#if defined(ESP32)
+    vTaskDelay(_taskPeriodMs ? pdMS_TO_TICKS(_taskPeriodMs) : 1);
+#else
+    if (_taskPeriodMs) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(_taskPeriodMs));
+    } else {
+      std::this_thread::yield();
+    }
+#endif
+  }
+}
+
+void YFPS2UARTCore::publishSnapshot() {
+  PS2State s;
+  fillState(s);
+  _snapshot.write(s);
+}
+#endif
+
+uint8_t YFPS2UARTCore::getQueuedFrames() const {
+  return _ring.size();
+}
+
+uint16_t YFPS2UARTCore::getRingDrops() const {
+  return _ring.drops();
+}
+
+// 无积压时记录相邻两帧的到达间隔（简单 1/4 滑动平均），用于推算积压帧的时间
+void YFPS2UARTCore::noteFrameInterval(uint32_t now) {
+  if (_lastFrameMs != 0) {
+    uint32_t d = now - _lastFrameMs;
+    if (d > 0 && d < 1000) {
+      _frameIntervalMs = (_frameIntervalMs == 0) ? (uint16_t)d
+                         : (uint16_t)((_frameIntervalMs * 3 + d + 2) / 4);
+    }
+  }
+  _lastFrameMs = now;
+}
+
+// 解析摇杆：帧内顺序为 LY, LX, RY, RX，正好与 _axes（RX, RY, LX, LY）相反
+void YFPS2UARTCore::applyAxes(const byte* axes) {
+  _axes[0] = axes[3];
+  _axes[1] = axes[2];
+  _axes[2] = axes[1];
+  _axes[3] = axes[0];
+  _stickFilter.process(_axes);
+  _sticks = _stickCond.process(_axes);
+  detectChanges();
+}
+
+void YFPS2UARTCore::fillState(PS2State& out) const {
+  out.buttons = _stableButtons;
+  out.axes = packAxes(_axes);
+  out.sticks = _sticks;
+  out.timeMs = _frameTimeMs;
+  out.seq = _frameSeq;
+  out.changeSeq = _changeSeq;
+}
+
+/*
+ * 函数: detectChanges
+ * 功能: 每次应用摇杆值后调用。按键 + 摇杆打包为一个 64 位字与上一帧比较，完全相同（最常见）时直接返回；
+ *       否则按键取变化位，各轴与上次报告的值比较，达到阈值才计入并以新值为基准。
+ */
+void YFPS2UARTCore::detectChanges() {
+  uint64_t packed = ((uint64_t)_stableButtons << 32) | packAxes(_axes);
+  if (packed == _lastPacked) return;
+  _lastPacked = packed;
+
+  uint32_t changes = (uint16_t)(_stableButtons ^ _reportedButtons);
+  for (uint8_t i = 0; i < 4; ++i) {
+    uint8_t a = _axes[i];
+    uint8_t r = _reportedAxes[i];
+    uint8_t d = (a > r) ? (uint8_t)(a - r) : (uint8_t)(r - a);
+    if (d >= _axisThreshold[i]) {
+      _reportedAxes[i] = a;
+      changes |= 1UL << (16 + i);
+    }
+  }
+  if (changes == 0) return;
+  _reportedButtons = _stableButtons;
+#if defined(YFPS2UART_HAS_TASK)
+  __atomic_fetch_or(&_unreadChanges, changes, __ATOMIC_RELEASE);
+  __atomic_store_n(&_changeSeq, _frameSeq, __ATOMIC_RELEASE);
+#else
+  _unreadChanges |= changes;
+  _changeSeq = _frameSeq;
+#endif
+}
+
+bool YFPS2UARTCore::hasChanged(PS2Change* out) {
+#if defined(YFPS2UART_HAS_TASK)
+  uint32_t changes = __atomic_exchange_n(&_unreadChanges, 0u, __ATOMIC_ACQ_REL);
+#else
+  uint32_t changes = _unreadChanges;
+  _unreadChanges = 0;
+#endif
+  if (out) {
+    out->buttons = (uint16_t)changes;
+    out->axes = (uint8_t)(changes >> 16);
+    out->seq = getChangeSeq();
+  }
+  return changes != 0;
+}
+
+bool YFPS2UARTCore::changedSince(uint32_t seq) const {
+  return (int32_t)(getChangeSeq() - seq) > 0;
+}
+
+uint32_t YFPS2UARTCore::getChangeSeq() const {
+#if defined(YFPS2UART_HAS_TASK)
+  return __atomic_load_n(&_changeSeq, __ATOMIC_ACQUIRE);
+#else
+  return _changeSeq;
+#endif
+}
+
+void YFPS2UARTCore::setAxisThreshold(uint8_t counts, uint8_t axes) {
+  for (uint8_t i = 0; i < 4; ++i) {
+    if (axes & (1u << i)) _axisThreshold[i] = counts ? counts : 1;
+  }
+}
+
+#if YFPS2UART_STATS
+void YFPS2UARTCore::getStats(PS2Stats& out) const {
+  out = _stats;
+}
+
+void YFPS2UARTCore::resetStats() {
+  _stats.reset();
+}
+#endif
+
+void YFPS2UARTCore::getState(PS2State& out) const {
+#if defined(YFPS2UART_HAS_TASK)
+  if (_taskRunning) {
+    _snapshot.read(out);
+    return;
+  }
+#endif
+  fillState(out);
+}
+
+// 按键去抖与边沿检测，now 为该帧的时间（毫秒）
+void YFPS2UARTCore::processButtons(uint16_t raw, uint32_t now) {
+  ++_frameSeq;
+  _frameTimeMs = now;
+#if YFPS2UART_STATS
+  if (_stats.frames++ != 0) {
+    _stats.frameInterval.add(_frameArrivalUs - _prevArrivalUs);
+  }
+  _prevArrivalUs = _frameArrivalUs;
+#endif
+
+  _rawButtons = raw;
+  uint16_t delta = raw ^ _stableButtons;   // 与稳定值不同的按键
+  uint16_t toggle;
+  if (_debounceMs == 0) {
+    toggle = delta;
+  } else {
+    // 新增：垂直计数器去抖，16 个按键并行、互不影响。
+    // 回到稳定值的按键计数清零；上一帧已不同、本帧仍不同的按键按经过的节拍数加 1（饱和于 3），
+    // 本帧才开始不同的按键从下一帧起计数，因此至少要在两帧中保持 2~3 个节拍（约 _debounceMs）才被接受。
+    _vc0 &= delta;
+    _vc1 &= delta;
+    uint32_t ticks = (now - _lastTickMs) / _tickMs;
+    if (ticks) {
+      _lastTickMs += ticks * _tickMs;
+      uint16_t counting = delta & _pendingDelta;
+      if (ticks > 3) ticks = 3;
+      while (ticks--) {
+        uint16_t inc = counting & ~(_vc0 & _vc1);
+        _vc1 ^= _vc0 & inc;
+        _vc0 ^= inc;
+      }
+    }
+    toggle = _vc0 & _vc1;   // 计满 3 拍的按键
+    _vc0 &= ~toggle;
+    _vc1 &= ~toggle;
+    _pendingDelta = delta & ~toggle;
+  }
+  if (toggle == 0) {
+#if YFPS2UART_ENABLE_EVENTS
+    if (_stableButtons) processHeld(now);
+#endif
+    return;
+  }
+  commitButtons(toggle, now);
+}
+
+// 翻转 toggle 中的稳定按键，产生按下/释放事件与回调
+void YFPS2UARTCore::commitButtons(uint16_t toggle, uint32_t now) {
+  // 先保存当前的_stableButtons作为前一个状态
+  _lastButtons = _stableButtons;
+  // 只翻转已稳定的按键，其余按键继续各自计数
+  _stableButtons ^= toggle;
+
+  // 计算按键状态变化
+  uint16_t changed = toggle;
+
+  // 处理边沿事件：计算按下 / 释放
+  uint16_t pressed = (_stableButtons & toggle);
+  uint16_t released = (_lastButtons & toggle);
+  if (pressed) {
+    _pressedEvents |= pressed;
+#if YFPS2UART_ENABLE_EVENTS
+    // 记录按住起始时间并写入事件（只遍历置位的按键）
+    for (uint16_t m = pressed; m; m &= (uint16_t)(m - 1)) {
+      uint8_t b = (uint8_t)__builtin_ctz(m);
+      uint16_t bit = (uint16_t)(1u << b);
+      pushEvent(PS2_EVENT_PRESS, b, now);
+      if (_doubleTapMs && (_tapArmed & bit) && (now - _holdStartMs[b]) <= _doubleTapMs) {
+        pushEvent(PS2_EVENT_DOUBLE_TAP, b, now);
+        _tapArmed &= ~bit;   // 第三次按下重新开始计
+      } else {
+        _tapArmed |= bit;
+      }
+      _holdStartMs[b] = now;
+      _repeatCount[b] = 0;
+    }
+    _longSent &= ~pressed;
+#endif
+    _pendingPress |= pressed & _pressHandlerMask;
+  }
+  if (released) {
+    _releasedEvents |= released;
+#if YFPS2UART_ENABLE_EVENTS
+    for (uint16_t m = released; m; m &= (uint16_t)(m - 1)) {
+      pushEvent(PS2_EVENT_RELEASE, (uint8_t)__builtin_ctz(m), now);
+    }
+#endif
+    _pendingRelease |= released & _releaseHandlerMask;
+  }
+#if YFPS2UART_ENABLE_EVENTS
+  if (_stableButtons) processHeld(now);
+#endif
+  // 更新状态变化事件
+  if (changed) {
+    _changedEvents |= changed;
+  }
+
+  // 更新前一个稳定状态
+  _prevStableButtons = _stableButtons;
+}
+
+/*
+ * 在 [data, data+len) 中查找第一个等于 a 或 b 的字节，返回其下标，找不到返回 len。
+ * 32 位及以上平台按机器字一次检查多个字节（SWAR），仅在字中有命中时才逐字节定位；
+ * AVR 为 8 位内核，宽字运算反而更慢，直接逐字节比较。
+ */
+static size_t findEither(const uint8_t* data, size_t len, uint8_t a, uint8_t b) {
+  size_t i = 0;
+#if !defined(__AVR__)
+  const size_t ones = (size_t)~(size_t)0 / 0xFF;   // 0x0101...01
+  const size_t highs = ones * 0x80;                 // 0x8080...80
+  const size_t pa = ones * a;
+  const size_t pb = ones * b;
+  for (; i + sizeof(size_t) <= len; i += sizeof(size_t)) {
+    size_t w;
+    memcpy(&w, data + i, sizeof(w));
+    size_t xa = w ^ pa;
+    size_t xb = w ^ pb;
+    if ((((xa - ones) & ~xa) | ((xb - ones) & ~xb)) & highs) break;
+  }
+#endif
+  for (; i < len; ++i) {
+    if (data[i] == a || data[i] == b) return i;
+  }
+  return len;
+}
+
+bool YFPS2UARTCore::fillRxChunk() {
+  if (_rxPos < _rxLen) return true;
+  _rxPos = 0;
+  _rxLen = (uint8_t)_ops->readBytes(_io, _rxChunk, sizeof(_rxChunk));
+  if (_rxLen == 0) return false;
+  _rxBytes += _rxLen;
+  _lastReceiveTime = millis();   // 每块只取一次时间戳
+  if (_capture) {
+    _captureUs = micros();
+    if (_captureMode == PS2_CAPTURE_RAW) _capture->recordBytes(_rxChunk, _rxLen, _captureUs);
+  }
+#if YFPS2UART_STATS
+  _rxChunkUs = micros();
+#endif
+  return true;
+}
+
+void YFPS2UARTCore::discardInput() {
+  if (_callbackMode) return;   // 回调模式下串口只由生产者读取
+  _rxPos = _rxLen = 0;
+  while (_ops->readBytes(_io, _rxChunk, sizeof(_rxChunk)) > 0) {
+  }
 }
 
-bool YFPS2UART::hasRecentData(uint32_t timeoutMs) const {
-  if (_lastReceiveTime == 0) return false;
-  return (millis() - _lastReceiveTime) <= timeoutMs;
-}
+void YFPS2UARTCore::readDataFromSerial() {
+  if (!_ops) return;
 
+  while (_newData == false && fillRxChunk()) {
+    _rxPos += (uint8_t)decodeChunk(_rxChunk + _rxPos, _rxLen - _rxPos);
+  }
+}
 
 /*
- * 在 update() 中处理去抖：当收到完整帧（_newData）时解析 rawButtons，
- * 如果与上次 raw 不同则重置去抖计时；当 raw 在 _debounceMs 内保持不变则更新 stableButtons。
+ * 函数: decodeChunk
+ * 功能: 按定长帧协议解析一段连续字节：0x0D + 6 字节负载 + 0x0A。
+ *       - 帧外：跳过噪声直到 0x0D（帧头）；0xAB 只在帧外生效，表示手柄断开（进入忽略模式）；
+ *       - 帧内：负载按长度整段拷贝，不检查取值（摇杆/按键字节为 0x0A、0x0D、0xAB 都是合法负载）；
+ *       - 第 7 个字节必须是 0x0A，否则判为坏帧：在已收字节中寻找下一个 0x0D 重新对齐，
+ *         若其前一字节为 0x0A 则记为短帧（上一帧提前结束），否则记为长帧。
+ *       收到完整好帧后退出忽略模式。
+ * 参数:
+ *   - data/len: 待解析的数据
+ * 返回值:
+ *   - 已消耗的字节数；若解出完整一帧（_newData = true）则在帧结束符之后立即返回。
  */
-void YFPS2UART::update() {
-  readDataFromSerial();
-
-  if (_newData) {
-    // 根据PS2_ESP32C3_UART.ino的数据包格式解析：
-    // 0x0D + buttonsHigh + buttonsLow + leftY + leftX + rightY + rightX + 0x0A
-    uint16_t raw = 0;
-    raw = ((uint16_t)_buf[0] << 8) | (uint16_t)_buf[1]; // 合并高字节和低字节为16位
-
-    // 解析摇杆（根据你的协议：buf[2]=leftY, buf[3]=leftX, buf[4]=rightY, buf[5]=rightX）
-    // 解析摇杆数据（注意_end_MA(0x0A)不应该作为数据使用）
-    _leftY = _buf[2];
-    _leftX = _buf[3];
-    _rightY = _buf[4];
-    _rightX = _buf[5];
-    // _leftY =127;
-    // _leftX = 128 ;
-    // _rightY = 127;
-    // _rightX = 128;
-
-    // 若 raw 变化，重置去抖计时
-    if (raw != _rawButtons) {
-      _rawButtons = raw;
-      _debounceStartMs = millis();
-    } else {
-      // 若 raw 保持不变并且已超过去抖时间，则接受该值
-      if ((int32_t)(millis() - _debounceStartMs) >= (int32_t)_debounceMs) {
-        if (_stableButtons != raw) {
-          // 先保存当前的_stableButtons作为前一个状态
-          _lastButtons = _stableButtons;
-          
-          
-          // 更新稳定按键值
-          _stableButtons = raw;
-
-          // 计算按键状态变化
-          uint16_t changed = _lastButtons ^ _stableButtons;
-          
-          // 处理边沿事件：计算按下 / 释放
-          uint16_t pressed = (_stableButtons & ~_lastButtons);
-          uint16_t released = (_lastButtons & ~_stableButtons);
-          if (pressed) {
-            _pressedEvents |= pressed;
-            // 记录按住起始时间
-            for (int b = 0; b < 16; ++b) {
-              if (pressed & (1u << b)) _holdStartMs[b] = millis();
-            }
-          }
-          if (released) {
-            _releasedEvents |= released;
-            // 清除按住起始时间
-            for (int b = 0; b < 16; ++b) {
-              if (released & (1u << b)) _holdStartMs[b] = 0;
-            }
-          }
-          // 更新状态变化事件
-          if (changed) {
-            _changedEvents |= changed;
-          }
-          
-          // 更新前一个稳定状态
-          _prevStableButtons = _stableButtons;
+size_t YFPS2UARTCore::decodeChunk(const uint8_t* data, size_t len) {
+  const byte start_MA = 0x0D;
+  const byte end_MA = 0x0A;
+  const byte disconnect = 0xAB;
+  size_t i = 0;
+
+  while (i < len) {
+    if (!_receiving) {
+      if (_atWaiting) {
+        // 等待 AT 响应：帧外的 ASCII 字节组成响应行，遇到帧头/0xAB 再交给下面的帧解析
+        i += scanATLine(data + i, len - i);
+        if (_receiving || i == len) continue;
+      }
+      // 帧外：等待帧头，途中遇到 0xAB 则进入忽略模式（已在忽略模式时只需找帧头，连续的 0xAB 整段跳过）
+      size_t k = findEither(data + i, len - i, start_MA, _ignoreIncoming ? start_MA : disconnect);
+      _counters.noiseBytes += (uint32_t)k;
+      if (k == len - i) return len;
+      i += k;
+      if (data[i++] == disconnect) {
+        _ignoreIncoming = true;
+        if (_capture && _captureMode == PS2_CAPTURE_FRAMES) {
+          _capture->recordEvent(PS2_CAPTURE_EVT_DISCONNECT, _captureUs);
         }
+      } else {
+        _receiving = true;
+        _ndx = 0;
+      }
+    } else if (_ndx < kPayloadLen) {
+      // 帧内：按长度拷贝负载
+      size_t n = kPayloadLen - _ndx;
+      if (n > len - i) n = len - i;
+      memcpy(_buf + _ndx, data + i, n);
+      _ndx += (uint8_t)n;
+      i += n;
+    } else {
+      uint8_t b = data[i++];
+      _receiving = false;
+      _ndx = 0;
+      if (b == end_MA) {
+        // 完整好帧
+        ++_counters.good;
+        _ignoreIncoming = false;
+        _newData = true;
+        if (_capture && _captureMode == PS2_CAPTURE_FRAMES) _capture->recordFrame(_buf, _captureUs);
+#if YFPS2UART_STATS
+        _decodedUs = _rxChunkUs;
+#endif
+        return i;
       }
+      _buf[kPayloadLen] = b;
+      resyncFromBuffer();
     }
-
-    // 处理完成，清标志（注意：去抖可能仍在进行，但 _rawButtons 已更新）
-    _newData = false;
-    _lastReceiveTime = millis();
   }
+  return len;
 }
 
-void YFPS2UART::readDataFromSerial() {
-  if (!_serial) return;
-
+/*
+ * 坏帧重同步：_buf 中保存了 6 字节负载和本应是 0x0A 的第 7 个字节。
+ * 在其中寻找下一个 0x0D 作为新帧头，把其后的字节作为新帧已收到的负载，避免丢掉紧跟在短帧后的好帧。
+ */
+void YFPS2UARTCore::resyncFromBuffer() {
   const byte start_MA = 0x0D;
   const byte end_MA = 0x0A;
-  int rb;
+  const uint8_t window = kPayloadLen + 1;
+
+  uint8_t k = 0;
+  while (k < window && _buf[k] != start_MA) ++k;
 
-  // 如果上次检测到 start，但未实际处理，先设置接收状态
-  if (_pendingStart) {
-    _receiving = true;
-    _ndx = 0;
-    _pendingStart = false;
+  bool isShort = k > 0 && k < window && _buf[k - 1] == end_MA;
+  if (isShort) {
+    ++_counters.shortFrames;
+  } else {
+    ++_counters.longFrames;
+  }
+  if (_capture && _captureMode == PS2_CAPTURE_FRAMES) {
+    _capture->recordEvent(isShort ? PS2_CAPTURE_EVT_SHORT_FRAME : PS2_CAPTURE_EVT_BAD_FRAME, _captureUs);
+  }
+  if (k == window) {
+    _counters.noiseBytes += window;
+    return;
   }
 
-  while (_serial->available() > 0 && _newData == false) {
-    _lastReceiveTime = millis();
-    rb = _serial->read();
-    if (rb < 0) break;
+  ++_counters.resynced;
+  _counters.noiseBytes += k;
+  uint8_t n = (uint8_t)(window - k - 1);
+  memmove(_buf, _buf + k + 1, n);
+  _receiving = true;
+  _ndx = n;
+}
 
-    // 如果收到断开标识 0xAB -> 进入忽略模式（不处理后续非协议数据）
-    if ((uint8_t)rb == 0xAB) {
-      _receiving = false;
-      _ndx = 0;
-      _newData = false;
-      _ignoreIncoming = true;
-      // 丢弃并继续
-      continue;
-    }
+void YFPS2UARTCore::getFrameCounters(PS2FrameCounters& out) const {
+  out = _counters;
+}
 
-    // 忽略模式：直到下一个起始字节 0x0D 出现才恢复处理
-    if (_ignoreIncoming) {
-      if ((uint8_t)rb == start_MA) {
-        // 标记待处理的 start，交由本函数下一轮或后续处理开始接收
-        _ignoreIncoming = false;
-        _receiving = true;
-        _ndx = 0;
-      }
-      // 否则一直丢弃字节
-      continue;
-    }
+void YFPS2UARTCore::resetFrameCounters() {
+  memset(&_counters, 0, sizeof(_counters));
+  _link.rebase(0, 0, 0);
+}
 
-    // 正常接收帧逻辑
-    if (_receiving) {
-      if ((uint8_t)rb != end_MA) {
-        _buf[_ndx] = (byte)rb;
-        _ndx++;
-        if (_ndx >= sizeof(_buf)) _ndx = sizeof(_buf) - 1;
-      } else {
-        // 结束符到达，写入并标志新数据
-        _buf[_ndx] = end_MA;
-        _receiving = false;
-        _ndx = 0;
-        _newData = true;
-      }
-    } else if ((uint8_t)rb == start_MA) {
-      // 遇到起始字节，进入接收状态
-      _receiving = true;
-      _ndx = 0;
-    }
-  }
+uint32_t YFPS2UARTCore::getRxByteCount() const {
+  return _rxBytes;
+}
+
+void YFPS2UARTCore::setCapture(PS2Capture* cap, uint8_t mode) {
+  _captureMode = mode;
+  _capture = cap;
+}
+
+bool YFPS2UARTCore::atFrameBoundary() const {
+  return !_receiving && _rxPos >= _rxLen;
 }
 
 /*
  * 函数: isRemoteConnected
- * 功能: 主动读取串口判断远端是否为 connected（非 0xAB），
- *       并在发现 start_MA 时准备进入接收（设置 _pendingStart）。
- * 参数: 无
+ * 功能: 返回解析器的连接状态：帧外收到 0xAB 后为 false，直到 update() 解出下一个完整好帧。
+ *       只读取解析状态，不读取串口（以前会读走并丢弃帧头前的字节，打断 update() 正在接收的帧），
+ *       因此状态只在 update()（或 feed()、回调/后台任务模式的接收）中更新，loop() 中需要持续调用 update()。
+ *       超过 lostMs 没有调用 update() 时断开状态已过时，返回 true：旧示例“先检查、断开就 return、再 update()”
+ *       的写法每隔 lostMs 仍会调用一次 update()，手柄重新连接后能解出好帧并恢复，不会一直停在断开。
  * 返回值:
- *   - true = 远端已连接（非 0xAB 忽略模式），false = 远端断开（正在忽略数据）。
+ *   - true = 远端已连接（非 0xAB 忽略模式）或状态已过时，false = 远端断开（正在忽略数据）。
  */
-bool YFPS2UART::isRemoteConnected() const {
-  if (!_serial) return false;
+bool YFPS2UARTCore::isRemoteConnected() const {
+  if (!_ignoreIncoming) return true;
+  return millis() - _lastServiceMs >= _link.config().lostMs;
+}
 
-  YFPS2UART* self = const_cast<YFPS2UART*>(this);
 
-  const uint8_t start_MA = 0x0D;
-  const uint8_t disconnect = 0xAB;
+/**
+ * @brief 发送震动控制命令到UART设备
+ * 
+ * 该函数通过UART接口向连接的设备发送震动控制命令。
+ * 只有在串口对象有效时才会执行发送操作。
+ * 
+ * @param cmd 震动控制命令字节，单字节命令值（0x01 双马达、0x02 左马达、0x03 右马达）
+ */
+void YFPS2UARTCore::sendVibrate(uint8_t cmd) {
+  if (!_ops) return;
+  if (_syncVibrate) {
+    discardInput();
+  }
+  writeVibrate(cmd, millis());
+  if (_syncVibrate) {
+    _ops->flush(_io);
+  }
+}
+
+// 震动指令与马达位（bit0 左、bit1 右）互相转换
+static uint8_t vibrateMotors(uint8_t cmd) {
+  switch (cmd) {
+    case VIBRATE_BOTH:  return 3;
+    case VIBRATE_LEFT:  return 1;
+    case VIBRATE_RIGHT: return 2;
+    default:            return 0;
+  }
+}
 
-  while (_serial->available() > 0) {
-    int c = _serial->read();
-    if (c < 0) break;
-    uint8_t cb = (uint8_t)c;
+static uint8_t vibrateCommand(uint8_t motors) {
+  return (motors == 3) ? VIBRATE_BOTH : (motors == 1) ? VIBRATE_LEFT : VIBRATE_RIGHT;
+}
 
-    if (cb == disconnect) {
-      // 收到断开，进入忽略模式
-      self->_ignoreIncoming = true;
-      self->_receiving = false;
-      self->_ndx = 0;
-      continue;
-    }
+void YFPS2UARTCore::writeVibrate(uint8_t cmd, uint32_t now) {
+  _ops->write(_io, &cmd, 1);
+  _vibeSentMs = now;
+  _vibeActive = vibrateMotors(cmd);
+}
 
-    if (cb == start_MA) {
-      // 收到起始字节，标记 pendingStart，让 readDataFromSerial 在下一次运行时开始接收
-      self->_pendingStart = true;
-      self->_ignoreIncoming = false;
-      break; // 发现 start 后可以退出，后续帧由 readDataFromSerial 处理
-    }
+bool YFPS2UARTCore::queueVibrate(uint8_t cmd) {
+  if (!_ops || !vibrateMotors(cmd)) return false;
+  // 与上一条尚未发送的请求相同：发送时会合并，无需再占一个槽位
+  if (cmd == _vibeLastQueued && _vibeQueue.size()) return true;
+  PS2VibeRequest r;
+  r.timeMs = millis();
+  r.cmd = cmd;
+  if (!_vibeQueue.push(r)) return false;
+  _vibeLastQueued = cmd;
+  return true;
+}
 
-    // 其它字节在此处直接丢弃
+void YFPS2UARTCore::playVibratePattern(const PS2VibeStep* steps, uint8_t count, bool loop) {
+  if (!steps || count == 0) {
+    stopVibratePattern();
+    return;
   }
+  _vibeReqSteps = steps;
+  _vibeReqLen = count;
+  _vibeReqLoop = loop;
+  __atomic_store_n(&_vibeReq, kVibeReqPlay, __ATOMIC_RELEASE);
+}
 
-  return !self->_ignoreIncoming;
+void YFPS2UARTCore::stopVibratePattern() {
+  __atomic_store_n(&_vibeReq, kVibeReqStop, __ATOMIC_RELEASE);
 }
 
+bool YFPS2UARTCore::isVibratePatternPlaying() const {
+  uint8_t req = __atomic_load_n(&_vibeReq, __ATOMIC_ACQUIRE);
+  return req == kVibeReqPlay || (req == 0 && _vibePat != nullptr);
+}
 
-/**
- * @brief 发送震动控制命令到UART设备
- * 
- * 该函数通过UART接口向连接的设备发送震动控制命令。
- * 只有在串口对象有效时才会执行发送操作。
- * 
- * @param cmd 震动控制命令字节，单字节命令值（0x01 双马达、0x02 左马达、0x03 右马达）
+void YFPS2UARTCore::setVibrateIntervalMs(uint16_t ms) {
+  _vibeIntervalMs = ms;
+}
+
+uint8_t YFPS2UARTCore::getVibratePending() const {
+  return _vibeQueue.size();
+}
+
+/*
+ * 函数: serviceVibrate
+ * 功能: 由 update() 调用。有序列在播放时按步骤推进（震动步同样受最小间隔限制）；
+ *       否则在距上次发送已满最小间隔时取出所有排队请求：请求时已被正在进行的震动覆盖的请求不单独触发发送，
+ *       其余请求（连同被覆盖的）合并为一条指令发送。只写入一个字节，不 flush、不清空接收缓冲。
  */
-void YFPS2UART::sendVibrate(uint8_t cmd) {
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5) 
-  if (_serial) {
-    if (_serialType == SERIALTYPE_HW) {
-      while (_serial->available() > 0) {
-        _serial->read();
+void YFPS2UARTCore::serviceVibrate() {
+  if (!_ops) return;
+  uint32_t now = millis();
+  if (_vibeReq) {
+    uint8_t req = __atomic_exchange_n(&_vibeReq, (uint8_t)0, __ATOMIC_ACQ_REL);
+    if (req == kVibeReqPlay) {
+      _vibePat = _vibeReqSteps;
+      _vibePatLen = _vibeReqLen;
+      _vibePatLoop = _vibeReqLoop;
+      _vibePatPos = 0;
+      _vibeStepMs = now;
+      _vibeStepDur = 0;
+    } else if (req == kVibeReqStop) {
+      _vibePat = nullptr;
+    }
+  }
+  bool limited = _vibeActive && now - _vibeSentMs < _vibeIntervalMs;
+
+  if (_vibePat) {
+    if (now - _vibeStepMs < _vibeStepDur) return;
+    if (_vibePatPos >= _vibePatLen) {
+      if (!_vibePatLoop) {
+        _vibePat = nullptr;
+        return;   // 排队的请求从下一次 update() 开始处理
       }
+      _vibePatPos = 0;
     }
-    _serial->write(cmd);
-    if (_serialType == SERIALTYPE_HW) {
-      _serial->flush();
+    const PS2VibeStep& st = _vibePat[_vibePatPos];
+    uint8_t motors = vibrateMotors(st.cmd);
+    if (motors) {
+      if (limited) return;
+      writeVibrate(st.cmd, now);
     }
+    _vibeStepMs = now;
+    _vibeStepDur = st.ms ? st.ms : (motors ? _vibeIntervalMs : 0);
+    ++_vibePatPos;
+    return;
   }
-#elif defined(ESP32)
-  if (_serial) {
-    _serial->write(cmd);
+
+  if (limited) return;
+  uint8_t motors = 0;
+  bool needed = false;
+  PS2VibeRequest r;
+  while (_vibeQueue.pop(r)) {
+    uint8_t m = vibrateMotors(r.cmd);
+    motors |= m;
+    needed = needed || !(_vibeActive && r.timeMs - _vibeSentMs < _vibeIntervalMs && !(m & ~_vibeActive));
   }
-#endif
+  // 新指令会替换正在进行的震动，因此只要有一个请求未被覆盖，就发送全部请求的马达并集
+  if (needed) writeVibrate(vibrateCommand(motors), now);
 }
 
 
 
 // 检查是否有任何按键状态改变
-// bool YFPS2UART::NewButtonState() {
+// bool YFPS2UARTCore::NewButtonState() {
 //   // // 使用_changedEvents作为独立的事件源
 //   // bool hasChanges = _changedEvents != 0;
 //   // if (hasChanges) {
@@ -306,7 +1381,7 @@ void YFPS2UART::sendVibrate(uint8_t cmd) {
 // }
 
 // 检查特定按键是否有状态改变
-// bool YFPS2UART::NewButtonState(uint16_t button) {
+// bool YFPS2UARTCore::NewButtonState(uint16_t button) {
 //   // // 使用_changedEvents作为独立的事件源
 //   // uint16_t hit = _changedEvents & button;
 //   // if (hit) {
@@ -320,12 +1395,12 @@ void YFPS2UART::sendVibrate(uint8_t cmd) {
 // }
 
 // 检查按键当前是否被按下
-bool YFPS2UART::Button(uint16_t button) {
+bool YFPS2UARTCore::Button(uint16_t button) {
   return ((_stableButtons & button) > 0);
 }
 
 // 检查按键是否刚被按下
-bool YFPS2UART::ButtonPressed(uint16_t button) {
+bool YFPS2UARTCore::ButtonPressed(uint16_t button) {
   // 使用_pressedEvents来检测刚按下的按键，并在读取后清除事件
   uint16_t hit = _pressedEvents & button;
   if (hit) {
@@ -338,14 +1413,14 @@ bool YFPS2UART::ButtonPressed(uint16_t button) {
   // return(NewButtonState(button) & Button(button));
 }
 
-// bool YFPS2UART::wasPressed(uint16_t mask) {
+// bool YFPS2UARTCore::wasPressed(uint16_t mask) {
 //   uint16_t hit = _pressedEvents & mask;
 //   if (hit) _pressedEvents &= ~hit; // 读取后清除对应事件位
 //   return (hit != 0);
 // }
 
 // 检查按键是否刚被释放
-bool YFPS2UART::ButtonReleased(uint16_t button) {
+bool YFPS2UARTCore::ButtonReleased(uint16_t button) {
   // 使用_releasedEvents来检测刚释放的按键，并在读取后清除事件
   uint16_t hit = _releasedEvents & button;
   if (hit) {
@@ -358,7 +1433,168 @@ bool YFPS2UART::ButtonReleased(uint16_t button) {
   // return((NewButtonState(button)) & ((~_lastButtons & button) > 0));
 }
 
-// bool YFPS2UART::wasReleased(uint16_t mask) {
+#if YFPS2UART_ENABLE_EVENTS
+uint32_t YFPS2UARTCore::getHoldMs(uint16_t button) {
+  uint16_t held = _stableButtons & button;
+  if (held == 0) return 0;
+  return millis() - _holdStartMs[__builtin_ctz(held)];
+}
+
+/*
+ * 函数: processHeld
+ * 功能: 为按住中的按键产生长按与自动连发事件（每帧调用一次，只遍历按住的按键）
+ * 参数: now - 当前帧时间（毫秒）
+ */
+void YFPS2UARTCore::processHeld(uint32_t now) {
+  if (_longPressMs) {
+    for (uint16_t m = _stableButtons & ~_longSent; m; m &= (uint16_t)(m - 1)) {
+      uint8_t b = (uint8_t)__builtin_ctz(m);
+      if (now - _holdStartMs[b] >= _longPressMs) {
+        pushEvent(PS2_EVENT_LONG_PRESS, b, now);
+        _longSent |= (uint16_t)(1u << b);
+      }
+    }
+  }
+  if (_repeatIntervalMs) {
+    uint16_t delayMs = _repeatDelayMs ? _repeatDelayMs : _repeatIntervalMs;   // 首次连发不早于一个周期
+    for (uint16_t m = _stableButtons; m; m &= (uint16_t)(m - 1)) {
+      uint8_t b = (uint8_t)__builtin_ctz(m);
+      uint32_t held = now - _holdStartMs[b];
+      if (held < delayMs) continue;
+      // 两帧之间跨过多个连发周期时只发一个事件，count 反映应有的连发次数
+      uint32_t due = 1 + (held - delayMs) / _repeatIntervalMs;
+      if (due > 255) due = 255;
+      if (due > _repeatCount[b]) {
+        _repeatCount[b] = (uint8_t)due;
+        pushEvent(PS2_EVENT_REPEAT, b, now, (uint8_t)due);
+      }
+    }
+  }
+}
+
+void YFPS2UARTCore::pushEvent(uint8_t type, uint8_t bit, uint32_t now, uint8_t count) {
+  PS2Event ev;
+  ev.timeMs = now;
+  ev.button = (uint16_t)(1u << bit);
+  ev.type = type;
+  ev.count = count;
+  _events.push(ev);   // 队列满时丢弃并计数
+}
+
+/*
+ * 函数: pollEvent
+ * 功能: 取出最早的一个按键事件
+ * 参数: ev - 输出事件
+ * 返回值: true 表示取到事件；队列为空返回 false
+ */
+bool YFPS2UARTCore::pollEvent(PS2Event& ev) {
+  return _events.pop(ev);
+}
+
+uint16_t YFPS2UARTCore::getEventOverflows() const {
+  return _events.drops();
+}
+
+void YFPS2UARTCore::setLongPressMs(uint16_t ms) {
+  _longPressMs = ms;
+}
+
+void YFPS2UARTCore::setAutoRepeat(uint16_t delayMs, uint16_t intervalMs) {
+  _repeatDelayMs = delayMs;
+  _repeatIntervalMs = intervalMs;
+}
+
+void YFPS2UARTCore::setDoubleTapMs(uint16_t ms) {
+  _doubleTapMs = ms;
+}
+#endif
+
+bool YFPS2UARTCore::onPress(uint16_t mask, PS2ButtonHandler fn, void* ctx) {
+  return setHandlers(false, mask, fn, ctx);
+}
+
+bool YFPS2UARTCore::onRelease(uint16_t mask, PS2ButtonHandler fn, void* ctx) {
+  return setHandlers(true, mask, fn, ctx);
+}
+
+/*
+ * 函数: setHandlers
+ * 功能: 把 mask 中的按键从原有回调项中移除，再并入 (fn, ctx) 对应的项（没有则占用一个空闲项）
+ * 返回值: false 表示回调表已满，mask 中的按键没有注册
+ */
+bool YFPS2UARTCore::setHandlers(bool release, uint16_t mask, PS2ButtonHandler fn, void* ctx) {
+  ButtonHandler* slot = nullptr;
+  ButtonHandler* freeSlot = nullptr;
+  uint16_t pressMask = 0, releaseMask = 0;
+  for (uint8_t i = 0; i < YFPS2UART_BUTTON_HANDLERS; ++i) {
+    ButtonHandler& h = _handlers[i];
+    (release ? h.release : h.press) &= (uint16_t)~mask;
+    if (h.press == 0 && h.release == 0) {
+      h.fn = nullptr;
+      if (!freeSlot) freeSlot = &h;
+    } else if (h.fn == fn && h.ctx == ctx) {
+      slot = &h;
+    }
+    pressMask |= h.press;
+    releaseMask |= h.release;
+  }
+  bool ok = true;
+  if (fn && mask) {
+    if (!slot && freeSlot) {
+      slot = freeSlot;
+      slot->fn = fn;
+      slot->ctx = ctx;
+    }
+    if (slot) {
+      (release ? slot->release : slot->press) |= mask;
+      (release ? releaseMask : pressMask) |= mask;
+    } else {
+      ok = false;
+    }
+  }
+  _pressHandlerMask = pressMask;
+  _releaseHandlerMask = releaseMask;
+  return ok;
+}
+
+// 调用 bit 对应的回调（每次都重新查找：之前的回调中可能修改了注册）
+void YFPS2UARTCore::callHandler(bool release, uint16_t bit, PS2Event& ev) {
+  for (uint8_t i = 0; i < YFPS2UART_BUTTON_HANDLERS; ++i) {
+    const ButtonHandler& h = _handlers[i];
+    if ((release ? h.release : h.press) & bit) {
+      ev.button = bit;
+      ev.type = release ? PS2_EVENT_RELEASE : PS2_EVENT_PRESS;
+      h.fn(ev, h.ctx);
+      return;
+    }
+  }
+}
+
+/*
+ * 函数: dispatchHandlers
+ * 功能: 调用本次 update() 中发生边沿的按键回调，只遍历待分发的位
+ * 说明: 同一按键既有按下又有释放时，按最终状态排序（当前按住：先释放后按下；当前松开：先按下后释放）
+ */
+void YFPS2UARTCore::dispatchHandlers() {
+  uint16_t press = _pendingPress & _pressHandlerMask;
+  uint16_t release = _pendingRelease & _releaseHandlerMask;
+  _pendingPress = _pendingRelease = 0;
+  PS2Event ev;
+  ev.timeMs = _frameTimeMs;
+  ev.count = 0;
+  uint16_t releaseFirst = release & _stableButtons;
+  for (uint16_t m = releaseFirst; m; m &= (uint16_t)(m - 1)) {
+    callHandler(true, (uint16_t)(1u << __builtin_ctz(m)), ev);
+  }
+  for (uint16_t m = press; m; m &= (uint16_t)(m - 1)) {
+    callHandler(false, (uint16_t)(1u << __builtin_ctz(m)), ev);
+  }
+  for (uint16_t m = release & ~releaseFirst; m; m &= (uint16_t)(m - 1)) {
+    callHandler(true, (uint16_t)(1u << __builtin_ctz(m)), ev);
+  }
+}
+
+// bool YFPS2UARTCore::wasReleased(uint16_t mask) {
 //   uint16_t hit = _releasedEvents & mask;
 //   if (hit) _releasedEvents &= ~hit;
 //   return (hit != 0);
@@ -369,36 +1605,90 @@ bool YFPS2UART::ButtonReleased(uint16_t button) {
  * @param axis 摇杆轴，使用PSS_LX/PSS_LY/PSS_RX/PSS_RY常量
  * @return 摇杆值（0-255）
 */
-uint8_t YFPS2UART::Analog(byte axis) {
-  // 与PS2X库保持一致的返回值范围（0-255）
-  if (axis == PSS_LX) return _leftX;
-  if (axis == PSS_LY) return _leftY;
-  if (axis == PSS_RX) return _rightX;
-  if (axis == PSS_RY) return _rightY;
-  return 0;
+uint8_t YFPS2UARTCore::Analog(byte axis) {
+  // 与PS2X库保持一致的返回值范围（0-255）；PSS_RX..PSS_LY 连续，直接查表
+  uint8_t i = (uint8_t)(axis - PSS_RX);
+  return (i < 4) ? _axes[i] : 0;
+}
+
+// 获取调理后的摇杆值（-127..127）
+int8_t YFPS2UARTCore::Stick(byte axis) {
+  uint8_t i = (uint8_t)(axis - PSS_RX);
+  return (i < 4) ? (int8_t)(uint8_t)(_sticks >> (i * 8)) : 0;
+}
+
+void YFPS2UARTCore::setStickDeadzone(uint8_t dz, uint8_t mode, uint8_t axes) {
+  _stickCond.setDeadzone(dz, mode, axes);
+}
+
+void YFPS2UARTCore::setStickCurve(const PS2Curve* curve, uint8_t axes, bool inProgmem) {
+  _stickCond.setCurve(curve, axes, inProgmem);
+}
+
+void YFPS2UARTCore::setStickInvert(uint8_t axes) {
+  _stickCond.setInvert(axes);
+}
+
+void YFPS2UARTCore::setStickAutoCenter(bool on, uint8_t window) {
+  _stickCond.setAutoCenter(on, window);
+}
+
+void YFPS2UARTCore::centerSticks() {
+  for (uint8_t i = 0; i < 4; ++i) {
+    _stickCond.setCenter(i, _axes[i]);
+  }
+}
+
+void YFPS2UARTCore::setStickFilter(uint8_t mode, uint8_t k, uint8_t beta) {
+  _stickFilter.configure(mode, k, beta);
+}
+
+uint8_t YFPS2UARTCore::getStickCenter(byte axis) const {
+  uint8_t i = (uint8_t)(axis - PSS_RX);
+  return (i < 4) ? _stickCond.center(i) : 0;
 }
 
 
 
+#if YFPS2UART_ENABLE_AT_QUEUE
+// 不关心结果的指令使用的空回调：有回调时 finishAT() 会立即释放槽位
+static void ignoreATResult(uint8_t, uint8_t, const char*, void*) {}
+#endif
+
 /*
  * 函数: sendATCommand
- * 功能: 将指定的 ASCII 命令发送到对端（通过 SoftwareSerial），并追加 CR+LF。
+ * 功能: 将指定的 ASCII 命令放入 AT 队列发送（追加 CR+LF），不等待响应。
  * 参数:
  *   - cmd (const char*) : 要发送的 AT 命令（例如 "AT+RST" 或 "AT+BAUD=115200"）。
  * 返回值:
- *   - 无（void）。若未初始化 _sw 则直接返回。
+ *   - bool : true 表示已入队；false 表示队列已满、指令过长或未初始化串口。
+ * 说明:
+ *   - 不再清空接收缓冲，已缓存的手柄帧与正在等待的 AT 响应都不受影响；
+ *   - 队列空闲且未运行后台任务时立即发送并 flush，否则按提交顺序由 update()/后台任务发送；
+ *   - 关闭 AT 队列时直接发送并 flush（正在等待响应或后台任务运行期间返回 false）。
  */
-void YFPS2UART::sendATCommand(const char *cmd) {
-  if (!_serial) return;
-  
-  while (_serial->available() > 0) {
-    _serial->read();
+bool YFPS2UARTCore::sendATCommand(const char *cmd) {
+#if !YFPS2UART_ENABLE_AT_QUEUE
+  if (!_ops || !cmd || _atWaiting) return false;
+#if defined(YFPS2UART_HAS_TASK)
+  if (_taskRunning) return false;
+#endif
+  _ops->write(_io, (const uint8_t*)cmd, strlen(cmd));
+  _ops->write(_io, (const uint8_t*)"\r\n", 2);
+  _ops->flush(_io);
+  return true;
+#else
+  uint8_t h = submitAT(cmd, ignoreATResult, nullptr, 0);
+  if (h == 0) return false;
+#if defined(YFPS2UART_HAS_TASK)
+  if (_taskRunning) return true;
+#endif
+  if (_atActive == kNoAT) {
+    serviceAT();
+    if (!findAT(h)) _ops->flush(_io);   // 已写出：等待发送完成，便于随后切换本地波特率
   }
-  
-  _serial->print(cmd);
-  _serial->print("\r\n");
-  
-  _serial->flush();
+  return true;
+#endif
 }
 
 /*
@@ -407,93 +1697,290 @@ void YFPS2UART::sendATCommand(const char *cmd) {
  * 参数:
  *   - 无
  * 返回值:
- *   - 无（void）。
+ *   - bool : true 表示已入队，false 表示队列已满。
  */
-void YFPS2UART::sendResetCommand() {
-  sendATCommand("AT+RST");
+bool YFPS2UARTCore::sendResetCommand() {
+  return sendATCommand("AT+RST");
 }
 
 /*
  * 函数: sendSetBaud
  * 功能: 向对端发送 AT+BAUD=<baud> 指令以请求对端切换波特率。
  * 参数:
- *   - baud (uint32_t) : 要设置的波特率（库中仅允许 9600 或 115200）。
+ *   - baud (uint32_t) : 要设置的波特率（9600 / 19200 / 38400 / 57600 / 115200）。
  * 返回值:
- *   - bool : true 表示命令已发送（参数合法），false 表示不支持该波特率。
+ *   - bool : true 表示命令已入队（参数合法），false 表示不支持该波特率或队列已满。
  * 说明:
  *   - 实际对端是否切换取决于对端固件；若对端切换且 reinitLocal=true，则本地也会切换以继续通信。
  */
-bool YFPS2UART::sendSetBaud(uint32_t baud) {
-  if (baud != 9600 && baud != 115200) {
+bool YFPS2UARTCore::sendSetBaud(uint32_t baud) {
+  bool supported = false;
+  for (size_t i = 0; i < sizeof(kPS2BaudRates) / sizeof(kPS2BaudRates[0]); ++i) {
+    if (kPS2BaudRates[i] == baud) supported = true;
+  }
+  if (!supported) {
     return false;
   }
 
   char cmdBuf[32];
   snprintf(cmdBuf, sizeof(cmdBuf), "AT+BAUD=%lu", (unsigned long)baud);
-  sendATCommand(cmdBuf);
+  return sendATCommand(cmdBuf);
+}
 
-  return true;
+
+/*
+ * 函数: scanATLine
+ * 功能: 帧外收集 AT 响应行：可打印 ASCII 追加到响应，CR LF / LF 结束一行；
+ *       不带文本的 0x0D（帧头）与 0xAB 留给帧解析，其它二进制字节计为噪声。
+ *       行内 CR 之后若不是 LF，说明该 CR 实为帧头：丢弃这段文本并从该字节起开始接收帧负载。
+ * 返回值: 已消耗的字节数
+ */
+size_t YFPS2UARTCore::scanATLine(const uint8_t* data, size_t len) {
+  char* resp = _atLine;
+  for (size_t k = 0; k < len; ++k) {
+    uint8_t c = data[k];
+    if (_atCr) {
+      _atCr = false;
+      if (c == '\n') {
+        completeATLine();
+        return k + 1;
+      }
+      _counters.noiseBytes += _atLineLen;
+      _atLineLen = 0;
+      _receiving = true;
+      _ndx = 0;
+      return k;
+    }
+    if (c == '\r' && _atLineLen) {
+      _atCr = true;
+    } else if (c == '\n' && _atLineLen) {
+      completeATLine();
+      return k + 1;
+    } else if (c >= 0x20 && c < 0x7F) {
+      if (_atLineLen + 1 < _atLineCap) resp[_atLineLen++] = (char)c;   // 超长部分截断
+    } else if (c == 0x0D || c == 0xAB) {
+      return k;
+    } else {
+      ++_counters.noiseBytes;
+    }
+  }
+  return len;
+}
+
+void YFPS2UARTCore::completeATLine() {
+  _atLine[_atLineLen] = '\0';
+  _atLineLen = 0;
+  _atWaiting = false;
+#if YFPS2UART_ENABLE_AT_QUEUE
+  __atomic_store_n(&_at[_atActive].status, (uint8_t)PS2_AT_DONE, __ATOMIC_RELEASE);
+#endif
 }
 
+#if YFPS2UART_ENABLE_AT_QUEUE
+PS2ATSlot* YFPS2UARTCore::findAT(uint8_t handle) {
+  if (handle == 0) return nullptr;
+  for (uint8_t i = 0; i < YFPS2UART_AT_QUEUE_SIZE; ++i) {
+    if (_at[i].handle == handle) return &_at[i];
+  }
+  return nullptr;
+}
 
 /*
- * 函数: sendATCommandWithResponse
- * 功能: 发送 ASCII AT 命令并在指定超时内读取对端返回的一行（以 '\\n' 结束）。
+ * 函数: submitAT
+ * 功能: 把一条 AT 指令放入发送队列（不发送、不等待），由 update() 按提交顺序发送。
  * 参数:
- *   - cmd (const char*): 要发送的 AT 命令，不包含 CR/LF（例如 "AT+VER"）
- *   - respBuf (char*): 接收缓冲区，函数会写入 NUL 结尾字符串
- *   - bufLen (size_t): 缓冲区长度（至少 2）
- *   - timeoutMs (uint32_t): 等待响应的超时时间（毫秒）
+ *   - cmd (const char*): AT 指令，不含 CR/LF
+ *   - fn/ctx: 完成回调（可为 nullptr，改用 getATStatus()/takeATResponse() 轮询）
+ *   - timeoutMs (uint16_t): 发送后等待响应行的时间，0 表示不等待响应
  * 返回值:
- *   - bool: true 表示收到响应并写入 respBuf（去掉末尾 CR/LF），false 表示超时或错误。
+ *   - uint8_t: 句柄；0 表示队列已满、指令过长或未连接串口
  */
-bool YFPS2UART::sendATCommandWithResponse(const char *cmd, char *respBuf, size_t bufLen, uint32_t timeoutMs) {
-  if (!_serial || !respBuf || bufLen < 2) return false;
+uint8_t YFPS2UARTCore::submitAT(const char* cmd, PS2ATHandler fn, void* ctx, uint16_t timeoutMs) {
+  if (!_ops || !cmd || strlen(cmd) >= YFPS2UART_AT_LINE_LEN) return 0;
+  for (uint8_t i = 0; i < YFPS2UART_AT_QUEUE_SIZE; ++i) {
+    PS2ATSlot& slot = _at[i];
+    if (slot.handle != 0) continue;
+    strcpy(slot.cmd, cmd);
+    slot.resp[0] = '\0';
+    slot.fn = fn;
+    slot.ctx = ctx;
+    slot.timeoutMs = timeoutMs;
+    slot.order = _atNextOrder++;
+    slot.handle = _atNextHandle;
+    _atNextHandle = (uint8_t)(_atNextHandle == 0xFF ? 1 : _atNextHandle + 1);
+    __atomic_store_n(&slot.status, (uint8_t)PS2_AT_QUEUED, __ATOMIC_RELEASE);
+    return slot.handle;
+  }
+  return 0;
+}
 
-  while (_serial->available() > 0) {
-    _serial->read();
+uint8_t YFPS2UARTCore::getATStatus(uint8_t handle) const {
+  PS2ATSlot* slot = const_cast<YFPS2UARTCore*>(this)->findAT(handle);
+  return slot ? __atomic_load_n(&slot->status, __ATOMIC_ACQUIRE) : (uint8_t)PS2_AT_NONE;
+}
+
+bool YFPS2UARTCore::takeATResponse(uint8_t handle, char* buf, size_t bufLen) {
+  PS2ATSlot* slot = findAT(handle);
+  if (!slot) return false;
+  uint8_t st = __atomic_load_n(&slot->status, __ATOMIC_ACQUIRE);
+  if (st != PS2_AT_DONE && st != PS2_AT_TIMEOUT) return false;
+  if (slot - _at == _atActive) return false;   // 等待 update() 结束该事务
+  if (buf && bufLen) {
+    strncpy(buf, slot->resp, bufLen - 1);
+    buf[bufLen - 1] = '\0';
   }
+  slot->handle = 0;
+  slot->status = PS2_AT_NONE;
+  return st == PS2_AT_DONE;
+}
 
-  _serial->print(cmd);
-  _serial->print("\r\n");
-  
-  _serial->flush();
-
-  size_t idx = 0;
-  unsigned long start = millis();
-  bool gotLine = false;
-  while (millis() - start < timeoutMs) {
-    while (_serial->available() > 0) {
-      int c = _serial->read();
-      if (c < 0) continue;
-
-      if ((uint8_t)c == 0xAB) {
-        continue;
-      }
+void YFPS2UARTCore::cancelAT(uint8_t handle) {
+  PS2ATSlot* slot = findAT(handle);
+  if (!slot) return;
+  if (slot - _at == _atActive) {
+    _atWaiting = false;   // 之后到达的响应行按噪声处理
+    _atActive = kNoAT;
+  }
+  slot->handle = 0;
+  __atomic_store_n(&slot->status, (uint8_t)PS2_AT_NONE, __ATOMIC_RELEASE);
+}
 
-      if (idx < bufLen - 1) {
-        respBuf[idx++] = (char)c;
-      }
-      if (c == '\n') {
-        gotLine = true;
-        break;
-      }
-    }
-    if (gotLine) break;
+uint8_t YFPS2UARTCore::getATPending() const {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < YFPS2UART_AT_QUEUE_SIZE; ++i) {
+    uint8_t st = __atomic_load_n(&_at[i].status, __ATOMIC_ACQUIRE);
+    if (st == PS2_AT_QUEUED || st == PS2_AT_SENT) ++n;
   }
+  return n;
+}
 
-  if (idx >= bufLen) idx = bufLen - 1;
-  respBuf[idx] = '\0';
+// 结束 idx 的事务：有回调则调用并释放句柄，否则保留结果等待 takeATResponse()
+void YFPS2UARTCore::finishAT(uint8_t idx) {
+  PS2ATSlot& slot = _at[idx];
+  if (!slot.fn) return;
+  slot.fn(slot.handle, slot.status, slot.resp, slot.ctx);
+  slot.handle = 0;
+  slot.status = PS2_AT_NONE;
+}
 
-  if (!gotLine) {
-    return false;
+/*
+ * 函数: serviceAT
+ * 功能: 由 update() 调用：结束已收到响应或已超时的事务，然后发送队列中的下一条指令。
+ *       发送只写入串口，不 flush、不清空接收缓冲。
+ */
+void YFPS2UARTCore::serviceAT() {
+  if (!_ops) return;
+  uint32_t now = millis();
+  if (_atActive != kNoAT) {
+    uint8_t idx = _atActive;
+    PS2ATSlot& slot = _at[idx];
+    uint8_t st = __atomic_load_n(&slot.status, __ATOMIC_ACQUIRE);
+    if (st == PS2_AT_SENT) {
+      if (now - slot.sentMs < slot.timeoutMs) return;
+      _atWaiting = false;
+      slot.resp[_atLineLen] = '\0';   // 保留已收到的部分
+      _atLineLen = 0;
+      __atomic_store_n(&slot.status, (uint8_t)PS2_AT_TIMEOUT, __ATOMIC_RELEASE);
+    }
+    _atActive = kNoAT;
+    finishAT(idx);
+  }
+
+  // 取顺序号最早的排队指令（取消的指令会留下空号）
+  uint8_t next = kNoAT;
+  uint8_t best = 0xFF;
+  for (uint8_t i = 0; i < YFPS2UART_AT_QUEUE_SIZE; ++i) {
+    if (__atomic_load_n(&_at[i].status, __ATOMIC_ACQUIRE) != PS2_AT_QUEUED) continue;
+    uint8_t d = (uint8_t)(_at[i].order - _atSendOrder);
+    if (next == kNoAT || d < best) {
+      next = i;
+      best = d;
+    }
+  }
+  if (next == kNoAT) {
+    _atSendOrder = _atNextOrder;
+    return;
   }
 
-  while (idx > 0 && (respBuf[idx - 1] == '\n' || respBuf[idx - 1] == '\r')) {
-    respBuf[--idx] = '\0';
+  PS2ATSlot& slot = _at[next];
+  _atSendOrder = (uint8_t)(slot.order + 1);
+  _ops->write(_io, (const uint8_t*)slot.cmd, strlen(slot.cmd));
+  _ops->write(_io, (const uint8_t*)"\r\n", 2);
+  slot.sentMs = now;
+  if (slot.timeoutMs == 0) {
+    slot.status = PS2_AT_DONE;
+    finishAT(next);
+    return;
   }
+  _atLine = slot.resp;
+  _atLineCap = YFPS2UART_AT_LINE_LEN;
+  _atLineLen = 0;
+  _atCr = false;
+  _atActive = next;
+  __atomic_store_n(&slot.status, (uint8_t)PS2_AT_SENT, __ATOMIC_RELEASE);
+  _atWaiting = true;
+}
+#endif
 
-  return true;
+/*
+ * 函数: sendATCommandWithResponse
+ * 功能: 发送 ASCII AT 命令并在指定超时内读取对端返回的一行（以 '\\n' 结束）。
+ * 参数:
+ *   - cmd (const char*): 要发送的 AT 命令，不包含 CR/LF（例如 "AT+VER"）
+ *   - respBuf (char*): 接收缓冲区，函数会写入 NUL 结尾字符串
+ *   - bufLen (size_t): 缓冲区长度（至少 2）
+ *   - timeoutMs (uint32_t): 等待响应的超时时间（毫秒）
+ * 返回值:
+ *   - bool: true 表示收到响应并写入 respBuf（去掉末尾 CR/LF），false 表示超时或错误。
+ */
+bool YFPS2UARTCore::sendATCommandWithResponse(const char *cmd, char *respBuf, size_t bufLen, uint32_t timeoutMs) {
+  if (!_ops || !respBuf || bufLen < 2) return false;
+  respBuf[0] = '\0';
+
+  if (timeoutMs == 0) timeoutMs = 1;
+#if !YFPS2UART_ENABLE_AT_QUEUE
+  // 不使用队列：直接发送，解析器把响应行写入 respBuf，等待期间继续解码手柄帧
+  if (!cmd || _atWaiting) return false;
+#if defined(YFPS2UART_HAS_TASK)
+  if (_taskRunning) return false;
+#endif
+  _atLine = respBuf;
+  _atLineCap = (uint8_t)(bufLen > 0xFF ? 0xFF : bufLen);
+  _atLineLen = 0;
+  _atCr = false;
+  _ops->write(_io, (const uint8_t*)cmd, strlen(cmd));
+  _ops->write(_io, (const uint8_t*)"\r\n", 2);
+  _atWaiting = true;
+  uint32_t start = millis();
+  while (_atWaiting && millis() - start < timeoutMs) {
+    step();
+    delayMicroseconds(50);
+  }
+  if (!_atWaiting) return true;
+  _atWaiting = false;
+  respBuf[_atLineLen] = '\0';   // 超时：保留已收到的部分
+  _atLineLen = 0;
+  return false;
+#else
+  // 基于非阻塞队列实现：等待期间继续解码手柄帧，不再清空接收缓冲
+  uint8_t h = submitAT(cmd, nullptr, nullptr, (uint16_t)(timeoutMs > 0xFFFF ? 0xFFFF : timeoutMs));
+  if (h == 0) return false;
+  for (;;) {
+    // 等到状态完成且 update() 已结束该事务（之后才能取走结果）
+    PS2ATSlot* slot = findAT(h);
+    uint8_t st = getATStatus(h);
+    if (!slot || (st != PS2_AT_QUEUED && st != PS2_AT_SENT && slot - _at != _atActive)) break;
+#if defined(YFPS2UART_HAS_TASK)
+    if (_taskRunning) {
+      delay(1);   // 后台任务负责发送与接收
+      continue;
+    }
+#endif
+    step();
+    delayMicroseconds(50);
+  }
+  return takeATResponse(h, respBuf, bufLen);
+#endif
 }
 
 /*
@@ -507,7 +1994,7 @@ bool YFPS2UART::sendATCommandWithResponse(const char *cmd, char *respBuf, size_t
  * 说明:
  *   - 发送 AT+BAUD? 命令并解析返回的波特率值
  */
-bool YFPS2UART::queryBaudRate(uint32_t& baudRate, uint32_t timeoutMs) {
+bool YFPS2UARTCore::queryBaudRate(uint32_t& baudRate, uint32_t timeoutMs) {
   char respBuf[32];
   
   bool ok = sendATCommandWithResponse("AT+BAUD?", respBuf, sizeof(respBuf), timeoutMs);
@@ -534,13 +2021,13 @@ bool YFPS2UART::queryBaudRate(uint32_t& baudRate, uint32_t timeoutMs) {
  * 返回值:
  *   - bool: true 表示收到并打印响应，false 表示未收到。
  */
-bool YFPS2UART::sendATCommandPrintResponse(const char *cmd, uint32_t timeoutMs) {
+bool YFPS2UARTCore::sendATCommandPrintResponse(const char *cmd, uint32_t timeoutMs) {
   char buf[128];
   return sendATCommandWithResponse(cmd, buf, sizeof(buf), timeoutMs);
 }
 
 
-// void YFPS2UART::readData() {
+// void YFPS2UARTCore::readData() {
 //   static boolean ZZS = false;
 //   static byte ndx = 0;
 //   byte start_MA = 0x0D;
@@ -3,14 +3,52 @@
 #define YFPS2UART_H
 
 #include <Arduino.h>
+#include "YFPS2UARTRing.h"
+#include "YFPS2UARTStats.h"
+#include "YFPS2UARTAT.h"
+#include "YFPS2UARTVibe.h"
+#include "YFPS2UARTStick.h"
+#include "YFPS2UARTFilter.h"
+#include "YFPS2UARTCapture.h"
+#include "YFPS2UARTLink.h"
 
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5) 
+// 支持 SoftwareSerial 的平台（主机端使用兼容层中的 SoftwareSerial 桩，以便测试软串口构造/析构路径）
+#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5) || defined(YFPS2UART_HOST)
+#define YFPS2UART_HAS_SOFTSERIAL 1
+#endif
+
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
 #include <SoftwareSerial.h>
 #include <HardwareSerial.h>
 #elif defined(ESP32)
 #include <HardwareSerial.h>
 #endif
 
+// 定位 new（串口与适配器对象构造在对象内部的存储中，不使用堆）
+#if defined(__AVR__)
+#include <new.h>
+#else
+#include <new>
+#endif
+
+// 后台任务模式：ESP32 上使用 FreeRTOS 任务，主机端使用 std::thread；AVR 不支持
+#if defined(ESP32) || defined(YFPS2UART_HOST)
+#define YFPS2UART_HAS_TASK 1
+#include "YFPS2UARTSeqlock.h"
+#if defined(YFPS2UART_HOST)
+#include <chrono>
+#include <thread>
+
+// std::thread 的可拷贝外壳：拷贝/赋值得到空线程。只在后台任务已停止后随引擎状态一起移动
+struct PS2HostThread {
+    std::thread t;
+    PS2HostThread() {}
+    PS2HostThread(const PS2HostThread&) {}
+    PS2HostThread& operator=(const PS2HostThread&) { return *this; }
+};
+#endif
+#endif
+
 // 抽象串口基类
 class SerialBase {
 public:
@@ -21,6 +59,31 @@ public:
     virtual void write(uint8_t data) = 0;
     virtual void print(const char* str) = 0;
     virtual void flush() = 0;
+
+    // 新增：注册接收回调（有数据到达时调用 cb(ctx)），平台不支持时返回 false
+    virtual bool onReceive(void (*cb)(void*), void* ctx) {
+        (void)cb;
+        (void)ctx;
+        return false;
+    }
+
+    // 新增：同一时刻只能有一个实例接收的串口（如 SoftwareSerial）返回 true，listen() 切换为当前接收者
+    virtual bool needsListen() const { return false; }
+    virtual void listen() {}
+
+    // 新增：批量非阻塞读取，最多读取 len 字节，返回实际读取的字节数（无数据时返回 0）。
+    // 默认实现逐字节调用 read()；适配器可重写为底层的批量读取，减少每字节的虚函数调用。
+    virtual size_t readBytes(uint8_t* buf, size_t len) {
+        int avail = available();
+        if (avail <= 0) return 0;
+        size_t n = ((size_t)avail < len) ? (size_t)avail : len;
+        for (size_t i = 0; i < n; ++i) {
+            int c = read();
+            if (c < 0) return i;
+            buf[i] = (uint8_t)c;
+        }
+        return n;
+    }
 };
 
 // 硬件串口适配器
@@ -58,9 +121,32 @@ public:
     void flush() override {
         _serial->flush();
     }
+    size_t readBytes(uint8_t* buf, size_t len) override {
+        int avail = _serial->available();
+        if (avail <= 0) return 0;
+        size_t n = ((size_t)avail < len) ? (size_t)avail : len;
+#if defined(ESP32)
+        return _serial->read(buf, n);   // ESP32 核心提供非阻塞批量读取
+#else
+        for (size_t i = 0; i < n; ++i) {
+            buf[i] = (uint8_t)_serial->read();
+        }
+        return n;
+#endif
+    }
+#if defined(ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR) && (ESP_ARDUINO_VERSION_MAJOR >= 2)
+    bool onReceive(void (*cb)(void*), void* ctx) override {
+        if (cb) {
+            _serial->onReceive([cb, ctx]() { cb(ctx); });
+        } else {
+            _serial->onReceive(NULL);
+        }
+        return true;
+    }
+#endif
 };
 
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5)
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
 // 软件串口适配器
 class SoftwareSerialAdapter : public SerialBase {
 private:
@@ -85,6 +171,17 @@ public:
     void flush() override {
         _serial->flush();
     }
+    bool needsListen() const override { return true; }
+    void listen() override { _serial->listen(); }
+    size_t readBytes(uint8_t* buf, size_t len) override {
+        int avail = _serial->available();
+        if (avail <= 0) return 0;
+        size_t n = ((size_t)avail < len) ? (size_t)avail : len;
+        for (size_t i = 0; i < n; ++i) {
+            buf[i] = (uint8_t)_serial->read();
+        }
+        return n;
+    }
 };
 #endif
 
@@ -124,24 +221,179 @@ enum SerialType {
 #define VIBRATE_LEFT 0x02
 #define VIBRATE_RIGHT 0x03
 
-class YFPS2UART {
-public:
-    // Constructor
-    // 构造函数优化：如果是 AVR，可以选软硬串口；如果是 ESP32，强制硬串口
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5) 
-    YFPS2UART(SerialType serialType = SERIALTYPE_SW, uint8_t rxPin = 11, uint8_t txPin = 10, HardwareSerial* hwSerial = &Serial);
-#elif defined(ESP32) 
-    YFPS2UART(uint8_t rxPin = 16, uint8_t txPin = 17, HardwareSerial* hwSerial = &Serial2);
+// 回调接收模式下的帧队列容量（2 的幂）
+#ifndef YFPS2UART_FRAME_RING_SIZE
+#if defined(__AVR__)
+#define YFPS2UART_FRAME_RING_SIZE 4
+#else
+#define YFPS2UART_FRAME_RING_SIZE 16
 #endif
-    ~YFPS2UART();
+#endif
+
+// 接收分块大小：readDataFromSerial() 每次从串口批量读取的最大字节数
+#ifndef YFPS2UART_RX_CHUNK
+#if defined(__AVR__)
+#define YFPS2UART_RX_CHUNK 16
+#else
+#define YFPS2UART_RX_CHUNK 64
+#endif
+#endif
+static_assert(YFPS2UART_RX_CHUNK > 0 && YFPS2UART_RX_CHUNK <= 255, "YFPS2UART_RX_CHUNK must be 1..255 (_rxPos/_rxLen are uint8_t)");
 
+// 按键事件队列（pollEvent()、长按/连发/双击、getHoldMs()）。为 0 时移除事件队列与每个按键的按住计时，
+// 只保留 Button()/ButtonPressed()/ButtonReleased() 与按键回调。
+// Arduino IDE 不会把草图中的 #define 传给库，请通过编译参数（-DYFPS2UART_ENABLE_EVENTS=0/1）修改默认值。
+#ifndef YFPS2UART_ENABLE_EVENTS
+#if defined(__AVR__)
+#define YFPS2UART_ENABLE_EVENTS 0   // AVR 内存紧张，默认关闭
+#else
+#define YFPS2UART_ENABLE_EVENTS 1
+#endif
+#endif
+
+// 按键事件队列容量（2 的幂）
+#ifndef YFPS2UART_EVENT_QUEUE_SIZE
+#if defined(__AVR__)
+#define YFPS2UART_EVENT_QUEUE_SIZE 8
+#else
+#define YFPS2UART_EVENT_QUEUE_SIZE 32
+#endif
+#endif
+
+// 按键事件类型
+enum PS2EventType {
+    PS2_EVENT_PRESS = 1,     // 按下（去抖后）
+    PS2_EVENT_RELEASE,       // 释放（去抖后）
+    PS2_EVENT_LONG_PRESS,    // 按住超过 setLongPressMs() 设定的时间（每次按下最多一次）
+    PS2_EVENT_REPEAT,        // 按住期间的自动连发（见 setAutoRepeat()）
+    PS2_EVENT_DOUBLE_TAP     // 两次按下间隔不超过 setDoubleTapMs()，紧跟在第二次 PRESS 之后
+};
+
+// 按键事件：每个事件只对应一个按键
+struct PS2Event {
+    uint32_t timeMs;    // 产生事件的帧时间（毫秒）
+    uint16_t button;    // 按键掩码（PSB_*，单个位）
+    uint8_t type;       // PS2EventType
+    uint8_t count;      // REPEAT：本次按住的第几次连发（饱和于 255）；其他事件为 0
+};
+
+// 按键回调：ev 为对应的 PRESS/RELEASE 事件，ctx 为注册时传入的用户指针
+typedef void (*PS2ButtonHandler)(const PS2Event& ev, void* ctx);
+
+// 按键回调表容量：每个不同的 (fn, ctx) 占一项，同一 fn/ctx 的按下与释放、多个按键共用一项
+#ifndef YFPS2UART_BUTTON_HANDLERS
+#if defined(__AVR__)
+#define YFPS2UART_BUTTON_HANDLERS 6
+#else
+#define YFPS2UART_BUTTON_HANDLERS 8
+#endif
+#endif
+
+// 手柄状态（POD）：一次拷贝拿到互相一致的按键、摇杆、时间戳与帧序号。
+// 4 个摇杆轴打包在一个 32 位字中，第 i 个字节对应 PSS_RX + i（RX, RY, LX, LY）。
+struct PS2State {
+    uint16_t buttons;   // 去抖后的稳定按键值
+    uint32_t axes;      // 打包的摇杆值
+    uint32_t sticks;    // 打包的调理后摇杆值（int8，-127..127，见 YFPS2UARTStick.h）
+    uint32_t timeMs;    // 该帧的到达时间（毫秒）
+    uint32_t seq;       // 帧序号（从 1 开始，0 表示尚无数据）
+    uint32_t changeSeq; // 最近一次有意义变化（按键变化或摇杆超过阈值）所在的帧序号，0 表示尚无变化
+
+    bool button(uint16_t mask) const { return (buttons & mask) != 0; }
+    // 取摇杆值（0-255），axis 使用 PSS_LX/PSS_LY/PSS_RX/PSS_RY
+    uint8_t analog(uint8_t axis) const {
+        uint8_t i = (uint8_t)(axis - PSS_RX);
+        return (i < 4) ? (uint8_t)(axes >> (i * 8)) : 0;
+    }
+    // 取调理后的摇杆值（-127..127）
+    int8_t stick(uint8_t axis) const {
+        uint8_t i = (uint8_t)(axis - PSS_RX);
+        return (i < 4) ? (int8_t)(uint8_t)(sticks >> (i * 8)) : 0;
+    }
+};
+
+// 变化检测结果
+struct PS2Change {
+    uint16_t buttons;   // 变化的按键（去抖后）
+    uint8_t axes;       // 超过阈值的轴（bit i 对应 PSS_RX + i，见 PS2_AXIS_BIT）
+    uint32_t seq;       // 最近一次变化所在的帧序号
+};
+
+// 模块支持的波特率（从低到高）
+static const uint32_t kPS2BaudRates[] = {9600, 19200, 38400, 57600, 115200};
+
+// 自动波特率结果
+struct PS2BaudReport {
+    uint32_t detectedBaud;   // 探测到的模块波特率（0 表示未找到）
+    uint32_t finalBaud;      // 结束时双方使用的波特率（0 表示未找到）
+    uint16_t fpsBefore;      // 升级前实测的好帧帧率（帧/秒）
+    uint16_t fpsAfter;       // 结束时实测的好帧帧率（未升级时等于 fpsBefore）
+    uint8_t probes;          // 尝试过的波特率次数（含升级验证）
+    bool viaAT;              // 探测是否依靠 AT+BAUD? 响应（手柄未连接、没有帧时）
+};
+
+// 帧解析计数器
+struct PS2FrameCounters {
+    uint32_t good;          // 完整好帧
+    uint32_t shortFrames;   // 短帧：帧结束符提前出现、紧跟着下一个帧头
+    uint32_t longFrames;    // 长帧/坏帧：第 7 个字节不是 0x0A
+    uint32_t resynced;      // 坏帧后在已收字节中重新找到帧头的次数
+    uint32_t noiseBytes;    // 帧外被丢弃的字节数
+};
+
+// 新增：传输层操作表。解析引擎只通过这几个函数访问串口，每次最多读取一整块（YFPS2UART_RX_CHUNK 字节），
+// 因此每块只有一次间接调用；逐字节的 available()/read() 在各传输层自己的实现中完成（模板版本可被完全内联）。
+struct PS2TransportOps {
+    size_t (*readBytes)(void* io, uint8_t* buf, size_t len);   // 非阻塞批量读取，返回实际读取的字节数
+    void (*write)(void* io, const uint8_t* data, size_t len);
+    void (*flush)(void* io);
+    bool (*onReceive)(void* io, void (*cb)(void*), void* ctx); // 注册接收回调，可为 nullptr（不支持）
+};
+
+// 新增：与传输层无关的解析/按键/事件引擎，YFPS2UART（SerialBase）与 YFPS2UARTT<SerialT>（模板）共用
+class YFPS2UARTCore {
+public:
     // Public methods
 
-    void begin(unsigned long espBaud = 9600);
     void update();  // 在 loop 中定期调用，处理接收数据并触发震动检测
 
+    // 新增：“最新帧优先”模式。开启后 update() 读空串口积压，只用最新一帧的摇杆值，
+    // 旧帧仍参与按键去抖/边沿检测（不丢按键）；默认关闭（每次 update() 处理一帧）
+    void setDrainMode(bool latestWins);
+    uint32_t getStaleFrameCount() const;   // 累计被跳过的旧帧数
+    uint16_t getMaxStaleFrames() const;    // 单次 update() 跳过旧帧数的最大值
+    void resetStaleFrameCount();
+
+    // 新增：回调/中断接收模式。帧在串口接收回调（如 ESP32 HardwareSerial::onReceive）中组装，
+    // 写入无锁 SPSC 帧队列，update() 只负责取出并处理队列中的所有帧（摇杆取最新一帧）。
+    // 返回 true 表示已自动注册串口接收回调；false 表示平台不支持，需自行在中断/回调中调用 receiveFromISR()。
+    // 注意：该模式下串口只由生产者读取，AT 指令函数不会再读取/清空接收缓冲。
+    bool beginCallbackReceive();
+    void endCallbackReceive();
+    void receiveFromISR();                 // 生产者：读取串口并把完整帧写入队列
+    uint8_t getQueuedFrames() const;       // 队列中待处理的帧数
+    uint16_t getRingDrops() const;         // 队列满而丢弃的帧数
+
+    // 新增：直接解析调用者提供的字节（DMA 缓冲、自有驱动等），不经过串口 read()。
+    // 负载从 data 中按段拷贝，跨越两次调用的帧会在下一次调用中拼完；本次解出的每一帧都参与按键去抖/事件，
+    // 摇杆取最新一帧。nowUs 为这批数据的到达时间（micros() 时基）。返回本次完成的帧数。
+    // 不要与 update()/receiveFromISR() 混用在同一对象上（两者各自维护未解析完的字节）。
+    uint16_t feed(const uint8_t* data, size_t len, uint32_t nowUs);
+
+#if defined(YFPS2UART_HAS_TASK)
+    // 新增：后台任务模式（ESP32 FreeRTOS 任务 / 主机端 std::thread）。
+    // 任务独占串口与解码，每解出一帧通过顺序锁发布一次 PS2State；
+    // 其它任务/核心用 readSnapshot() 无锁读取一致的快照。此模式下 update() 不做任何事，
+    // Button()/Analog() 等访问器读取的是任务内部状态，跨任务使用时请改用 readSnapshot()。
+    // core/priority 仅在 ESP32 上生效；periodMs 为任务两次轮询之间的间隔（0 表示只做最短的让出：ESP32 上 1 个 tick）。
+    bool startBackgroundTask(uint8_t core = 0, uint8_t priority = 2, uint16_t periodMs = 1);
+    void stopBackgroundTask();
+    bool readSnapshot(PS2State& out) const;   // 返回 false 表示尚未收到任何帧
+#endif
+
     // 去抖设置 & 读取按键，可配置的去抖时间（ms）
     void setDebounceMs(uint16_t ms);
+    uint16_t getDebounceMs() const;
     unsigned int getButtons();        // 去抖后的稳定按键值
     unsigned int getRawButtons();     // 最近帧原始按键值（未去抖）
     
@@ -153,25 +405,93 @@ public:
     // 参考PS2X库添加的函数
     // bool NewButtonState();               // 检查是否有任何按键状态改变
     // bool NewButtonState(uint16_t button); // 检查特定按键是否有状态改变
+    // 新增：变化检测。每帧把去抖后的按键与摇杆值打包成一个 64 位字，与上一帧一次比较，相同则直接跳过；
+    // 不同时按键任一位变化、或某轴相对上次报告的值变化达到阈值才算有意义的变化（阈值内来回抖动不报告，
+    // 超过阈值后以新值为基准，即带回差的死区）。
+    bool hasChanged(PS2Change* out = nullptr);   // 自上次调用以来是否有变化（调用后清除），out 返回累计的变化掩码
+    bool changedSince(uint32_t seq) const;       // 帧序号 seq 之后是否有变化（不清除，多个使用者各自保存 seq）
+    uint32_t getChangeSeq() const;               // 最近一次变化所在的帧序号
+    void setAxisThreshold(uint8_t counts, uint8_t axes = PS2_AXES_ALL);   // 原始计数，默认 2（最小 1）
+
     bool Button(uint16_t button);        // 检查按键当前是否被按下
     bool ButtonPressed(uint16_t button);  // 检查按键是否刚被按下
     bool ButtonReleased(uint16_t button); // 检查按键是否刚被释放
+#if YFPS2UART_ENABLE_EVENTS
+    uint32_t getHoldMs(uint16_t button);  // 新增：按键已按住的时长（毫秒），未按下返回 0
+
+    // 新增：按键事件队列（定长、无堆分配）。update() 按帧顺序写入按下/释放/长按/连发/双击事件，
+    // 两次轮询之间的多次按下不会合并；每次 loop() 用 pollEvent() 取完即可。
+    // 队列满时新事件被丢弃并计入 getEventOverflows()。后台任务模式下也可在其他任务中调用 pollEvent()。
+    bool pollEvent(PS2Event& ev);
+    uint16_t getEventOverflows() const;
+    void setLongPressMs(uint16_t ms);                        // 0 表示关闭（默认）
+    void setAutoRepeat(uint16_t delayMs, uint16_t intervalMs); // 按住 delayMs 后每 intervalMs 连发一次，intervalMs 为 0 表示关闭（默认）
+    void setDoubleTapMs(uint16_t ms);                         // 两次按下的最大间隔，0 表示关闭（默认）
+#endif
+
+    // 新增：按键回调。为 mask 中的每个按键注册回调（覆盖这些按键原有的回调），fn 为 nullptr 时取消注册。
+    // 回调表只保存已注册的 (fn, ctx)，容量为 YFPS2UART_BUTTON_HANDLERS，表满时返回 false（mask 中的按键不注册）。
+    // update() 结束时只遍历发生变化且注册了回调的按键位（ctz），开销与实际变化数成正比。
+    // 一次 update() 内同一按键的多次边沿合并为一次按下/释放（需要逐帧完整序列请用 pollEvent()）；
+    // 后台任务模式下回调在后台任务中执行。
+    bool onPress(uint16_t mask, PS2ButtonHandler fn, void* ctx = nullptr);
+    bool onRelease(uint16_t mask, PS2ButtonHandler fn, void* ctx = nullptr);
     
     
     // 获取摇杆值（0-255）
     uint8_t Analog(byte axis);
+
+    // 新增：调理后的摇杆值（-127..127，0 为中心；见 YFPS2UARTStick.h），每帧计算一次。
+    // 以下设置从下一帧起生效；axes 为轴掩码（PS2_AXES_ALL / PS2_AXES_LEFT / PS2_AXES_RIGHT / PS2_AXIS_BIT(PSS_LX) 等）
+    int8_t Stick(byte axis);
+    void setStickDeadzone(uint8_t dz, uint8_t mode = PS2_DEADZONE_AXIAL, uint8_t axes = PS2_AXES_ALL);  // dz 为原始计数
+    void setStickCurve(const PS2Curve* curve, uint8_t axes = PS2_AXES_ALL, bool inProgmem = false);     // nullptr 恢复线性
+    void setStickInvert(uint8_t axes);                           // 取反的轴（例如让 Y 轴向上为正）
+    void setStickAutoCenter(bool on, uint8_t window = 12);       // 静止（距中心不超过 window）时缓慢跟踪中心
+    void centerSticks();                                          // 以最近一帧的原始值作为中心
+    uint8_t getStickCenter(byte axis) const;
+
+    // 新增：摇杆低通滤波（见 YFPS2UARTFilter.h），在调理之前每帧计算一次，Analog()/Stick()/getState() 均为滤波后的值。
+    // mode: PS2_FILTER_OFF（默认）/ PS2_FILTER_EMA / PS2_FILTER_ADAPTIVE；k: 平滑强度 0..7（系数 1/2^k）；
+    // beta: 自适应模式下移动速度对系数的增益
+    void setStickFilter(uint8_t mode, uint8_t k = 2, uint8_t beta = 32);
+
+    // 新增：一次性拷贝完整状态（按键 + 打包的 4 轴 + 帧时间 + 帧序号），
+    // 避免多次调用 Button()/Analog() 期间状态被 update() 修改；后台任务模式下读取顺序锁快照
+    void getState(PS2State& out) const;
+
+#if YFPS2UART_STATS
+    // 新增：帧时序统计（微秒直方图：帧间隔、帧读入到 update() 返回的延迟、update() 耗时）。
+    // 编译时定义 YFPS2UART_STATS=0 可完全移除统计代码（AVR 默认关闭）。
+    // 注意：轮询模式下“读入时间”即 update() 从串口取到该帧的时间；回调/后台任务模式下为接收回调解析出该帧的时间。
+    void getStats(PS2Stats& out) const;
+    void resetStats();
+#endif
     
     // 手动发送震动命令
     void sendVibrate(uint8_t cmd);
 
-    // 新增：向对端发送任意 AT 指令（会发送 CR+LF）
-    void sendATCommand(const char *cmd);
+    // 新增：非阻塞震动（见 YFPS2UARTVibe.h）。请求由 update() 限速发送，不清空接收缓冲、不 flush；
+    // 间隔内的多个请求合并为一条（左 + 右 = 双），已被正在进行的震动覆盖的请求丢弃。
+    // 返回 false 表示指令无效、未连接串口或队列已满。
+    bool queueVibrate(uint8_t cmd);
+    // 播放震动序列：steps 在播放期间必须保持有效（建议 static const），新的序列替换正在播放的序列。
+    // 序列播放期间 queueVibrate() 的请求保留在队列中，序列结束后合并发送。
+    void playVibratePattern(const PS2VibeStep* steps, uint8_t count, bool loop = false);
+    void stopVibratePattern();
+    bool isVibratePatternPlaying() const;
+    void setVibrateIntervalMs(uint16_t ms);   // 两次发送的最小间隔，默认 YFPS2UART_VIBE_INTERVAL_MS
+    uint8_t getVibratePending() const;        // 队列中尚未发送的请求数
+
+    // 新增：向对端发送任意 AT 指令（会发送 CR+LF），经 AT 队列按顺序发送，不清空接收缓冲
+    // （YFPS2UART_ENABLE_AT_QUEUE 为 0 时直接发送）。返回 false 表示队列已满、指令过长或未初始化串口
+    bool sendATCommand(const char *cmd);
 
     // 新增：发送软件复位指令 AT+RST
-    void sendResetCommand();
+    bool sendResetCommand();
 
     // 新增：发送修改波特率指令 AT+BAUD=<baud>
-    // 返回 true 表示命令已发送（仅支持 9600 / 115200），
+    // 返回 true 表示命令已入队（支持 9600 / 19200 / 38400 / 57600 / 115200）
     bool sendSetBaud(uint32_t baud);
 
     // 新增：发送 AT 指令并等待响应，带超时，响应写入 respBuf（包含末尾 NUL）。
@@ -184,32 +504,169 @@ public:
     // 新增：发送 AT 指令并把响应直接打印到主串口（Serial），返回是否收到响应
     bool sendATCommandPrintResponse(const char *cmd, uint32_t timeoutMs = 500);
 
-    // 新增：远端是否处于已连接（非 0xAB 忽略模式）
+#if YFPS2UART_ENABLE_AT_QUEUE
+    // 新增：非阻塞 AT 指令队列（见 YFPS2UARTAT.h）。指令由 update() 按提交顺序发送，等待响应期间手柄帧照常解码。
+    // 返回句柄（非 0）；队列已满、指令过长或未连接串口时返回 0。timeoutMs 为 0 表示不等待响应（如 AT+RST），发送后即完成。
+    // 注册了回调时结果通过回调返回并自动释放句柄；否则用 getATStatus() 轮询，完成后用 takeATResponse() 取走结果。
+    uint8_t submitAT(const char* cmd, PS2ATHandler fn = nullptr, void* ctx = nullptr, uint16_t timeoutMs = 500);
+    uint8_t getATStatus(uint8_t handle) const;              // PS2ATStatus
+    bool takeATResponse(uint8_t handle, char* buf, size_t bufLen);   // 已完成时拷贝响应并释放句柄，收到响应返回 true
+    void cancelAT(uint8_t handle);                          // 取消排队中的指令，或放弃等待已发送指令的响应
+    uint8_t getATPending() const;                           // 尚未完成的指令数（排队 + 等待响应）
+#endif
+
+    // 新增：帧解析计数（好帧 / 短帧 / 长帧 / 重同步 / 帧外噪声字节）
+    void getFrameCounters(PS2FrameCounters& out) const;
+    void resetFrameCounters();
+    uint32_t getRxByteCount() const;   // 累计从串口读取（或 feed() 输入）的字节数
+    bool atFrameBoundary() const;      // 解析器不在帧内且暂存区已解析完（此时切换 SoftwareSerial::listen() 不会截断帧）
+
+    // 新增：录制接收数据（格式见 YFPS2UARTCapture.h）。mode 为 PS2_CAPTURE_RAW（读入的原始字节）或
+    // PS2_CAPTURE_FRAMES（好帧负载与断开/坏帧事件）；cap 为 nullptr 时停止。录制在解码的上下文中进行
+    // （回调模式下为生产者），读取录制内容前先停止录制。
+    void setCapture(PS2Capture* cap, uint8_t mode = PS2_CAPTURE_FRAMES);
+
+    // 新增：远端是否处于已连接（非 0xAB 忽略模式）。只读取解析状态、不读串口，状态由 update() 更新；
+    // 超过 lostMs 没有调用 update() 时状态已过时，返回 true，先检查再 update() 的写法不会停在断开
     bool isRemoteConnected() const;
-    bool hasRecentData(uint32_t timeoutMs = 1000) const;
+    bool hasRecentData(uint32_t timeoutMs = 1000) const;   // 任意字节（含噪声、0xAB）都会刷新，判断链路请用 getLinkState()
 
-private:
+    // 新增：链路质量监测（见 YFPS2UARTLink.h）。每次 update() 结束时按滑动窗口内的好帧率、坏帧比例、
+    // 帧间隙与 0xAB 断开时段更新 Connected / Degraded / Lost / Disconnected 状态，状态变化时调用回调
+    // （与按键回调在同一上下文中）。后台任务模式下 getLinkStats() 为近似值。
+    void setLinkConfig(const PS2LinkConfig& cfg);
+    uint8_t getLinkState() const;   // PS2_LINK_*
+    void getLinkStats(PS2LinkStats& out) const;
+    void onLinkChange(PS2LinkHandler fn, void* ctx = nullptr);
+    // 失效保护（默认关闭）：进入 Lost / Disconnected 时立即释放全部按键（照常产生释放事件与回调，不经过去抖）
+    // 并让摇杆回到中心，作为一次状态更新发布（帧序号 +1）。从最后一个好帧起最迟 lostMs + 一次 update() 间隔生效；
+    // 之后解出的帧照常处理。
+    void setFailsafe(bool on);
+    bool isFailsafeActive() const;   // 开启了失效保护且输出处于安全状态（上电后尚未连接时也为 true）
 
-    SerialBase* _serial;         // 统一指向当前使用的串口对象
-#if defined(__AVR__) || defined(ESP8266) || defined(NRF52) || defined(NRF5) 
-    SoftwareSerial* _sw;     // 仅在软串口模式下分配内存
-    HardwareSerial* _hw;
-    SerialType _serialType;
-    uint8_t _rxPin, _txPin;
-#elif defined(ESP32)
-    HardwareSerial* _hw;
-    uint8_t _rxPin, _txPin;
-    SerialType _serialType;
-#endif
+protected:
+    YFPS2UARTCore(void* io = nullptr, const PS2TransportOps* ops = nullptr);
+    ~YFPS2UARTCore();
+    // 引擎状态的拷贝只供派生类实现移动：先对源对象调用 prepareMove()，再拷贝，最后由派生类转移传输层
+    YFPS2UARTCore(const YFPS2UARTCore&) = default;
+    YFPS2UARTCore& operator=(const YFPS2UARTCore&) = default;
+    const YFPS2UARTCore& prepareMove();   // 停止后台任务与回调接收，返回自身
+    void restartParser();                 // 丢弃未读数据并把解析器恢复到帧外（切换波特率后调用）
+    void attachTransport(void* io, const PS2TransportOps* ops);
+
+    void* _io;                     // 传输层对象（由派生类管理）
+    const PS2TransportOps* _ops;   // 为 nullptr 表示尚未连接传输层
+    bool _syncVibrate;             // sendVibrate 前清空接收缓冲、发送后 flush（AVR 硬串口的原有行为）
+
+private:
     unsigned long _lastReceiveTime;
     bool _newData;
-    byte _buf[8];
+    static const uint8_t kPayloadLen = 6;   // 帧负载长度：buttonsHigh, buttonsLow, LY, LX, RY, RX
+    byte _buf[kPayloadLen + 1];             // 负载 + 第 7 个字节（坏帧时用于重同步）
+    PS2FrameCounters _counters;
     
-    bool _ignoreIncoming;    // 当收到 0xAB（表示手柄未连接）时，库会忽略后续的协议数据，直到下一个 0x0D 起始字节到来
+    bool _ignoreIncoming;    // 帧外收到 0xAB（表示手柄未连接）后置位，直到解出下一个完整好帧
     // 新增：将接收状态从函数静态变量移到成员，方便外部检查/控制
     bool _receiving;      // 是否正在接收一个帧（遇到 start_MA 后为 true）
-    uint8_t _ndx;         // 当前写入 _buf 的索引
-    bool _pendingStart;   // 已接收到 start_MA，但尚未交由 readDataFromSerial 处理（避免丢失）
+    uint8_t _ndx;         // 当前帧已收到的负载字节数
+
+    // 新增：AT 响应行收集
+    char* _atLine;              // 响应行写入的位置（队列槽位，或关闭队列时调用者的缓冲区）
+    uint8_t _atLineCap;         // _atLine 的容量（含结尾 NUL）
+    volatile bool _atWaiting;   // 解析器是否在帧外收集响应行
+    bool _atCr;                 // 响应行中刚收到 CR，等待 LF
+    uint8_t _atLineLen;         // 已收集的响应行长度
+#if YFPS2UART_ENABLE_AT_QUEUE
+    // 新增：非阻塞 AT 指令队列
+    PS2ATSlot _at[YFPS2UART_AT_QUEUE_SIZE];
+    uint8_t _atActive;          // 已发送、正在等待响应的槽位（kNoAT 表示没有）
+    uint8_t _atNextHandle;
+    uint8_t _atNextOrder;       // 下一条提交的顺序号
+    uint8_t _atSendOrder;       // 下一条应发送的顺序号
+    static const uint8_t kNoAT = 0xFF;
+#endif
+
+    // 新增：非阻塞震动
+    PS2SpscRing<PS2VibeRequest, YFPS2UART_VIBE_QUEUE_SIZE> _vibeQueue;
+    uint8_t _vibeLastQueued;      // 最近入队的指令（生产者用于去重）
+    uint8_t _vibeActive;          // 最近一次发送的马达位（bit0 左、bit1 右）
+    uint32_t _vibeSentMs;         // 最近一次发送的时间
+    uint16_t _vibeIntervalMs;
+    const PS2VibeStep* _vibePat;  // 正在播放的序列（nullptr 表示没有）
+    uint8_t _vibePatLen;
+    uint8_t _vibePatPos;          // 下一步的下标
+    bool _vibePatLoop;
+    uint32_t _vibeStepMs;         // 当前步开始的时间
+    uint16_t _vibeStepDur;        // 当前步的持续时间
+    // 序列播放/停止请求：由调用者写入，update() 取走后生效（后台任务模式下也只由任务修改播放状态）
+    const PS2VibeStep* _vibeReqSteps;
+    uint8_t _vibeReqLen;
+    bool _vibeReqLoop;
+    volatile uint8_t _vibeReq;
+    static const uint8_t kVibeReqPlay = 1;
+    static const uint8_t kVibeReqStop = 2;
+
+    // 新增：批量接收暂存区，readDataFromSerial 按块读取后逐帧解析，未解析完的字节留待下次
+    uint8_t _rxChunk[YFPS2UART_RX_CHUNK];
+    uint8_t _rxPos;       // 暂存区中下一个待解析字节的位置
+    uint8_t _rxLen;       // 暂存区中有效字节数
+    uint32_t _rxBytes;    // 累计读入的字节数
+
+    // 新增：录制
+    PS2Capture* _capture;
+    uint8_t _captureMode;
+    uint32_t _captureUs;  // 当前这批数据的到达时间
+
+    // 新增：链路质量监测与失效保护
+    PS2LinkMonitor _link;
+    PS2LinkHandler _linkFn;
+    void* _linkCtx;
+    bool _failsafe;
+    bool _failsafeActive;   // 失效保护已生效（回到 Connected/Degraded 时清除）
+    uint32_t _lastServiceMs; // 最近一次更新链路状态（update()/feed()）的时间
+
+    // 新增：“最新帧优先”模式
+    bool _drainLatest;          // 是否在 update() 中读空积压
+    uint32_t _staleFrames;      // 累计跳过的旧帧数
+    uint16_t _maxStaleFrames;   // 单次 update() 跳过的最大旧帧数
+    uint32_t _lastFrameMs;      // 上一帧的（推算）到达时间
+    uint16_t _frameIntervalMs;  // 估计的帧间隔（无积压时测得）
+
+    // 新增：回调接收模式
+    volatile bool _callbackMode;
+    PS2FrameRing<YFPS2UART_FRAME_RING_SIZE> _ring;
+
+    uint32_t _frameSeq;       // 已处理的帧数（每帧 +1）
+    uint32_t _frameTimeMs;    // 最近一帧的到达时间
+
+#if YFPS2UART_STATS
+    PS2Stats _stats;
+    uint32_t _rxChunkUs;       // 当前接收块读入的时间（微秒）
+    uint32_t _decodedUs;       // 解析器最近解出一帧的时间（生产者写）
+    uint32_t _frameArrivalUs;  // 正在处理的帧的解析时间（消费者写）
+    uint32_t _prevArrivalUs;   // 上一帧的解析时间
+#endif
+
+#if defined(YFPS2UART_HAS_TASK)
+    // 新增：后台任务模式
+    volatile bool _taskRunning;
+    uint16_t _taskPeriodMs;
+    PS2Seqlock<PS2State> _snapshot;
+#if defined(ESP32)
+    TaskHandle_t _taskHandle;
+    volatile bool _taskExited;
+#else
+    PS2HostThread _thread;
+#endif
+    void taskLoop();
+    void publishSnapshot();
+#endif
+    void fillState(PS2State& out) const;
+#if defined(YFPS2UART_HAS_TASK)
+#if defined(ESP32)
+    static void taskEntry(void* arg);
+#endif
+#endif
     
     // unsigned int lastButtons;
     // unsigned long lastReceiveTime;
@@ -219,20 +676,256 @@ private:
     // 去抖 / 按键存储
     uint16_t _rawButtons;      // 最近一帧解析出的原始按键值
     uint16_t _stableButtons;   // 去抖后对外返回的按键值
-    uint32_t _debounceStartMs; // 去抖开始时间
     uint16_t _debounceMs;      // 去抖阈值（毫秒）
+    // 新增：按键独立去抖的垂直计数器，每个按键占 _vc1/_vc0 中同一位组成的 2 位计数
+    uint16_t _vc0;             // 计数低位
+    uint16_t _vc1;             // 计数高位
+    uint16_t _pendingDelta;    // 上一帧中与稳定值不同的按键（从下一帧起开始计数）
+    uint16_t _tickMs;          // 计数节拍（约 _debounceMs / 3，计满 3 拍即接受）
+    uint32_t _lastTickMs;      // 最近一个已计入的节拍时刻
     // 按键事件检测 按下 按住 释放
     uint16_t _lastButtons;
     uint16_t _prevStableButtons;   // 上一周期稳定按键（用于边沿检测）
     uint16_t _pressedEvents;      // 记录未读的按下事件（bit）
     uint16_t _releasedEvents;     // 记录未读的释放事件（bit）
     uint16_t _changedEvents;      // 按键状态变化事件标志位（用于NewButtonState）
-    uint32_t _holdStartMs[16];    // 每位按键的按住开始时间（0 表示未按）
+
+#if YFPS2UART_ENABLE_EVENTS
+    // 新增：按键事件
+    uint32_t _holdStartMs[16];    // 每位按键最近一次按下的时间（释放后保留，用于双击判断）
+    PS2SpscRing<PS2Event, YFPS2UART_EVENT_QUEUE_SIZE> _events;
+    uint16_t _longPressMs;
+    uint16_t _repeatDelayMs;
+    uint16_t _repeatIntervalMs;
+    uint16_t _doubleTapMs;
+    uint16_t _longSent;           // 本次按住已发出长按事件的按键
+    uint16_t _tapArmed;           // 上一次按下可与下一次按下组成双击的按键
+    uint8_t _repeatCount[16];     // 本次按住已发出的连发次数
+#endif
+
+    // 新增：按键回调表（只保存已注册的回调，按掩码查找）
+    struct ButtonHandler {
+        PS2ButtonHandler fn;
+        void* ctx;
+        uint16_t press;     // 使用该回调的按下按键，press 与 release 都为 0 表示空闲
+        uint16_t release;   // 使用该回调的释放按键
+    };
+    ButtonHandler _handlers[YFPS2UART_BUTTON_HANDLERS];
+    uint16_t _pressHandlerMask;     // 注册了按下回调的按键
+    uint16_t _releaseHandlerMask;   // 注册了释放回调的按键
+    uint16_t _pendingPress;         // 本次 update() 中待分发的按下
+    uint16_t _pendingRelease;       // 本次 update() 中待分发的释放
+    bool setHandlers(bool release, uint16_t mask, PS2ButtonHandler fn, void* ctx);
+    void callHandler(bool release, uint16_t bit, PS2Event& ev);
+    void dispatchHandlers();
     
-    // 摇杆缓存
-    uint8_t _leftX, _leftY, _rightX, _rightY;
+    // 摇杆缓存：按 PSS_RX + i 索引（RX, RY, LX, LY）
+    uint8_t _axes[4];
+    // 新增：摇杆调理（applyAxes() 中每帧计算一次）
+    PS2StickFilter _stickFilter;
+    PS2StickConditioner _stickCond;
+    uint32_t _sticks;             // 打包的调理结果
+
+    // 新增：变化检测
+    uint64_t _lastPacked;         // 上一帧的按键 + 摇杆（打包）
+    uint16_t _reportedButtons;    // 上次报告时的按键
+    uint8_t _reportedAxes[4];     // 各轴上次报告的值
+    uint8_t _axisThreshold[4];
+    uint32_t _unreadChanges;      // 未读的变化：bit0..15 按键，bit16..19 轴
+    uint32_t _changeSeq;
+    void detectChanges();
 
+    void step();   // 一次轮询（含计时统计），update() 与后台任务共用
+    void poll();   // update() 的实际处理
     void readDataFromSerial();
+    void processButtons(uint16_t raw, uint32_t now);  // 按键去抖与边沿检测
+    void commitButtons(uint16_t toggle, uint32_t now); // 翻转稳定按键并产生事件
+#if YFPS2UART_ENABLE_EVENTS
+    void processHeld(uint32_t now);                   // 长按与连发事件
+    void pushEvent(uint8_t type, uint8_t bit, uint32_t now, uint8_t count = 0);
+#endif
+    void applyAxes(const byte* axes);                 // 写入摇杆缓存（LY, LX, RY, RX）
+    void noteFrameInterval(uint32_t now);
+    void updateFromRing();
+    static void rxCallback(void* ctx);
+    size_t decodeChunk(const uint8_t* data, size_t len);  // 解析一段数据，遇到帧结束即返回已消耗字节数
+    void resyncFromBuffer();  // 坏帧后在已收字节中寻找下一个帧头
+    size_t scanATLine(const uint8_t* data, size_t len);  // 帧外收集 AT 响应行，停在帧头/0xAB 前
+    void completeATLine();
+#if YFPS2UART_ENABLE_AT_QUEUE
+    void serviceAT();         // 检查超时、分发完成回调并发送下一条指令
+    void finishAT(uint8_t idx);
+    PS2ATSlot* findAT(uint8_t handle);
+#endif
+    void serviceVibrate();    // 推进震动序列，或在限速允许时合并发送排队的请求
+    void serviceLink();       // 更新链路状态，必要时触发失效保护与状态回调
+    void applyFailsafe(uint32_t now);
+    void writeVibrate(uint8_t cmd, uint32_t now);
+    bool fillRxChunk();      // 暂存区为空时从串口批量读取，返回暂存区是否有数据
+    void discardInput();     // 丢弃暂存区与串口中所有未读数据
+};
+
+class YFPS2UART : public YFPS2UARTCore {
+public:
+    // Constructor
+    // 构造函数优化：如果是 AVR，可以选软硬串口；如果是 ESP32，强制硬串口
+    // 串口与适配器对象构造在本对象内部的存储中（不使用堆），析构时一并销毁
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    YFPS2UART(SerialType serialType = SERIALTYPE_SW, uint8_t rxPin = 11, uint8_t txPin = 10, HardwareSerial* hwSerial = &Serial);
+#elif defined(ESP32) 
+    YFPS2UART(uint8_t rxPin = 16, uint8_t txPin = 17, HardwareSerial* hwSerial = &Serial2);
+#endif
+    // 新增：使用外部提供的串口对象（生命周期由调用者管理，析构时不释放），
+    // 可用于自定义传输层或主机端基准测试
+    explicit YFPS2UART(SerialBase* serial);
+    ~YFPS2UART();
+
+    // 新增：不可拷贝（两个对象不能共用同一个串口），可移动。
+    // 移动会停止源对象的后台任务/回调接收；软串口模式下在目标对象中按相同引脚重建 SoftwareSerial 并以原波特率 begin()
+    YFPS2UART(const YFPS2UART&) = delete;
+    YFPS2UART& operator=(const YFPS2UART&) = delete;
+    YFPS2UART(YFPS2UART&& other);
+    YFPS2UART& operator=(YFPS2UART&& other);
+
+    void begin(unsigned long espBaud = 9600);
+
+    /*
+     * 新增：自动波特率（阻塞，在 setup() 中调用）。依次用各候选波特率重新初始化本地串口，
+     * 以“窗口内能否解出连续好帧”判断同步；没有手柄帧时改用 AT+BAUD? 的响应确认。
+     * upgrade 为 true 时，再从高到低尝试把模块切换到不超过 maxBaud 的更高波特率
+     * （AT+BAUD=，必要时 AT+RST），每一步都在新波特率下验证，失败则把模块设置恢复为原波特率。
+     * maxBaud 为 0 时：软串口 38400，硬串口 115200。返回最终波特率，0 表示未找到模块。
+     */
+    uint32_t autoBaud(bool upgrade = false, PS2BaudReport* report = nullptr, uint32_t maxBaud = 0);
+
+    // 新增：串口是否需要 listen() 才能接收（SoftwareSerial），以及切换为当前接收者
+    bool needsListen() const { return _serial && _serial->needsListen(); }
+    void listen() { if (_serial) _serial->listen(); }
+
+private:
+    SerialBase* _serial;         // 统一指向当前使用的串口对象
+    bool _ownsSerial;            // _serial 是否构造在 _adapter 中（析构时销毁）
+    unsigned long _baud;         // 最近一次 begin() 的波特率（0 表示未调用），移动时用于重建软串口
+#if defined(YFPS2UART_HAS_SOFTSERIAL)
+    SoftwareSerial* _sw;     // 仅在软串口模式下指向 _swStore
+    HardwareSerial* _hw;
+    SerialType _serialType;
+    uint8_t _rxPin, _txPin;
+
+    // 对象内存储：联合体只提供大小与对齐，成员由定位 new 构造、显式析构
+    union SoftSerialStore {
+        SoftwareSerial ss;
+        SoftSerialStore() {}
+        ~SoftSerialStore() {}
+    } _swStore;
+    union AdapterStore {
+        HardwareSerialAdapter hw;
+        SoftwareSerialAdapter sw;
+        AdapterStore() {}
+        ~AdapterStore() {}
+    } _adapter;
+#elif defined(ESP32)
+    HardwareSerial* _hw;
+    uint8_t _rxPin, _txPin;
+    SerialType _serialType;
+
+    union AdapterStore {
+        HardwareSerialAdapter hw;
+        AdapterStore() {}
+        ~AdapterStore() {}
+    } _adapter;
+#endif
+
+    void constructTransport();   // 按 _serialType/_hw/引脚在对象内存储中构造串口与适配器
+    void releaseTransport();     // 销毁本对象构造的串口与适配器
+    void takeTransport(YFPS2UART& other);   // 移动：接管 other 的传输层配置
+    bool probeBaud(uint32_t baud, bool* viaAT);     // 以 baud 重新初始化本地串口并检查是否同步
+    uint16_t measureFrameRate(uint16_t windowMs);   // 实测好帧帧率
+    bool switchModuleBaud(uint32_t from, uint32_t to);   // 请求模块切换波特率并在新波特率下验证
+
+    // SerialBase 的传输层操作表（转发到虚函数）
+    static const PS2TransportOps kSerialOps;
+    static size_t opReadBytes(void* io, uint8_t* buf, size_t len);
+    static void opWrite(void* io, const uint8_t* data, size_t len);
+    static void opFlush(void* io);
+    static bool opOnReceive(void* io, void (*cb)(void*), void* ctx);
+};
+
+// 新增：不连接串口的解析引擎，只通过 feed() 输入数据（例如 DMA 接收缓冲或自有 UART 驱动）。
+// AT 指令与震动等发送函数在此对象上不做任何事。
+//
+//   YFPS2UARTDecoder ps2;
+//   ps2.feed(dmaBuf, n, micros());
+class YFPS2UARTDecoder : public YFPS2UARTCore {
+public:
+    YFPS2UARTDecoder() {}
+};
+
+// 新增：静态分派版本。SerialT 为任意提供 available()/read()/write(uint8_t)/flush()（begin() 可选）的串口类型，
+// 例如 HardwareSerial、SoftwareSerial，逐字节调用在编译期确定并可内联；不使用虚函数，也不分配堆内存。
+// SerialT 提供非阻塞的批量 read(uint8_t*, size_t)（如 ESP32/ESP8266 的 HardwareSerial）时，每块只调用一次。
+// 串口对象由调用者持有（生命周期需长于本对象）。ESP32 上自定义引脚时请自行调用 SerialX.begin(baud, SERIAL_8N1, rx, tx)。
+// 不支持自动注册接收回调（beginCallbackReceive() 返回 false，需在自己的中断/回调里调用 receiveFromISR()）。
+//
+//   SoftwareSerial ss(11, 10);
+//   YFPS2UARTT<SoftwareSerial> ps2(ss);
+template <class SerialT>
+class YFPS2UARTT : public YFPS2UARTCore {
+public:
+    explicit YFPS2UARTT(SerialT& serial) : YFPS2UARTCore(&serial, &kOps) {}
+
+    // 不可拷贝，可移动（串口对象仍由调用者持有，移动后源对象不再访问它）
+    YFPS2UARTT(const YFPS2UARTT&) = delete;
+    YFPS2UARTT& operator=(const YFPS2UARTT&) = delete;
+    YFPS2UARTT(YFPS2UARTT&& other) : YFPS2UARTCore(other.prepareMove()) {
+        other.attachTransport(nullptr, nullptr);
+    }
+    YFPS2UARTT& operator=(YFPS2UARTT&& other) {
+        if (this != &other) {
+            prepareMove();
+            YFPS2UARTCore::operator=(other.prepareMove());
+            other.attachTransport(nullptr, nullptr);
+        }
+        return *this;
+    }
+
+    void begin(unsigned long baud = 9600) { stream().begin(baud); }
+    SerialT& stream() { return *static_cast<SerialT*>(_io); }
+
+private:
+    static size_t opReadBytes(void* io, uint8_t* buf, size_t len) {
+        SerialT& s = *static_cast<SerialT*>(io);
+        int avail = s.available();
+        if (avail <= 0) return 0;
+        size_t n = ((size_t)avail < len) ? (size_t)avail : len;
+        return readChunk(s, buf, n, 0);
+    }
+    // 优先使用批量 read(uint8_t*, size_t)（重载决议时 int 比 long 更匹配），没有时逐字节读取
+    template <class S>
+    static auto readChunk(S& s, uint8_t* buf, size_t n, int) -> decltype((size_t)s.read(buf, n)) {
+        return (size_t)s.read(buf, n);
+    }
+    template <class S>
+    static size_t readChunk(S& s, uint8_t* buf, size_t n, long) {
+        for (size_t i = 0; i < n; ++i) {
+            buf[i] = (uint8_t)s.read();
+        }
+        return n;
+    }
+    static void opWrite(void* io, const uint8_t* data, size_t len) {
+        SerialT& s = *static_cast<SerialT*>(io);
+        for (size_t i = 0; i < len; ++i) {
+            s.write(data[i]);
+        }
+    }
+    static void opFlush(void* io) { static_cast<SerialT*>(io)->flush(); }
+
+    static const PS2TransportOps kOps;
+};
+
+template <class SerialT>
+const PS2TransportOps YFPS2UARTT<SerialT>::kOps = {
+    &YFPS2UARTT<SerialT>::opReadBytes, &YFPS2UARTT<SerialT>::opWrite, &YFPS2UARTT<SerialT>::opFlush, nullptr
 };
 
 #endif // YFPS2UART_H
\ No newline at end of file
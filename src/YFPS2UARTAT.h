@@ -0,0 +1,65 @@
+// YFPS2UARTAT.h
+// 非阻塞 AT 指令队列：submitAT() 只把指令放入定长队列，update() 按提交顺序逐条发送并检查超时。
+// 等待响应期间，解析器在帧外把可打印 ASCII 字符收集为响应行（以 CR/LF 结束），
+// 与 0x0D…0x0A 二进制帧分离，因此手柄帧照常解码，不再需要清空接收缓冲。
+#ifndef YFPS2UART_AT_H
+#define YFPS2UART_AT_H
+
+#include <Arduino.h>
+
+// 非阻塞 AT 指令队列（submitAT() 等）。为 0 时移除每个对象中的指令队列：sendATCommand() 直接发送，
+// sendATCommandWithResponse() 阻塞等待，响应行直接写入调用者的缓冲区（等待期间照常解码手柄帧），
+// 后台任务运行期间这两个函数返回 false。
+// Arduino IDE 不会把草图中的 #define 传给库，请通过编译参数（-DYFPS2UART_ENABLE_AT_QUEUE=0/1）修改默认值。
+#ifndef YFPS2UART_ENABLE_AT_QUEUE
+#if defined(__AVR__)
+#define YFPS2UART_ENABLE_AT_QUEUE 0   // AT 指令通常只在 setup() 中使用，AVR 默认关闭以节省内存
+#else
+#define YFPS2UART_ENABLE_AT_QUEUE 1
+#endif
+#endif
+
+// 同时排队/保存结果的指令数
+#ifndef YFPS2UART_AT_QUEUE_SIZE
+#if defined(__AVR__)
+#define YFPS2UART_AT_QUEUE_SIZE 2
+#else
+#define YFPS2UART_AT_QUEUE_SIZE 4
+#endif
+#endif
+
+// 指令与响应行的最大长度（含结尾 NUL，超出部分截断）
+#ifndef YFPS2UART_AT_LINE_LEN
+#if defined(__AVR__)
+#define YFPS2UART_AT_LINE_LEN 20
+#else
+#define YFPS2UART_AT_LINE_LEN 40
+#endif
+#endif
+
+// AT 指令状态
+enum PS2ATStatus {
+    PS2_AT_NONE = 0,    // 句柄无效或结果已取走
+    PS2_AT_QUEUED,      // 等待发送
+    PS2_AT_SENT,        // 已发送，等待响应行
+    PS2_AT_DONE,        // 收到响应行（或不需要响应的指令已发送）
+    PS2_AT_TIMEOUT      // 超时未收到响应
+};
+
+// 完成回调：status 为 PS2_AT_DONE/PS2_AT_TIMEOUT，response 为响应行（已去掉 CR/LF，超时时为已收到的部分）。
+// 回调返回后句柄即被释放。回调在 update()（后台任务模式下为后台任务）中调用。
+typedef void (*PS2ATHandler)(uint8_t handle, uint8_t status, const char* response, void* ctx);
+
+struct PS2ATSlot {
+    char cmd[YFPS2UART_AT_LINE_LEN];
+    char resp[YFPS2UART_AT_LINE_LEN];
+    PS2ATHandler fn;
+    void* ctx;
+    uint32_t sentMs;      // 发送时间
+    uint16_t timeoutMs;   // 0 表示不等待响应
+    uint8_t handle;       // 0 表示空闲
+    uint8_t order;        // 提交顺序（按此顺序发送）
+    uint8_t status;       // PS2ATStatus，发送/完成时用 __atomic 读写（接收回调中也会写）
+};
+
+#endif // YFPS2UART_AT_H
@@ -0,0 +1,340 @@
+#include "YFPS2UARTReplay.h"
+
+static const uint8_t kCaptureMagic = 'P';
+static const uint8_t kCaptureVersion = 1;
+// 一条 RAW 记录最多的字节数：标记 + 最长 5 字节的时间差 + 数据要能放进一个空块
+static const uint8_t kCaptureMaxRaw =
+    (PS2Capture::kBlockSize - PS2Capture::kHeaderSize - 6 > 63) ? 63
+    : (uint8_t)(PS2Capture::kBlockSize - PS2Capture::kHeaderSize - 6);
+
+static uint8_t varintLen(uint32_t v) {
+  uint8_t n = 1;
+  while (v >= 0x80) {
+    v >>= 7;
+    ++n;
+  }
+  return n;
+}
+
+PS2Capture::PS2Capture(uint8_t* storage, size_t bytes)
+  : _mem(storage), _slots((uint16_t)(bytes / kBlockSize)), _sink(nullptr), _sinkCtx(nullptr)
+{
+  clear();
+}
+
+void PS2Capture::setSink(void (*fn)(void* ctx, const uint8_t* block, uint16_t len), void* ctx) {
+  _sink = fn;
+  _sinkCtx = ctx;
+}
+
+void PS2Capture::clear() {
+  _head = 0;
+  _count = 0;
+  _pos = 0;
+  _seq = 0;
+  _lastUs = 0;
+  _overwritten = 0;
+  _records = 0;
+  _havePrev = false;
+}
+
+void PS2Capture::finish() {
+  if (_pos == 0) return;
+  uint8_t* b = cur();
+  memset(b + _pos, 0, kBlockSize - _pos);   // 标记 0x00：本块结束
+  if (_sink) _sink(_sinkCtx, b, kBlockSize);
+  _head = (uint16_t)((_head + 1) % _slots);
+  ++_count;
+  _pos = 0;
+}
+
+/*
+ * 函数: reserve
+ * 功能: 保证当前块还能放下一条记录（标记 + 时间差 + bytes 字节数据），放不下时结束当前块并开始新块。
+ *       新块的基准时间为 us，环满时覆盖最旧的块。
+ * 返回值: 记录的写入位置（标记字节），未提供存储时为 nullptr
+ */
+uint8_t* PS2Capture::reserve(uint8_t bytes, uint32_t us) {
+  if (_slots == 0) return nullptr;
+  if (_pos != 0 && _pos + 1 + varintLen(us - _lastUs) + bytes > kBlockSize) finish();
+  if (_pos == 0) {
+    if (_count == _slots) {
+      --_count;
+      ++_overwritten;
+    }
+    uint8_t* b = cur();
+    b[0] = kCaptureMagic;
+    b[1] = kCaptureVersion;
+    b[2] = (uint8_t)_seq;
+    b[3] = (uint8_t)(_seq >> 8);
+    b[4] = (uint8_t)us;
+    b[5] = (uint8_t)(us >> 8);
+    b[6] = (uint8_t)(us >> 16);
+    b[7] = (uint8_t)(us >> 24);
+    ++_seq;
+    _pos = kHeaderSize;
+    _lastUs = us;
+    _havePrev = false;
+  }
+  ++_records;
+  return cur() + _pos;
+}
+
+uint8_t* PS2Capture::putDelta(uint8_t* p, uint32_t us) {
+  uint32_t d = us - _lastUs;
+  _lastUs = us;
+  while (d >= 0x80) {
+    *p++ = (uint8_t)(d | 0x80);
+    d >>= 7;
+  }
+  *p++ = (uint8_t)d;
+  return p;
+}
+
+void PS2Capture::recordBytes(const uint8_t* data, size_t len, uint32_t us) {
+  while (len > 0) {
+    uint8_t n = (len > kCaptureMaxRaw) ? kCaptureMaxRaw : (uint8_t)len;
+    uint8_t* p = reserve(n, us);
+    if (!p) return;
+    *p = (uint8_t)((PS2_CAPTURE_REC_RAW << 6) | n);
+    p = putDelta(p + 1, us);
+    memcpy(p, data, n);
+    _pos = (uint16_t)(p + n - cur());
+    data += n;
+    len -= n;
+  }
+}
+
+void PS2Capture::recordFrame(const uint8_t payload[6], uint32_t us) {
+  // 先按当前块的上一帧估算变化的字节数；换块后第一帧总是完整记录
+  uint8_t changed = 6;
+  if (_havePrev) {
+    changed = 0;
+    for (uint8_t i = 0; i < 6; ++i) {
+      if (payload[i] != _prev[i]) ++changed;
+    }
+  }
+  uint8_t* p = reserve(changed, us);
+  if (!p) return;
+  uint8_t mask = 0x3F;
+  if (_havePrev) {
+    mask = 0;
+    for (uint8_t i = 0; i < 6; ++i) {
+      if (payload[i] != _prev[i]) mask |= (uint8_t)(1u << i);
+    }
+  }
+  *p = (uint8_t)((PS2_CAPTURE_REC_FRAME << 6) | mask);
+  p = putDelta(p + 1, us);
+  for (uint8_t i = 0; i < 6; ++i) {
+    if (mask & (1u << i)) *p++ = payload[i];
+  }
+  memcpy(_prev, payload, 6);
+  _havePrev = true;
+  _pos = (uint16_t)(p - cur());
+}
+
+void PS2Capture::recordEvent(uint8_t event, uint32_t us) {
+  uint8_t* p = reserve(0, us);
+  if (!p) return;
+  *p = (uint8_t)((PS2_CAPTURE_REC_EVENT << 6) | (event & 0x3F));
+  p = putDelta(p + 1, us);
+  _pos = (uint16_t)(p - cur());
+}
+
+const uint8_t* PS2Capture::block(uint16_t i) const {
+  if (i >= _count) return nullptr;
+  uint16_t slot = (uint16_t)((_head + _slots - _count + i) % _slots);
+  return _mem + (uint32_t)slot * kBlockSize;
+}
+
+PS2CaptureReader::PS2CaptureReader(const uint8_t* data, size_t len)
+  : _data(data), _cap(nullptr), _blocks((uint32_t)(len / PS2Capture::kBlockSize))
+{
+  rewind();
+}
+
+PS2CaptureReader::PS2CaptureReader(const PS2Capture& cap)
+  : _data(nullptr), _cap(&cap), _blocks(0)
+{
+  rewind();
+}
+
+void PS2CaptureReader::rewind() {
+  _block = 0;
+  _pos = 0;
+  _seq = 0;
+  _haveSeq = false;
+  _timeUs = 0;
+  memset(_prev, 0, sizeof(_prev));
+  _lost = 0;
+  _bad = 0;
+}
+
+const uint8_t* PS2CaptureReader::blockAt(uint32_t i) const {
+  if (_cap) return _cap->block((uint16_t)i);
+  return (i < _blocks) ? _data + i * PS2Capture::kBlockSize : nullptr;
+}
+
+// 进入下一个有效块：检查块头，按块序号统计缺失的块，时间从块基准时间重新开始
+bool PS2CaptureReader::enterBlock() {
+  for (;;) {
+    const uint8_t* b = blockAt(_block);
+    if (!b) return false;
+    if (b[0] != kCaptureMagic || b[1] != kCaptureVersion) {
+      ++_bad;
+      ++_block;
+      continue;
+    }
+    uint16_t seq = (uint16_t)(b[2] | ((uint16_t)b[3] << 8));
+    if (_haveSeq && seq != (uint16_t)(_seq + 1)) _lost += (uint16_t)(seq - _seq - 1);
+    _seq = seq;
+    _haveSeq = true;
+    _timeUs = (uint32_t)b[4] | ((uint32_t)b[5] << 8) | ((uint32_t)b[6] << 16) | ((uint32_t)b[7] << 24);
+    _pos = PS2Capture::kHeaderSize;
+    return true;
+  }
+}
+
+bool PS2CaptureReader::next(PS2CaptureRecord& r) {
+  const uint16_t size = PS2Capture::kBlockSize;
+  for (;;) {
+    if (_pos == 0 && !enterBlock()) return false;
+    const uint8_t* b = blockAt(_block);
+    if (_pos >= size || b[_pos] == 0) {
+      ++_block;
+      _pos = 0;
+      continue;
+    }
+    uint16_t p = _pos;
+    uint8_t tag = b[p++];
+    uint32_t d = 0;
+    uint8_t shift = 0;
+    while (p < size && shift < 35) {
+      uint8_t v = b[p++];
+      d |= (uint32_t)(v & 0x7F) << shift;
+      shift += 7;
+      if (!(v & 0x80)) break;
+    }
+    r.type = (uint8_t)(tag >> 6);
+    r.event = 0;
+    r.len = 0;
+    uint8_t arg = tag & 0x3F;
+    if (r.type == PS2_CAPTURE_REC_RAW) {
+      if (p + arg > size) {   // 损坏的块：跳过剩余部分
+        ++_bad;
+        _pos = size;
+        continue;
+      }
+      memcpy(r.data, b + p, arg);
+      r.len = arg;
+      p += arg;
+    } else if (r.type == PS2_CAPTURE_REC_FRAME) {
+      for (uint8_t i = 0; i < 6; ++i) {
+        if (!(arg & (1u << i))) continue;
+        if (p >= size) break;
+        _prev[i] = b[p++];
+      }
+      memcpy(r.data, _prev, 6);
+      r.len = 6;
+    } else {
+      r.event = arg;
+    }
+    _pos = p;
+    _timeUs += d;
+    r.timeUs = _timeUs;
+    return true;
+  }
+}
+
+PS2ReplaySerial::PS2ReplaySerial(const PS2CaptureReader& reader, uint16_t speed)
+  : _reader(reader), _outLen(0), _outPos(0), _haveRec(false), _started(false), _speed(speed),
+    _startUs(0), _firstUs(0), _lastUs(0)
+{
+}
+
+void PS2ReplaySerial::begin(unsigned long baud) {
+  (void)baud;
+  _reader.rewind();
+  _haveRec = _reader.next(_rec);
+  _firstUs = _lastUs = _rec.timeUs;
+  _startUs = micros();
+  _outLen = _outPos = 0;
+  _started = true;
+}
+
+bool PS2ReplaySerial::due() {
+  if (!_haveRec) return false;
+  if (_speed == 0) return true;
+  return (uint32_t)(micros() - _startUs) >= (_rec.timeUs - _firstUs) / _speed;
+}
+
+uint32_t PS2ReplaySerial::nextRecordUs() const {
+  if (!_haveRec || _speed == 0) return micros();
+  return _startUs + (_rec.timeUs - _firstUs) / _speed;
+}
+
+// 输出缓冲读完后，把已到时间的下一条记录还原为串口字节
+void PS2ReplaySerial::load() {
+  while (_outPos >= _outLen && due()) {
+    _outPos = 0;
+    _outLen = 0;
+    if (_rec.type == PS2_CAPTURE_REC_RAW) {
+      memcpy(_out, _rec.data, _rec.len);
+      _outLen = _rec.len;
+    } else if (_rec.type == PS2_CAPTURE_REC_FRAME) {
+      _out[0] = 0x0D;
+      memcpy(_out + 1, _rec.data, 6);
+      _out[7] = 0x0A;
+      _outLen = 8;
+    } else if (_rec.event == PS2_CAPTURE_EVT_DISCONNECT) {
+      _out[0] = 0xAB;
+      _outLen = 1;
+    } else if (_rec.event == PS2_CAPTURE_EVT_BAD_FRAME) {
+      // 还原为一个长帧（第 7 个字节不是 0x0A，负载中也没有帧头），解码器按长帧计数
+      _out[0] = 0x0D;
+      memset(_out + 1, 0, 7);
+      _outLen = 8;
+    } else if (_rec.event == PS2_CAPTURE_EVT_SHORT_FRAME) {
+      // 还原为 5 字节负载 + 0x0A 的短帧：下一条记录的帧头成为第 7 个字节，解码器按短帧计数并从该帧头重新同步，
+      // 与录制时一样接着解出下一帧（下一条记录不是帧或坏帧时按长帧计数）
+      _out[0] = 0x0D;
+      memset(_out + 1, 0, 5);
+      _out[6] = 0x0A;
+      _outLen = 7;
+    }
+    _lastUs = _rec.timeUs;
+    _haveRec = _reader.next(_rec);
+  }
+}
+
+int PS2ReplaySerial::available() {
+  if (!_started) return 0;
+  load();
+  return _outLen - _outPos;
+}
+
+int PS2ReplaySerial::read() {
+  if (!_started) return -1;
+  load();
+  if (_outPos >= _outLen) return -1;
+  return _out[_outPos++];
+}
+
+size_t PS2ReplaySerial::readBytes(uint8_t* buf, size_t len) {
+  if (!_started) return 0;
+  size_t n = 0;
+  while (n < len) {
+    load();
+    if (_outPos >= _outLen) break;
+    size_t k = (size_t)(_outLen - _outPos);
+    if (k > len - n) k = len - n;
+    memcpy(buf + n, _out + _outPos, k);
+    _outPos += (uint8_t)k;
+    n += k;
+  }
+  return n;
+}
+
+bool PS2ReplaySerial::finished() {
+  return _started && !_haveRec && _outPos >= _outLen;
+}
@@ -0,0 +1,131 @@
+// YFPS2UARTCapture.h
+// 接收数据的录制与回放，用于复现现场问题（漏按、摇杆卡住等）。
+//   - PS2Capture：录制器。由 YFPS2UART::setCapture() 挂到解码路径上，录制原始字节流（PS2_CAPTURE_RAW）
+//     或解出的帧（PS2_CAPTURE_FRAMES）。数据写入调用者提供的 RAM（定长块组成的环，满了覆盖最旧的块），
+//     每写满一块还可交给 sink 回调（主机上写文件、MCU 上写 SD 卡或串口导出）。不分配堆内存。
+//   - PS2CaptureReader：按时间顺序解出录制记录，数据可以是 PS2Capture 的环，也可以是读入内存的文件内容。
+//   - PS2ReplaySerial（YFPS2UARTReplay.h）：SerialBase 实现，按原始时间（或 speed 倍速）把录制内容重新送给 YFPS2UART。
+//
+// 格式（小端）：由 YFPS2UART_CAPTURE_BLOCK 字节的定长块组成，每块可以单独解码。
+//   块头 8 字节：'P', 格式版本(1), 块序号(uint16), 块基准时间(uint32, micros())
+//   记录：标记字节 + 时间差（LEB128 变长整数，相对上一条记录或块基准时间，微秒）+ 数据
+//     标记 bit7..6 为类型，bit5..0 为参数：
+//       0 RAW：参数为字节数（1..63），后跟原始字节；标记 0x00 表示本块结束（其余为填充）
+//       1 FRAME：参数为与上一帧相比变化的负载字节掩码（bit i 对应负载第 i 字节），后跟变化的字节；
+//               每块的第一帧总是完整记录
+//       2 EVENT：参数为事件号（PS2_CAPTURE_EVT_*），无数据
+//   帧以 5~10ms 到达时，时间差占 2 字节，摇杆静止的帧只需约 3~5 字节（原始帧 8 字节）。
+//
+//   static uint8_t capBuf[16 * YFPS2UART_CAPTURE_BLOCK];
+//   PS2Capture cap(capBuf, sizeof(capBuf));
+//   ps2.setCapture(&cap, PS2_CAPTURE_FRAMES);
+//   ...                                   // 出现问题后
+//   ps2.setCapture(nullptr);
+//   cap.finish();                         // 结束未写满的块，之后用 block(i) 逐块导出
+#ifndef YFPS2UART_CAPTURE_H
+#define YFPS2UART_CAPTURE_H
+
+#include <Arduino.h>
+
+// 块大小（字节）
+#ifndef YFPS2UART_CAPTURE_BLOCK
+#define YFPS2UART_CAPTURE_BLOCK 64
+#endif
+
+// 录制内容（setCapture 的 mode）
+#define PS2_CAPTURE_RAW    1   // 从串口读入（或 feed() 输入）的原始字节
+#define PS2_CAPTURE_FRAMES 2   // 解出的好帧负载，以及断开/坏帧事件
+
+// 记录类型
+#define PS2_CAPTURE_REC_RAW   0
+#define PS2_CAPTURE_REC_FRAME 1
+#define PS2_CAPTURE_REC_EVENT 2
+
+// 事件号（帧模式录制）
+#define PS2_CAPTURE_EVT_DISCONNECT 1   // 帧外收到 0xAB（手柄断开）
+#define PS2_CAPTURE_EVT_BAD_FRAME  2   // 长帧/坏帧（第 7 个字节不是 0x0A，也不是短帧）
+#define PS2_CAPTURE_EVT_MARK       3   // 用户标记（PS2Capture::mark()）
+#define PS2_CAPTURE_EVT_SHORT_FRAME 4  // 短帧（帧结束符提前出现、紧跟着下一个帧头）
+
+// 解出的一条记录
+struct PS2CaptureRecord {
+    uint8_t type;        // PS2_CAPTURE_REC_*
+    uint8_t event;       // EVENT 记录的事件号
+    uint8_t len;         // data 中的有效字节数（FRAME 为 6，EVENT 为 0）
+    uint32_t timeUs;     // 录制时的 micros()
+    uint8_t data[63];    // RAW 的原始字节，或 FRAME 的完整负载
+};
+
+class PS2Capture {
+public:
+    static const uint16_t kBlockSize = YFPS2UART_CAPTURE_BLOCK;
+    static const uint8_t kHeaderSize = 8;
+
+    // storage 至少一个块；不足一个块时不录制
+    PS2Capture(uint8_t* storage, size_t bytes);
+
+    // 每写满（或 finish()）一块调用一次 fn(ctx, block, kBlockSize)
+    void setSink(void (*fn)(void* ctx, const uint8_t* block, uint16_t len), void* ctx);
+
+    void recordBytes(const uint8_t* data, size_t len, uint32_t us);
+    void recordFrame(const uint8_t payload[6], uint32_t us);
+    void recordEvent(uint8_t event, uint32_t us);
+    void mark() { recordEvent(PS2_CAPTURE_EVT_MARK, micros()); }
+
+    void finish();   // 结束正在写的块（之后的记录写入新块）
+    void clear();
+
+    // 已完成的块，按时间从旧到新；读取前先停止录制（setCapture(nullptr)）并调用 finish()
+    uint16_t blockCount() const { return _count; }
+    const uint8_t* block(uint16_t i) const;
+    uint32_t overwrittenBlocks() const { return _overwritten; }   // 环满被覆盖的块数
+    uint32_t recordCount() const { return _records; }
+
+private:
+    uint8_t* _mem;
+    uint16_t _slots;      // 环中的块数
+    uint16_t _head;       // 正在写的块
+    uint16_t _count;      // 已完成的块数
+    uint16_t _pos;        // 正在写的块中的写入位置（0 表示尚未开始）
+    uint16_t _seq;        // 下一块的序号
+    uint32_t _lastUs;     // 上一条记录的时间
+    uint32_t _overwritten;
+    uint32_t _records;
+    uint8_t _prev[6];     // 本块上一帧的负载
+    bool _havePrev;
+    void (*_sink)(void*, const uint8_t*, uint16_t);
+    void* _sinkCtx;
+
+    uint8_t* cur() { return _mem + (uint32_t)_head * kBlockSize; }
+    uint8_t* reserve(uint8_t bytes, uint32_t us);
+    uint8_t* putDelta(uint8_t* p, uint32_t us);
+};
+
+class PS2CaptureReader {
+public:
+    PS2CaptureReader(const uint8_t* data, size_t len);   // 连续存放的块（如读入的文件）
+    explicit PS2CaptureReader(const PS2Capture& cap);
+
+    bool next(PS2CaptureRecord& r);   // 按顺序取下一条记录，没有时返回 false
+    void rewind();
+    uint32_t lostBlocks() const { return _lost; }     // 块序号不连续（环被覆盖或文件缺块）的块数
+    uint32_t badBlocks() const { return _bad; }       // 块头无效而跳过的块数
+
+private:
+    const uint8_t* _data;
+    const PS2Capture* _cap;
+    uint32_t _blocks;
+    uint32_t _block;      // 当前块
+    uint16_t _pos;        // 当前块中的读取位置（0 表示尚未进入）
+    uint16_t _seq;
+    bool _haveSeq;
+    uint32_t _timeUs;
+    uint8_t _prev[6];
+    uint32_t _lost;
+    uint32_t _bad;
+
+    const uint8_t* blockAt(uint32_t i) const;
+    bool enterBlock();
+};
+
+#endif // YFPS2UART_CAPTURE_H
@@ -0,0 +1,110 @@
+// YFPS2UARTFilter.h
+// 摇杆低通滤波（整数定点），在 update() 应用摇杆值时每帧计算一次，Analog()/Stick() 读取滤波结果。
+//   - EMA：s += (x - s) / 2^k。4 个轴的 Q8 状态以 16 位通道打包在两个 32 位字中（RX,RY | LX,LY），
+//     一次移位/加减同时处理两个轴（SWAR）：s - (s >> k) 在通道内不会借位，x << (8 - k) 也不会进位到相邻通道；
+//   - 自适应（One-Euro 风格）：按每轴的移动速度调整系数，静止时与 EMA 同样平滑，快速推杆时接近直通以减小延迟。
+//     各轴系数不同，因此逐轴计算（仍为整数运算）。
+// 延迟与平滑的取舍：EMA 阶跃响应到 90% 约需 2.3 * 2^k 帧；抖动幅度约按 1 / 2^(k/2) 缩小。
+#ifndef YFPS2UART_FILTER_H
+#define YFPS2UART_FILTER_H
+
+#include <Arduino.h>
+
+// 滤波模式
+#define PS2_FILTER_OFF      0
+#define PS2_FILTER_EMA      1
+#define PS2_FILTER_ADAPTIVE 2
+
+// 两个 16 位通道中每个通道右移 k 位后保留的位
+inline uint32_t ps2LaneMask16(uint8_t k) {
+    uint32_t m = 0xFFFFu >> k;
+    return m | (m << 16);
+}
+
+// 两个 Q8 通道的 EMA 一步：s 为打包状态，x 为打包的输入（每通道 0..255，位于通道低 8 位）
+inline uint32_t ps2EmaLanes(uint32_t s, uint32_t x, uint8_t k) {
+    return s - ((s >> k) & ps2LaneMask16(k)) + (x << (8 - k));
+}
+
+// 打包状态取整为两个 8 位值（仍位于各通道低 8 位）
+inline uint32_t ps2LanesToBytes(uint32_t s) {
+    return ((s + 0x00800080u) >> 8) & 0x00FF00FFu;
+}
+
+class PS2StickFilter {
+public:
+    PS2StickFilter() : _mode(PS2_FILTER_OFF), _k(2), _beta(32), _primed(false) {}
+
+    /*
+     * mode: PS2_FILTER_OFF / PS2_FILTER_EMA / PS2_FILTER_ADAPTIVE
+     * k: 平滑强度 0..7（EMA 系数 1/2^k；自适应模式下为静止时的系数）
+     * beta: 自适应模式下每 1 计数/帧 的（平滑后）速度使系数增加 beta/256
+     */
+    void configure(uint8_t mode, uint8_t k, uint8_t beta) {
+        _mode = mode;
+        _k = (k > 7) ? 7 : k;
+        _beta = beta;
+        _primed = false;   // 下一帧直接以输入值为初值，不从 0 爬升
+    }
+    uint8_t mode() const { return _mode; }
+    void reset() { _primed = false; }   // 下一帧重新以输入值为初值（如链路丢失后摇杆已强制回中）
+
+    // 原地滤波一帧的 4 个轴（RX, RY, LX, LY）
+    void process(uint8_t v[4]) {
+        if (_mode == PS2_FILTER_OFF) return;
+        if (!_primed) {
+            prime(v);
+            return;
+        }
+        if (_mode == PS2_FILTER_EMA) {
+            _s[0] = ps2EmaLanes(_s[0], (uint32_t)v[0] | ((uint32_t)v[1] << 16), _k);
+            _s[1] = ps2EmaLanes(_s[1], (uint32_t)v[2] | ((uint32_t)v[3] << 16), _k);
+        } else {
+            adaptive(v);
+        }
+        uint32_t a = ps2LanesToBytes(_s[0]);
+        uint32_t b = ps2LanesToBytes(_s[1]);
+        v[0] = (uint8_t)a;
+        v[1] = (uint8_t)(a >> 16);
+        v[2] = (uint8_t)b;
+        v[3] = (uint8_t)(b >> 16);
+    }
+
+private:
+    uint32_t _s[2];       // Q8 状态：RX,RY | LX,LY
+    int16_t _vel[4];      // 每轴速度（Q4 计数/帧，低通后）
+    uint8_t _prev[4];     // 上一帧输入
+    uint8_t _mode;
+    uint8_t _k;
+    uint8_t _beta;
+    bool _primed;
+
+    void prime(const uint8_t v[4]) {
+        _s[0] = ((uint32_t)v[0] | ((uint32_t)v[1] << 16)) << 8;
+        _s[1] = ((uint32_t)v[2] | ((uint32_t)v[3] << 16)) << 8;
+        for (uint8_t i = 0; i < 4; ++i) {
+            _vel[i] = 0;
+            _prev[i] = v[i];
+        }
+        _primed = true;
+    }
+
+    void adaptive(const uint8_t v[4]) {
+        for (uint8_t i = 0; i < 4; ++i) {
+            // 有符号速度的平滑值：来回抖动相互抵消，持续推杆才会累积（One-Euro 的导数低通）
+            int16_t d = (int16_t)((int16_t)v[i] - (int16_t)_prev[i]);
+            _prev[i] = v[i];
+            _vel[i] = (int16_t)(_vel[i] + ((d * 16 - _vel[i]) / 4));
+            uint16_t speed = (uint16_t)((_vel[i] < 0) ? -_vel[i] : _vel[i]);
+            uint32_t alpha = (256u >> _k) + (((uint32_t)_beta * speed) >> 4);
+            if (alpha > 256) alpha = 256;
+            uint32_t& w = _s[i >> 1];
+            uint8_t shift = (uint8_t)((i & 1) * 16);
+            int32_t s = (int32_t)((w >> shift) & 0xFFFFu);
+            s += ((((int32_t)v[i] << 8) - s) * (int32_t)alpha) / 256;
+            w = (w & ~(0xFFFFUL << shift)) | ((uint32_t)s << shift);
+        }
+    }
+};
+
+#endif // YFPS2UART_FILTER_H
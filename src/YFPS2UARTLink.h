@@ -0,0 +1,249 @@
+// YFPS2UARTLink.h
+// 链路质量监测：在每次 update() 结束时根据解析计数计算滑动窗口内的好帧率、坏帧比例、帧间隙与 0xAB 断开时段，
+// 驱动 Connected / Degraded / Lost / Disconnected 状态机。
+// 只有完整好帧才算“收到数据”（hasRecentData() 按任意字节计时，噪声与 0xAB 也会刷新）。
+//
+// 状态转换（阈值成对设置，进入与退出之间留有回差，避免在临界值附近来回跳变）：
+//   任意状态 -> Disconnected：帧外收到 0xAB（模块报告手柄未连接）
+//   Connected/Degraded -> Lost：超过 lostMs 没有好帧；Disconnected 期间超过 lostMs 连 0xAB 也收不到时同样转为 Lost
+//   Lost/Disconnected -> Connected：连续 recoverFrames 个好帧（中间没有坏帧），滑动窗口从此重新开始
+//   Connected -> Degraded：窗口帧率低于 degradedFps，或坏帧比例高于 degradedBadPermille
+//   Degraded -> Connected：窗口帧率不低于 recoverFps，且坏帧比例不高于 recoverBadPermille
+// 窗口累计不足 windowMs / 2 时不评估帧率与坏帧比例。上电时为 Lost。
+// YFPS2UART_LINK_BUCKETS 为 0 时不保留滑动窗口：不进入 Degraded，frameRateHz / badPermille 恒为 0，
+// 其余状态转换与失效保护不变。
+#ifndef YFPS2UART_LINK_H
+#define YFPS2UART_LINK_H
+
+#include <Arduino.h>
+
+// 链路状态（数值越大越健康）
+#define PS2_LINK_DISCONNECTED 0
+#define PS2_LINK_LOST         1
+#define PS2_LINK_DEGRADED     2
+#define PS2_LINK_CONNECTED    3
+
+// 滑动窗口的分桶数，0 表示不保留窗口。Arduino IDE 不会把草图中的 #define 传给库，请通过编译参数修改默认值
+#ifndef YFPS2UART_LINK_BUCKETS
+#if defined(__AVR__)
+#define YFPS2UART_LINK_BUCKETS 0   // AVR 内存紧张，默认只监测间隙与断开
+#else
+#define YFPS2UART_LINK_BUCKETS 8
+#endif
+#endif
+
+struct PS2LinkConfig {
+    uint16_t windowMs;             // 滑动窗口长度
+    uint16_t degradedFps;          // 帧率低于该值进入 Degraded
+    uint16_t recoverFps;           // 帧率不低于该值才回到 Connected
+    uint16_t degradedBadPermille;  // 坏帧比例（千分比）高于该值进入 Degraded
+    uint16_t recoverBadPermille;   // 坏帧比例不高于该值才回到 Connected
+    uint16_t lostMs;               // 超过该时间没有好帧进入 Lost
+    uint8_t recoverFrames;         // 从 Lost/Disconnected 恢复需要的连续好帧数
+
+    PS2LinkConfig()
+        : windowMs(1000), degradedFps(20), recoverFps(30), degradedBadPermille(100), recoverBadPermille(25),
+          lostMs(200), recoverFrames(3) {}
+};
+
+struct PS2LinkStats {
+    uint8_t state;            // PS2_LINK_*
+    uint32_t stateSinceMs;    // 进入当前状态的时间
+    uint16_t frameRateHz;     // 窗口内好帧率
+    uint16_t badPermille;     // 窗口内坏帧比例（千分比）
+    uint32_t gapMs;           // 距最近一个好帧的时间
+    uint32_t maxGapMs;        // 最长的好帧间隔
+    uint32_t corruptFrames;   // 累计坏帧（短帧 + 长帧）
+    uint32_t resyncs;         // 累计重同步次数
+    uint32_t disconnects;     // 0xAB 断开次数
+    uint32_t disconnectedMs;  // 断开累计时长（不含当前正在进行的断开）
+    uint32_t transitions;     // 状态转换次数
+};
+
+// 链路状态变化回调，在 update()（后台任务模式下为后台任务）中调用
+typedef void (*PS2LinkHandler)(uint8_t from, uint8_t to, void* ctx);
+
+class PS2LinkMonitor {
+public:
+    PS2LinkMonitor() { reset(0); }
+
+    void configure(const PS2LinkConfig& cfg) { _cfg = cfg; }
+    const PS2LinkConfig& config() const { return _cfg; }
+
+    void reset(uint32_t now) {
+        memset(&_stats, 0, sizeof(_stats));
+        _stats.state = PS2_LINK_LOST;
+        _stats.stateSinceMs = now;
+        _lastGood = _lastBad = _lastResync = _lastRx = 0;
+        _lastGoodMs = _lastRxMs = now;
+        _haveGood = false;
+        _streak = 0;
+        _disconnectStartMs = now;
+#if YFPS2UART_LINK_BUCKETS > 0
+        restartWindow(now);
+#endif
+    }
+
+    // 解析计数被清零后调用，下一次 update() 不把清零当作计数变化
+    void rebase(uint32_t good, uint32_t bad, uint32_t resynced) {
+        _lastGood = good;
+        _lastBad = bad;
+        _lastResync = resynced;
+    }
+
+    uint8_t state() const { return _stats.state; }
+
+    // 统计信息；gapMs 按 now 计算
+    void stats(PS2LinkStats& out, uint32_t now) const {
+        out = _stats;
+        out.gapMs = _haveGood ? now - _lastGoodMs : now - _stats.stateSinceMs;
+#if YFPS2UART_LINK_BUCKETS > 0
+        uint32_t good, bad, span;
+        window(now, good, bad, span);
+        out.frameRateHz = span ? (uint16_t)(good * 1000UL / span) : 0;
+        out.badPermille = (good + bad) ? (uint16_t)(bad * 1000UL / (good + bad)) : 0;
+#endif
+    }
+
+    /*
+     * 每次 update() 调用一次。good/bad/resynced/rxBytes 为累计计数，disconnected 为解析器的 0xAB 忽略状态。
+     * 返回 true 表示状态发生了变化（from 为原状态）。
+     */
+    bool update(uint32_t now, uint32_t good, uint32_t bad, uint32_t resynced, uint32_t rxBytes, bool disconnected,
+                uint8_t& from) {
+        uint32_t dGood = good - _lastGood;
+        uint32_t dBad = bad - _lastBad;
+        _lastGood = good;
+        _lastBad = bad;
+        _stats.corruptFrames += dBad;
+        _stats.resyncs += resynced - _lastResync;
+        _lastResync = resynced;
+        if (rxBytes != _lastRx) {
+            _lastRx = rxBytes;
+            _lastRxMs = now;
+        }
+
+#if YFPS2UART_LINK_BUCKETS > 0
+        rotate(now);
+        _good[_bucket] = (uint16_t)(_good[_bucket] + dGood);
+        _bad[_bucket] = (uint16_t)(_bad[_bucket] + dBad);
+#endif
+
+        if (dBad) _streak = 0;
+        if (dGood) {
+            if (_haveGood && now - _lastGoodMs > _stats.maxGapMs) _stats.maxGapMs = now - _lastGoodMs;
+            _lastGoodMs = now;
+            _haveGood = true;
+            _streak = (_streak + dGood > 255) ? 255 : (uint8_t)(_streak + dGood);
+        }
+
+        uint8_t s = _stats.state;
+        uint8_t next = s;
+        if (disconnected) {
+            // 模块持续发送 0xAB 时为 Disconnected，连 0xAB 也收不到时为 Lost
+            next = (now - _lastRxMs >= _cfg.lostMs) ? PS2_LINK_LOST : PS2_LINK_DISCONNECTED;
+            _streak = 0;
+        } else if (s <= PS2_LINK_LOST) {
+            if (_streak >= _cfg.recoverFrames) {
+                next = PS2_LINK_CONNECTED;
+#if YFPS2UART_LINK_BUCKETS > 0
+                restartWindow(now);
+#endif
+            } else if (s == PS2_LINK_DISCONNECTED) {
+                // 解出好帧才会退出 0xAB 忽略状态；这里是好帧不够 recoverFrames 个的情况
+                next = (now - _lastGoodMs >= _cfg.lostMs) ? PS2_LINK_LOST : s;
+            }
+        } else if (now - _lastGoodMs >= _cfg.lostMs) {
+            next = PS2_LINK_LOST;
+            _streak = 0;
+        }
+#if YFPS2UART_LINK_BUCKETS > 0
+        else {
+            uint32_t wGood, wBad, span;
+            window(now, wGood, wBad, span);
+            if (span >= _cfg.windowMs / 2) {
+                uint32_t fps = wGood * 1000UL / span;
+                uint32_t badPm = (wGood + wBad) ? wBad * 1000UL / (wGood + wBad) : 0;
+                if (s == PS2_LINK_CONNECTED && (fps < _cfg.degradedFps || badPm > _cfg.degradedBadPermille)) {
+                    next = PS2_LINK_DEGRADED;
+                } else if (s == PS2_LINK_DEGRADED && fps >= _cfg.recoverFps && badPm <= _cfg.recoverBadPermille) {
+                    next = PS2_LINK_CONNECTED;
+                }
+            }
+        }
+#endif
+
+        if (next == s) return false;
+        if (s == PS2_LINK_DISCONNECTED) _stats.disconnectedMs += now - _disconnectStartMs;
+        if (next == PS2_LINK_DISCONNECTED) {
+            ++_stats.disconnects;
+            _disconnectStartMs = now;
+        }
+        from = s;
+        _stats.state = next;
+        _stats.stateSinceMs = now;
+        ++_stats.transitions;
+        return true;
+    }
+
+private:
+    PS2LinkConfig _cfg;
+    PS2LinkStats _stats;
+#if YFPS2UART_LINK_BUCKETS > 0
+    uint16_t _good[YFPS2UART_LINK_BUCKETS];   // 各桶的好帧数
+    uint16_t _bad[YFPS2UART_LINK_BUCKETS];    // 各桶的坏帧数
+    uint8_t _bucket;                          // 当前桶
+    uint32_t _bucketStartMs;                  // 当前桶的开始时间
+    uint32_t _windowStartMs;                  // 窗口（重新）开始的时间，窗口未满时按实际时长计算帧率
+#endif
+    uint32_t _lastGood, _lastBad, _lastResync, _lastRx;
+    uint32_t _lastGoodMs;
+    uint32_t _lastRxMs;
+    uint32_t _disconnectStartMs;
+    bool _haveGood;
+    uint8_t _streak;                          // 连续好帧数
+
+#if YFPS2UART_LINK_BUCKETS > 0
+    uint16_t bucketMs() const {
+        uint16_t b = _cfg.windowMs / YFPS2UART_LINK_BUCKETS;
+        return b ? b : 1;
+    }
+
+    void restartWindow(uint32_t now) {
+        memset(_good, 0, sizeof(_good));
+        memset(_bad, 0, sizeof(_bad));
+        _bucket = 0;
+        _bucketStartMs = now;
+        _windowStartMs = now;
+    }
+
+    // 按经过的时间推进分桶，跳过的桶清零
+    void rotate(uint32_t now) {
+        uint16_t b = bucketMs();
+        uint32_t elapsed = now - _bucketStartMs;
+        if (elapsed < b) return;
+        uint32_t steps = elapsed / b;
+        _bucketStartMs += steps * b;
+        if (steps > YFPS2UART_LINK_BUCKETS) steps = YFPS2UART_LINK_BUCKETS;
+        while (steps--) {
+            _bucket = (uint8_t)((_bucket + 1) % YFPS2UART_LINK_BUCKETS);
+            _good[_bucket] = 0;
+            _bad[_bucket] = 0;
+        }
+    }
+
+    // 窗口内的计数与时长（毫秒）
+    void window(uint32_t now, uint32_t& good, uint32_t& bad, uint32_t& span) const {
+        good = bad = 0;
+        for (uint8_t i = 0; i < YFPS2UART_LINK_BUCKETS; ++i) {
+            good += _good[i];
+            bad += _bad[i];
+        }
+        span = (uint32_t)(YFPS2UART_LINK_BUCKETS - 1) * bucketMs() + (now - _bucketStartMs);
+        uint32_t since = now - _windowStartMs;
+        if (since < span) span = since;
+    }
+#endif
+};
+
+#endif // YFPS2UART_LINK_H
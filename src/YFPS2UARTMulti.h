@@ -0,0 +1,204 @@
+// YFPS2UARTMulti.h
+// 多接收器管理：一个对象持有 N 个 YFPS2UART（例如 ESP32 上 Serial1/Serial2，或 AVR 上多个 SoftwareSerial），
+// 在每次 poll() 的字节/时间预算内轮流调用各接收器的 update()，并把各手柄的状态保存在一个连续数组中。
+//
+//   YFPS2UARTMulti<2> pads;
+//   pads.add(16, 17, &Serial2);    // 参数与 YFPS2UART 的构造函数相同
+//   pads.add(25, 26, &Serial1);
+//   pads.begin(9600);
+//   ...
+//   pads.poll(64, 500);            // 每次 loop() 最多处理 64 字节 / 500us
+//   const PS2State* s = pads.states();
+//
+// 内存：每个接收器在对象内存储一个完整的 YFPS2UART（连同它的串口适配器），另加状态与调度统计，约为 N 倍的单个对象。
+// 主机上按 AVR 的全部默认值测得 YFPS2UARTMulti<1> 为 976 字节、<2> 为 1936 字节（AVR 指针更短，实际略小，
+// 见 README“内存优化”），Arduino UNO（2KB SRAM）上再加上 Serial 与软串口的缓冲，N=2 放不下。
+// UNO 上请只用一个接收器（直接使用 YFPS2UART 即可），多个接收器请使用 Mega2560（8KB）或 ESP32。
+#ifndef YFPS2UART_MULTI_H
+#define YFPS2UART_MULTI_H
+
+#include "YFPS2UART.h"
+
+// 单个接收器的调度统计
+struct PS2ReceiverStats {
+    uint32_t frames;          // 解出的帧数
+    uint32_t bytes;           // 读入的字节数
+    uint16_t frameRateHz;     // 最近一个统计窗口（约 1 秒）的帧率
+    uint16_t maxGapMs;        // 相邻两次被调度之间的最长间隔（毫秒）
+    uint32_t starvedPolls;    // poll() 因预算用尽而没有轮到该接收器的次数
+    uint32_t listenSwitches;  // 被切换为 listen() 接收者的次数（仅软串口）
+};
+
+/*
+ * 调度规则：
+ *   - 从上次停下的接收器开始轮转，每个接收器每轮调用一次 update()（每次最多解出一帧），
+ *     因此积压多的接收器不会挤占其他接收器；预算用尽时记下位置，下次 poll() 从未轮到的接收器继续；
+ *   - 连续一整轮都没有读到字节也没有解出帧时提前返回；
+ *   - 需要 listen() 的串口（SoftwareSerial）同一时刻只有一个在接收：当前接收者解出 setListenFrames() 帧
+ *     且解析器位于帧边界后切换到下一个软串口接收器；超过 setListenTimeoutMs() 仍未解出足够的帧（手柄断开）也强制切换。
+ */
+template <uint8_t N>
+class YFPS2UARTMulti {
+public:
+    static_assert(N > 0 && N <= 32, "YFPS2UARTMulti supports 1..32 receivers");
+
+    YFPS2UARTMulti()
+        : _count(0), _next(0), _listener(kNone), _listenFrames(1), _listenTimeoutMs(40),
+          _listenSinceMs(0), _listenSeq(0), _windowStartMs(0) {
+        memset(_states, 0, sizeof(_states));
+        memset(_stats, 0, sizeof(_stats));
+        memset(_lastServiceMs, 0, sizeof(_lastServiceMs));
+        memset(_windowFrames, 0, sizeof(_windowFrames));
+    }
+
+    ~YFPS2UARTMulti() {
+        while (_count) {
+            _slots[--_count].ps2.~YFPS2UART();
+        }
+    }
+
+    YFPS2UARTMulti(const YFPS2UARTMulti&) = delete;
+    YFPS2UARTMulti& operator=(const YFPS2UARTMulti&) = delete;
+
+    // 在对象内部存储中构造一个接收器，参数与 YFPS2UART 的构造函数相同；已满时返回 nullptr
+    template <class... Args>
+    YFPS2UART* add(Args&&... args) {
+        if (_count >= N) return nullptr;
+        YFPS2UART* r = new (&_slots[_count].ps2) YFPS2UART(static_cast<Args&&>(args)...);
+        ++_count;
+        return r;
+    }
+
+    // 所有接收器以同一波特率 begin()，然后让第一个软串口接收器开始 listen()
+    void begin(unsigned long baud = 9600) {
+        for (uint8_t i = 0; i < _count; ++i) {
+            _slots[i].ps2.begin(baud);
+        }
+        _listener = kNone;
+        switchListener(millis());
+    }
+
+    uint8_t size() const { return _count; }
+    YFPS2UART& operator[](uint8_t i) { return _slots[i].ps2; }
+    const YFPS2UART& operator[](uint8_t i) const { return _slots[i].ps2; }
+
+    // 各手柄状态的连续数组（下标与 add() 顺序一致），poll() 中接收器解出新帧后刷新
+    const PS2State* states() const { return _states; }
+    const PS2State& state(uint8_t i) const { return _states[i]; }
+
+    void setListenFrames(uint8_t frames) { _listenFrames = frames ? frames : 1; }
+    void setListenTimeoutMs(uint16_t ms) { _listenTimeoutMs = ms; }
+    uint8_t listener() const { return _listener; }   // 当前 listen() 的接收器，kNone 表示没有软串口接收器
+
+    /*
+     * 在预算内轮流服务各接收器。
+     * 参数: maxBytes - 本次最多读取的字节数（至少服务一个接收器）；maxUs - 时间预算（微秒，0 表示不限）
+     * 返回值: 本次解出的帧数
+     */
+    uint16_t poll(uint16_t maxBytes = 0xFFFF, uint32_t maxUs = 0) {
+        if (_count == 0) return 0;
+        uint32_t t0 = maxUs ? micros() : 0;
+        uint32_t now = millis();
+        uint32_t bytes = 0;
+        uint16_t frames = 0;
+        uint32_t serviced = 0;
+        uint8_t idle = 0;
+        uint8_t i = _next;
+        while (idle < _count) {
+            if (serviced && (bytes >= maxBytes || (maxUs && micros() - t0 >= maxUs))) break;
+            YFPS2UART& r = _slots[i].ps2;
+            uint32_t b0 = r.getRxByteCount();
+            uint32_t seq0 = _states[i].seq;
+            r.update();
+            uint32_t db = r.getRxByteCount() - b0;
+            r.getState(_states[i]);
+            uint32_t df = _states[i].seq - seq0;
+
+            PS2ReceiverStats& st = _stats[i];
+            st.bytes += db;
+            st.frames += df;
+            if (_lastServiceMs[i] != 0 && !(serviced & (1UL << i))) {
+                uint32_t gap = now - _lastServiceMs[i];
+                if (gap > st.maxGapMs) st.maxGapMs = (gap > 0xFFFF) ? 0xFFFF : (uint16_t)gap;
+            }
+            _lastServiceMs[i] = now ? now : 1;
+            serviced |= 1UL << i;
+
+            if (i == _listener) {
+                bool quota = _states[i].seq - _listenSeq >= _listenFrames && r.atFrameBoundary();
+                if (quota || now - _listenSinceMs >= _listenTimeoutMs) switchListener(now);
+            }
+
+            bytes += db;
+            frames += (uint16_t)df;
+            idle = (db || df) ? 0 : (uint8_t)(idle + 1);
+            i = (uint8_t)((i + 1 == _count) ? 0 : i + 1);
+        }
+        _next = i;
+
+        for (uint8_t k = 0; k < _count; ++k) {
+            if (!(serviced & (1UL << k))) ++_stats[k].starvedPolls;
+        }
+        uint32_t window = now - _windowStartMs;
+        if (window >= 1000) {
+            for (uint8_t k = 0; k < _count; ++k) {
+                uint32_t hz = (_stats[k].frames - _windowFrames[k]) * 1000UL / window;
+                _stats[k].frameRateHz = (hz > 0xFFFF) ? 0xFFFF : (uint16_t)hz;
+                _windowFrames[k] = _stats[k].frames;
+            }
+            _windowStartMs = now;
+        }
+        return frames;
+    }
+
+    void getStats(uint8_t i, PS2ReceiverStats& out) const { out = _stats[i]; }
+
+    void resetStats() {
+        memset(_stats, 0, sizeof(_stats));
+        memset(_windowFrames, 0, sizeof(_windowFrames));
+        memset(_lastServiceMs, 0, sizeof(_lastServiceMs));
+        _windowStartMs = millis();
+    }
+
+    static const uint8_t kNone = 0xFF;
+
+private:
+    // 对象内存储：接收器由 add() 定位构造、析构函数逆序销毁
+    union Slot {
+        YFPS2UART ps2;
+        Slot() {}
+        ~Slot() {}
+    } _slots[N];
+    uint8_t _count;
+    uint8_t _next;              // 下次 poll() 从这个接收器开始
+    uint8_t _listener;          // 当前 listen() 的软串口接收器
+    uint8_t _listenFrames;      // 每次 listen() 至少接收的帧数
+    uint16_t _listenTimeoutMs;  // 单个接收器最长的 listen() 时间
+    uint32_t _listenSinceMs;
+    uint32_t _listenSeq;        // 开始 listen() 时该接收器的帧序号
+    uint32_t _windowStartMs;    // 帧率统计窗口起点
+
+    PS2State _states[N];
+    PS2ReceiverStats _stats[N];
+    uint32_t _lastServiceMs[N];
+    uint32_t _windowFrames[N];
+
+    // 切换到下一个需要 listen() 的接收器（只有一个时保持不变）
+    void switchListener(uint32_t now) {
+        uint8_t start = (_listener == kNone) ? (uint8_t)(_count - 1) : _listener;
+        for (uint8_t k = 1; k <= _count; ++k) {
+            uint8_t j = (uint8_t)((start + k) % _count);
+            if (!_slots[j].ps2.needsListen()) continue;
+            if (j != _listener) {
+                _slots[j].ps2.listen();
+                ++_stats[j].listenSwitches;
+                _listener = j;
+            }
+            _listenSinceMs = now;
+            _listenSeq = _states[j].seq;
+            return;
+        }
+    }
+};
+
+#endif // YFPS2UART_MULTI_H
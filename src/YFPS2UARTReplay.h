@@ -0,0 +1,51 @@
+// YFPS2UARTReplay.h
+// 录制内容的回放（录制格式见 YFPS2UARTCapture.h）：PS2ReplaySerial 作为 YFPS2UART 的串口，
+// 按录制时的时间间隔（speed 倍速，0 表示不等待）重新送出数据，用于在主机或另一块板子上复现现场问题。
+//
+//   PS2CaptureReader reader(fileData, fileLen);
+//   PS2ReplaySerial replay(reader, 10);   // 10 倍速
+//   YFPS2UART ps2(&replay);
+//   ps2.begin(9600);
+//   while (!replay.finished()) ps2.update();
+#ifndef YFPS2UART_REPLAY_H
+#define YFPS2UART_REPLAY_H
+
+#include "YFPS2UART.h"
+
+// 回放：begin() 时开始计时，记录在 (录制时间 - 第一条记录时间) / speed 之后变为可读；
+// FRAME 记录还原为 0x0D + 负载 + 0x0A，断开事件还原为 0xAB；写入的数据（AT 指令、震动）被丢弃
+class PS2ReplaySerial : public SerialBase {
+public:
+    PS2ReplaySerial(const PS2CaptureReader& reader, uint16_t speed = 1);
+
+    void begin(unsigned long baud) override;
+    int available() override;
+    int read() override;
+    size_t readBytes(uint8_t* buf, size_t len) override;
+    void write(uint8_t data) override { (void)data; }
+    void print(const char* str) override { (void)str; }
+    void flush() override {}
+
+    void setSpeed(uint16_t speed) { _speed = speed; }
+    bool finished();                     // 所有记录都已读出
+    uint32_t nextRecordUs() const;       // 下一条记录按回放时钟可读的 micros()（用于主机端跳过空闲时间）
+    uint32_t lastRecordUs() const { return _lastUs; }   // 最近送出的记录的录制时间
+
+private:
+    PS2CaptureReader _reader;
+    PS2CaptureRecord _rec;
+    uint8_t _out[65];
+    uint8_t _outLen;
+    uint8_t _outPos;
+    bool _haveRec;
+    bool _started;
+    uint16_t _speed;
+    uint32_t _startUs;
+    uint32_t _firstUs;
+    uint32_t _lastUs;
+
+    bool due();
+    void load();
+};
+
+#endif // YFPS2UART_REPLAY_H
@@ -0,0 +1,65 @@
+// YFPS2UARTRing.h
+// 单生产者/单消费者（SPSC）无锁环形队列。
+// 帧队列：生产者在串口接收回调或中断中写入解析好的帧，消费者在 update() 中取出。
+// 事件队列：生产者为按键处理（update() 或后台任务），消费者为 pollEvent()。
+// 读写索引均为单字节，使用 GCC __atomic 内建函数保证可见性与顺序（AVR 上退化为普通读写 + 编译器屏障）。
+#ifndef YFPS2UART_RING_H
+#define YFPS2UART_RING_H
+
+#include <Arduino.h>
+
+// 一帧解码后的负载：buttonsHigh, buttonsLow, LY, LX, RY, RX
+struct PS2Frame {
+    uint8_t payload[6];
+    uint32_t timeMs;    // 帧结束符到达时的时间（毫秒）
+    uint32_t timeUs;    // 同上（微秒），用于时序统计
+};
+
+// T 为可平凡拷贝的结构体，N 必须是 2 的幂且不超过 128
+template <class T, uint8_t N>
+class PS2SpscRing {
+public:
+    PS2SpscRing() : _head(0), _tail(0), _drops(0) {}
+
+    // 生产者：写入一项；队列已满返回 false 并计入丢弃
+    bool push(const T& f) {
+        uint8_t h = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        uint8_t t = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        if ((uint8_t)(h - t) >= N) {
+            ++_drops;
+            return false;
+        }
+        _slots[h & (N - 1)] = f;
+        __atomic_store_n(&_head, (uint8_t)(h + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // 消费者：取出最早的一项；队列为空返回 false
+    bool pop(T& f) {
+        uint8_t t = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        uint8_t h = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        if (h == t) return false;
+        f = _slots[t & (N - 1)];
+        __atomic_store_n(&_tail, (uint8_t)(t + 1), __ATOMIC_RELEASE);
+        return true;
+    }
+
+    uint8_t size() const {
+        return (uint8_t)(__atomic_load_n(&_head, __ATOMIC_ACQUIRE) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE));
+    }
+    uint16_t drops() const { return _drops; }   // 统计值，允许读到稍旧的值
+    static uint8_t capacity() { return N; }
+
+private:
+    static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "PS2SpscRing size must be a power of two <= 128");
+
+    T _slots[N];
+    uint8_t _head;     // 仅生产者写
+    uint8_t _tail;     // 仅消费者写
+    uint16_t _drops;   // 仅生产者写
+};
+
+template <uint8_t N>
+using PS2FrameRing = PS2SpscRing<PS2Frame, N>;
+
+#endif // YFPS2UART_RING_H
@@ -0,0 +1,59 @@
+// YFPS2UARTSeqlock.h
+// 顺序锁（seqlock）：单写者发布、多读者无锁读取一个小结构体的一致快照。
+// 写者从不等待读者；读者在写入进行中或读到一半被覆盖时重试，保证拿到的是未撕裂的完整副本。
+// 数据按 32 位字以 relaxed 原子操作拷贝，避免并发读写成为数据竞争。
+#ifndef YFPS2UART_SEQLOCK_H
+#define YFPS2UART_SEQLOCK_H
+
+#include <Arduino.h>
+
+template <class T>
+class PS2Seqlock {
+public:
+    PS2Seqlock() : _seq(0) {
+        memset(_words, 0, sizeof(_words));
+    }
+
+    // 写者（唯一）：发布新值
+    void write(const T& value) {
+        uint32_t s = __atomic_load_n(&_seq, __ATOMIC_RELAXED);
+        __atomic_store_n(&_seq, s + 1, __ATOMIC_RELAXED);   // 奇数：写入进行中
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        uint32_t tmp[kWords];
+        memcpy(tmp, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) {
+            __atomic_store_n(&_words[i], tmp[i], __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&_seq, s + 2, __ATOMIC_RELEASE);   // 偶数：写入完成
+    }
+
+    // 读者：尝试读取一次，读到一致快照返回 true
+    bool tryRead(T& out) const {
+        uint32_t s1 = __atomic_load_n(&_seq, __ATOMIC_ACQUIRE);
+        if (s1 & 1) return false;
+        uint32_t tmp[kWords];
+        for (size_t i = 0; i < kWords; ++i) {
+            tmp[i] = __atomic_load_n(&_words[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&_seq, __ATOMIC_RELAXED) != s1) return false;
+        memcpy(&out, tmp, sizeof(T));
+        return true;
+    }
+
+    // 读者：重试直到读到一致快照（写者每次只持有几十个周期，重试次数很少）
+    void read(T& out) const {
+        while (!tryRead(out)) {
+        }
+    }
+
+    // 已发布的次数
+    uint32_t version() const { return __atomic_load_n(&_seq, __ATOMIC_ACQUIRE) >> 1; }
+
+private:
+    static const size_t kWords = (sizeof(T) + 3) / 4;
+    uint32_t _seq;
+    uint32_t _words[kWords];
+};
+
+#endif // YFPS2UART_SEQLOCK_H
@@ -0,0 +1,81 @@
+// YFPS2UARTStats.h
+// 帧时序统计：固定桶（按 2 的幂分桶）的微秒直方图，提供 min/max/p50/p99。
+// 编译开关 YFPS2UART_STATS 为 0 时，YFPS2UART 中的计时代码与统计成员全部移除。
+// Arduino IDE 不会把草图中的 #define 传给库，请通过编译参数（-DYFPS2UART_STATS=0/1）修改默认值。
+#ifndef YFPS2UART_STATS_H
+#define YFPS2UART_STATS_H
+
+#include <Arduino.h>
+
+#ifndef YFPS2UART_STATS
+#if defined(__AVR__)
+#define YFPS2UART_STATS 0   // AVR 内存紧张，默认关闭
+#else
+#define YFPS2UART_STATS 1
+#endif
+#endif
+
+#if YFPS2UART_STATS
+
+// 第 k 个桶统计 [2^(k-1), 2^k) 微秒，第 0 个桶为 0 微秒，最后一个桶收纳所有更大的值
+struct PS2Histogram {
+    static const uint8_t kBuckets = 24;
+
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t buckets[kBuckets];
+
+    void reset() {
+        memset(this, 0, sizeof(*this));
+        minUs = 0xFFFFFFFFUL;
+    }
+
+    void add(uint32_t us) {
+        uint8_t k = us ? (uint8_t)(64 - __builtin_clzll((unsigned long long)us)) : 0;   // 二进制位数
+        if (k >= kBuckets) k = kBuckets - 1;
+        ++buckets[k];
+        ++count;
+        if (us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+    }
+
+    // 百分位（0-100），返回所在桶的上界并限制在 [min, max] 内；无样本时返回 0
+    uint32_t percentile(uint8_t p) const {
+        if (count == 0) return 0;
+        uint32_t target = (uint32_t)(((uint64_t)count * p + 99) / 100);
+        if (target == 0) target = 1;
+        uint32_t seen = 0;
+        for (uint8_t k = 0; k < kBuckets; ++k) {
+            seen += buckets[k];
+            if (seen >= target) {
+                uint32_t upper = (k == 0) ? 0 : ((1UL << k) - 1);
+                if (upper > maxUs || k == kBuckets - 1) upper = maxUs;
+                if (upper < minUs) upper = minUs;
+                return upper;
+            }
+        }
+        return maxUs;
+    }
+
+    uint32_t p50() const { return percentile(50); }
+    uint32_t p99() const { return percentile(99); }
+};
+
+struct PS2Stats {
+    uint32_t frames;              // 统计期间处理的帧数
+    PS2Histogram frameInterval;   // 相邻两帧的到达间隔
+    PS2Histogram latency;         // 帧从串口读入（解析完成）到 update() 返回的延迟（只统计交给应用的最新帧）
+    PS2Histogram updateTime;      // 单次 update() 的耗时
+
+    void reset() {
+        frames = 0;
+        frameInterval.reset();
+        latency.reset();
+        updateTime.reset();
+    }
+};
+
+#endif // YFPS2UART_STATS
+
+#endif // YFPS2UART_STATS_H
@@ -0,0 +1,177 @@
+#include "YFPS2UART.h"
+
+void ps2FillExpoCurve(PS2Curve& curve, uint8_t k) {
+  for (uint16_t x = 0; x < 256; ++x) {
+    curve.lut[x] = ps2ExpoPoint(x, k);
+  }
+}
+
+// 标称中心：X 轴 128，Y 轴 127（与 YFPS2UARTCore 构造时的摇杆初值一致）
+PS2StickConditioner::PS2StickConditioner()
+  : _lutFlash(0), _radial(0), _invert(0), _autoCenter(false), _window(12)
+{
+  for (uint8_t i = 0; i < 4; ++i) {
+    _center[i] = (i & 1) ? 127 : 128;
+    _centerQ8[i] = (uint16_t)_center[i] << 8;
+    _dz[i] = 0;
+    _dzScale[i] = 256;
+    _lut[i] = nullptr;
+    updateScale(i);
+  }
+}
+
+void PS2StickConditioner::updateScale(uint8_t i) {
+  uint8_t neg = _center[i] ? _center[i] : 1;
+  uint8_t pos = (uint8_t)(255 - _center[i]);
+  if (pos == 0) pos = 1;
+  _scaleNeg[i] = (uint16_t)(((255u << 8) + neg / 2) / neg);
+  _scalePos[i] = (uint16_t)(((255u << 8) + pos / 2) / pos);
+}
+
+void PS2StickConditioner::setDeadzone(uint8_t dz, uint8_t mode, uint8_t axes) {
+  uint16_t n = (uint16_t)dz * 2;   // 原始计数（半程约 127）换算为归一化幅值（半程 255）
+  if (n > 254) n = 254;
+  for (uint8_t i = 0; i < 4; ++i) {
+    if (!(axes & (1u << i))) continue;
+    _dz[i] = (uint8_t)n;
+    _dzScale[i] = (uint16_t)(((255u << 8) + (255 - n) / 2) / (255 - n));
+  }
+  for (uint8_t s = 0; s < 2; ++s) {
+    uint8_t pair = (uint8_t)(3u << (s * 2));
+    if ((axes & pair) != pair) continue;
+    if (mode == PS2_DEADZONE_RADIAL) {
+      _radial |= (uint8_t)(1u << s);
+    } else {
+      _radial &= (uint8_t)~(1u << s);
+    }
+  }
+}
+
+void PS2StickConditioner::setCurve(const PS2Curve* curve, uint8_t axes, bool inProgmem) {
+  for (uint8_t i = 0; i < 4; ++i) {
+    if (!(axes & (1u << i))) continue;
+    _lut[i] = curve ? curve->lut : nullptr;
+    if (curve && inProgmem) {
+      _lutFlash |= (uint8_t)(1u << i);
+    } else {
+      _lutFlash &= (uint8_t)~(1u << i);
+    }
+  }
+}
+
+void PS2StickConditioner::setInvert(uint8_t axes) {
+  _invert = axes & PS2_AXES_ALL;
+}
+
+void PS2StickConditioner::setAutoCenter(bool on, uint8_t window) {
+  _autoCenter = on;
+  _window = window;
+}
+
+void PS2StickConditioner::setCenter(uint8_t i, uint8_t center) {
+  _center[i] = center;
+  _centerQ8[i] = (uint16_t)center << 8;
+  updateScale(i);
+}
+
+// 死区外的幅值重新拉伸到 0..255
+uint16_t PS2StickConditioner::removeDeadzone(uint8_t i, uint16_t mag) const {
+  if (mag <= _dz[i]) return 0;
+  uint16_t m = (uint16_t)(((uint32_t)(mag - _dz[i]) * _dzScale[i] + 128) >> 8);
+  return (m > 255) ? 255 : m;
+}
+
+// 幅值经响应曲线映射为输出，恢复符号
+int8_t PS2StickConditioner::shape(uint8_t i, int16_t v) const {
+  uint8_t mag = (uint8_t)((v < 0) ? -v : v);
+  uint8_t out;
+  if (_lut[i] == nullptr) {
+    out = (uint8_t)(((uint16_t)mag * 127 + 128) >> 8);
+#if defined(__AVR__)
+  } else if (_lutFlash & (1u << i)) {
+    out = pgm_read_byte(_lut[i] + mag);
+#endif
+  } else {
+    out = _lut[i][mag];
+  }
+  if (out > 127) out = 127;
+  bool neg = (v < 0) != ((_invert >> i) & 1);
+  return neg ? (int8_t)-(int8_t)out : (int8_t)out;
+}
+
+// 0..131072 的整数平方根（逐位法）
+static uint16_t isqrt17(uint32_t v) {
+  uint32_t r = 0;
+  uint32_t bit = 1UL << 16;
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)r;
+}
+
+/*
+ * 函数: process
+ * 功能: 对一帧的 4 个原始摇杆值做中心校准、归一化、死区与响应曲线处理。
+ * 参数: raw - RX, RY, LX, LY（0..255）
+ * 返回值: 打包的 4 个 int8 输出（-127..127），第 i 轴位于 bit 8i..8i+7
+ */
+uint32_t PS2StickConditioner::process(const uint8_t raw[4]) {
+  int16_t v[4];   // 归一化后的有符号幅值（-255..255）
+  for (uint8_t i = 0; i < 4; ++i) {
+    int16_t d = (int16_t)raw[i] - (int16_t)_center[i];
+    if (_autoCenter && d >= -(int16_t)_window && d <= (int16_t)_window) {
+      // 静止附近才跟踪中心（约 32 帧时间常数），推杆时不会把中心拖走
+      int32_t q = (int32_t)_centerQ8[i];
+      q += (((int32_t)raw[i] << 8) - q) / 32;
+      _centerQ8[i] = (uint16_t)q;
+      uint8_t c = (uint8_t)((_centerQ8[i] + 128) >> 8);
+      if (c != _center[i]) {
+        _center[i] = c;
+        updateScale(i);
+        d = (int16_t)raw[i] - (int16_t)c;
+      }
+    }
+    uint16_t mag = (uint16_t)((d < 0) ? -d : d);
+    mag = (uint16_t)(((uint32_t)mag * ((d < 0) ? _scaleNeg[i] : _scalePos[i]) + 128) >> 8);
+    if (mag > 255) mag = 255;
+    v[i] = (d < 0) ? -(int16_t)mag : (int16_t)mag;
+  }
+
+  for (uint8_t s = 0; s < 2; ++s) {
+    uint8_t x = (uint8_t)(s * 2);
+    if (_radial & (1u << s)) {
+      // 径向死区：按合成幅值判断，死区外按比例缩放两轴（方向不变）
+      uint32_t r2 = (uint32_t)((int32_t)v[x] * v[x]) + (uint32_t)((int32_t)v[x + 1] * v[x + 1]);
+      uint16_t r = isqrt17(r2);
+      uint16_t rn = removeDeadzone(x, r);
+      if (rn == 0) {
+        v[x] = v[x + 1] = 0;
+      } else {
+        uint32_t k = ((uint32_t)rn << 8) / r;
+        for (uint8_t j = x; j < x + 2; ++j) {
+          uint16_t m = (uint16_t)((((uint32_t)((v[j] < 0) ? -v[j] : v[j])) * k + 128) >> 8);
+          if (m > 255) m = 255;
+          v[j] = (v[j] < 0) ? -(int16_t)m : (int16_t)m;
+        }
+      }
+    } else {
+      for (uint8_t j = x; j < x + 2; ++j) {
+        uint16_t m = removeDeadzone(j, (uint16_t)((v[j] < 0) ? -v[j] : v[j]));
+        v[j] = (v[j] < 0) ? -(int16_t)m : (int16_t)m;
+      }
+    }
+  }
+
+  uint32_t out = 0;
+  for (uint8_t i = 0; i < 4; ++i) {
+    out |= (uint32_t)(uint8_t)shape(i, v[i]) << (i * 8);
+  }
+  return out;
+}
@@ -0,0 +1,92 @@
+// YFPS2UARTStick.h
+// 摇杆调理：中心自动校准、轴向/径向死区、响应曲线查找表，输出 -127..127 的有符号值。
+// 每帧（update() 应用摇杆值时）计算一次，Stick() / PS2State::stick() 只读取结果；全部为整数运算，AVR 上不引入浮点。
+//
+// 处理顺序（每个轴）：
+//   1. 以当前中心为零点，负/正两侧分别按各自跨度归一化到 0..255 的幅值；
+//   2. 死区：轴向为逐轴判断，径向按同一摇杆两轴的合成幅值判断，死区外的部分重新拉伸到 0..255；
+//   3. 响应曲线：256 项查找表把幅值 0..255 映射为输出 0..127，未设置时为线性。
+//
+// 响应曲线可在编译期生成（constexpr，无运行时开销），也可在运行时填充：
+//   static const PS2Curve kExpo = ps2ExpoCurve(160);   // 编译期生成
+//   ps2.setStickCurve(&kExpo);
+// AVR 上可放入 PROGMEM 节省 RAM：
+//   static const PS2Curve kExpo PROGMEM = ps2ExpoCurve(160);
+//   ps2.setStickCurve(&kExpo, PS2_AXES_ALL, true);
+#ifndef YFPS2UART_STICK_H
+#define YFPS2UART_STICK_H
+
+#include <Arduino.h>
+
+// 轴掩码：bit i 对应 PSS_RX + i（RX, RY, LX, LY）
+#define PS2_AXIS_BIT(axis) ((uint8_t)(1u << ((axis) - PSS_RX)))
+#define PS2_AXES_RIGHT 0x03
+#define PS2_AXES_LEFT  0x0C
+#define PS2_AXES_ALL   0x0F
+
+// 死区类型
+#define PS2_DEADZONE_AXIAL  0   // 每个轴单独判断（十字形死区）
+#define PS2_DEADZONE_RADIAL 1   // 同一摇杆两轴合成幅值判断（圆形死区），需同时设置该摇杆的两个轴
+
+// 响应曲线：幅值 0..255 -> 输出 0..127
+struct PS2Curve {
+    uint8_t lut[256];
+};
+
+// 指数曲线上的一点：k = 0 为线性，k = 255 接近三次曲线；两端固定为 0 与 127
+constexpr uint8_t ps2ExpoPoint(uint16_t x, uint16_t k) {
+    return (uint8_t)((((uint32_t)x * (256 - k) + (uint32_t)x * x / 255 * x / 255 * k) / 256 * 127 + 127) / 255);
+}
+
+// 编译期生成 0..255 的下标序列（C++11 没有 std::index_sequence）
+template <uint8_t... I> struct PS2IndexSeq {};
+template <uint16_t N, uint8_t... I> struct PS2MakeIndexSeq : PS2MakeIndexSeq<N - 1, (uint8_t)(N - 1), I...> {};
+template <uint8_t... I> struct PS2MakeIndexSeq<0, I...> { typedef PS2IndexSeq<I...> type; };
+
+template <uint8_t... I>
+constexpr PS2Curve ps2ExpoCurve(uint8_t k, PS2IndexSeq<I...>) {
+    return PS2Curve{{ps2ExpoPoint(I, k)...}};
+}
+
+constexpr PS2Curve ps2ExpoCurve(uint8_t k) {
+    return ps2ExpoCurve(k, PS2MakeIndexSeq<256>::type());
+}
+
+// 运行时填充同一条曲线（例如由配置决定 k）
+void ps2FillExpoCurve(PS2Curve& curve, uint8_t k);
+
+// 四个轴的调理状态与参数，下标 0..3 对应 RX, RY, LX, LY
+class PS2StickConditioner {
+public:
+    PS2StickConditioner();
+
+    void setDeadzone(uint8_t dz, uint8_t mode, uint8_t axes);   // dz 为原始计数（0..127）
+    void setCurve(const PS2Curve* curve, uint8_t axes, bool inProgmem);
+    void setInvert(uint8_t axes);
+    void setAutoCenter(bool on, uint8_t window);
+    void setCenter(uint8_t i, uint8_t center);
+    uint8_t center(uint8_t i) const { return _center[i]; }
+
+    // 处理一帧原始值（RX, RY, LX, LY），返回打包的 4 个 int8 输出（bit 8i..8i+7 为第 i 轴）
+    uint32_t process(const uint8_t raw[4]);
+
+private:
+    uint16_t _centerQ8[4];   // 中心（Q8，自动校准时缓慢跟踪）
+    uint8_t _center[4];      // 取整后的中心
+    uint16_t _scaleNeg[4];   // 负侧归一化系数（Q8，255 / 跨度）
+    uint16_t _scalePos[4];   // 正侧归一化系数
+    uint8_t _dz[4];          // 死区（归一化幅值 0..254）
+    uint16_t _dzScale[4];    // 死区外拉伸系数（Q8，255 / (255 - dz)）
+    const uint8_t* _lut[4];  // 响应曲线（nullptr 表示线性）
+    uint8_t _lutFlash;       // 曲线位于 PROGMEM 的轴（仅 AVR）
+    uint8_t _radial;         // 径向死区：bit0 右摇杆，bit1 左摇杆
+    uint8_t _invert;         // 取反的轴
+    bool _autoCenter;
+    uint8_t _window;         // 自动校准只在原始值距中心不超过该值时跟踪
+
+    void updateScale(uint8_t i);
+    uint16_t removeDeadzone(uint8_t i, uint16_t mag) const;
+    int8_t shape(uint8_t i, int16_t v) const;
+};
+
+#endif // YFPS2UART_STICK_H
@@ -0,0 +1,40 @@
+// YFPS2UARTVibe.h
+// 非阻塞震动发送：queueVibrate() 只把请求放入 SPSC 队列，update() 在限速允许时合并排队请求并写入一个字节，
+// 不清空接收缓冲、不 flush。模块收到一条震动指令后震动约 0.5 秒，因此两次发送至少间隔
+// setVibrateIntervalMs()（默认 500ms），间隔内到达且已被正在进行的震动覆盖的请求直接丢弃。
+// 另有震动序列：playVibratePattern() 按步骤表依次发送，同样由 update() 推进，不使用 delay()。
+#ifndef YFPS2UART_VIBE_H
+#define YFPS2UART_VIBE_H
+
+#include <Arduino.h>
+
+// 震动请求队列容量（2 的幂）
+#ifndef YFPS2UART_VIBE_QUEUE_SIZE
+#if defined(__AVR__)
+#define YFPS2UART_VIBE_QUEUE_SIZE 4
+#else
+#define YFPS2UART_VIBE_QUEUE_SIZE 8
+#endif
+#endif
+
+// 模块单次震动的时长，也是默认的最小发送间隔
+#ifndef YFPS2UART_VIBE_INTERVAL_MS
+#define YFPS2UART_VIBE_INTERVAL_MS 500
+#endif
+
+// 震动序列中的一步：cmd 为 VIBRATE_BOTH/LEFT/RIGHT，或 0 表示停顿；
+// ms 为本步持续时间（到下一步开始），震动步为 0 时取发送间隔。
+// 例：左、停 200ms、右、双
+//   static const PS2VibeStep kPattern[] = {{VIBRATE_LEFT, 0}, {0, 200}, {VIBRATE_RIGHT, 0}, {VIBRATE_BOTH, 0}};
+struct PS2VibeStep {
+    uint8_t cmd;
+    uint16_t ms;
+};
+
+// 排队中的单次震动请求
+struct PS2VibeRequest {
+    uint32_t timeMs;   // 请求时间，用于判断是否已被当时正在进行的震动覆盖
+    uint8_t cmd;
+};
+
+#endif // YFPS2UART_VIBE_H